@@ -2,6 +2,12 @@
 [BITS 16]
 [ORG 0x7C00]
 
+; BIOS memory map handed to the kernel (read by init_memory in memory.c):
+; a dword entry count at MEMMAP_COUNT, then 24-byte E820 entries
+MEMMAP_COUNT   equ 0x5000
+MEMMAP_ENTRIES equ 0x5010
+MEMMAP_MAX     equ 32
+
 start:
     ; Setup segments
     xor ax, ax
@@ -39,6 +45,35 @@ start:
     int 0x13
     jc error
     
+    ; Load fifth 32KB (64 sectors) to 0x28000 (segment 0x2800:0x0000)
+    mov si, dap5        ; Point to fifth Disk Address Packet
+    mov ah, 0x42        ; Extended Read
+    mov dl, 0x80        ; Drive 0x80
+    int 0x13
+    jc error
+    
+    ; Collect the memory map with INT 15h, E820 (only possible in real mode).
+    ; A count of 0 tells the kernel to fall back to its fixed heap.
+    mov dword [MEMMAP_COUNT], 0
+    mov di, MEMMAP_ENTRIES
+    xor ebx, ebx        ; Continuation value, 0 for the first entry
+.e820_next:
+    mov eax, 0xE820
+    mov edx, 0x534D4150 ; 'SMAP'
+    mov ecx, 24
+    mov dword [di + 20], 1  ; Mark valid in case the BIOS returns 20 bytes
+    int 0x15
+    jc .e820_done       ; Carry: unsupported, or past the last entry
+    cmp eax, 0x534D4150
+    jne .e820_done
+    inc dword [MEMMAP_COUNT]
+    add di, 24
+    cmp dword [MEMMAP_COUNT], MEMMAP_MAX
+    jae .e820_done
+    test ebx, ebx       ; 0 means that was the last entry
+    jnz .e820_next
+.e820_done:
+    
     ; Switch to protected mode
     cli
     lgdt [gdt_descriptor]
@@ -135,5 +170,14 @@ dap4:
     dd 193              ; Starting LBA (sector 193, after first 192 sectors)
     dd 0                ; Upper 32-bits of LBA (0 for disks < 2TB)
 
+dap5:
+    db 0x10             ; Size of packet (16 bytes)
+    db 0                ; Reserved (0)
+    dw 64               ; Number of sectors to read (32KB)
+    dw 0x0000           ; Offset to load to
+    dw 0x2800           ; Segment to load to (0x2800:0x0000 = physical 0x28000)
+    dd 257              ; Starting LBA (sector 257, after first 256 sectors)
+    dd 0                ; Upper 32-bits of LBA (0 for disks < 2TB)
+
 times 510-($-$$) db 0
 dw 0xAA55
\ No newline at end of file
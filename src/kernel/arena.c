@@ -0,0 +1,189 @@
+/* Arena Allocator Implementation */
+
+#include "arena.h"
+#include "serial.h"
+
+/* Chunk size used when arena_create is given 0 */
+#define ARENA_DEFAULT_CHUNK 4096
+
+/* Arena allocations are aligned like malloc's */
+#define ARENA_ALIGN 16
+#define ARENA_ALIGN_UP(size) (((size) + (ARENA_ALIGN - 1)) & ~(size_t)(ARENA_ALIGN - 1))
+
+/* Live arenas, newest first */
+static Arena *arena_list = NULL;
+
+/* Take a chunk with at least size usable bytes from the heap */
+static ArenaChunk* arena_chunk_new(size_t size) {
+    ArenaChunk *chunk = (ArenaChunk*)malloc(sizeof(ArenaChunk) + size);
+    
+    if (!chunk) return NULL;
+    
+    chunk->next = NULL;
+    chunk->size = size;
+    chunk->used = 0;
+    return chunk;
+}
+
+/* Create an arena */
+Arena* arena_create(const char *name, size_t chunk_size) {
+    Arena *arena;
+    
+    if (chunk_size == 0) {
+        chunk_size = ARENA_DEFAULT_CHUNK;
+    }
+    
+    arena = (Arena*)malloc(sizeof(Arena));
+    if (!arena) {
+        serial_write_string("ERROR: Failed to allocate arena\n");
+        return NULL;
+    }
+    
+    arena->chunks = arena_chunk_new(ARENA_ALIGN_UP(chunk_size));
+    if (!arena->chunks) {
+        serial_write_string("ERROR: Failed to allocate arena chunk\n");
+        free(arena);
+        return NULL;
+    }
+    
+    arena->name = name;
+    arena->chunk_size = ARENA_ALIGN_UP(chunk_size);
+    arena->used = 0;
+    arena->high_water = 0;
+    arena->resets = 0;
+    
+    arena->next = arena_list;
+    arena_list = arena;
+    
+    return arena;
+}
+
+/* Allocate from the current chunk, starting a new one when it is full.
+ * Why chain chunks instead of failing: the caller sizes the first chunk
+ * for the common case, and an unusually big frame should still work. */
+void* arena_alloc(Arena *arena, size_t size) {
+    ArenaChunk *chunk;
+    void *result;
+    
+    if (!arena || size == 0) return NULL;
+    
+    size = ARENA_ALIGN_UP(size);
+    chunk = arena->chunks;
+    
+    if (chunk->size - chunk->used < size) {
+        chunk = arena_chunk_new(size > arena->chunk_size ? size : arena->chunk_size);
+        if (!chunk) {
+            serial_write_string("ERROR: Arena ");
+            serial_write_string(arena->name);
+            serial_write_string(" out of memory\n");
+            return NULL;
+        }
+        chunk->next = arena->chunks;
+        arena->chunks = chunk;
+    }
+    
+    result = (unsigned char*)(chunk + 1) + chunk->used;
+    chunk->used += size;
+    
+    arena->used += size;
+    if (arena->used > arena->high_water) {
+        arena->high_water = arena->used;
+    }
+    
+    return result;
+}
+
+/* Allocate zeroed memory */
+void* arena_calloc(Arena *arena, size_t size) {
+    void *result = arena_alloc(arena, size);
+    
+    if (result) {
+        memset(result, 0, size);
+    }
+    return result;
+}
+
+/* Discard everything, keeping the first chunk */
+void arena_reset(Arena *arena) {
+    ArenaChunk *chunk;
+    ArenaChunk *next;
+    
+    if (!arena) return;
+    
+    /* The original chunk is the last in the list */
+    chunk = arena->chunks;
+    while (chunk->next) {
+        next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    
+    chunk->used = 0;
+    arena->chunks = chunk;
+    arena->used = 0;
+    arena->resets++;
+}
+
+/* Return all of the arena's memory to the heap */
+void arena_destroy(Arena *arena) {
+    Arena **link;
+    ArenaChunk *chunk;
+    ArenaChunk *next;
+    
+    if (!arena) return;
+    
+    for (link = &arena_list; *link; link = &(*link)->next) {
+        if (*link == arena) {
+            *link = arena->next;
+            break;
+        }
+    }
+    
+    serial_write_string("Arena ");
+    serial_write_string(arena->name);
+    serial_write_string(" destroyed, high-water ");
+    serial_write_int(arena->high_water);
+    serial_write_string(" bytes\n");
+    
+    for (chunk = arena->chunks; chunk; chunk = next) {
+        next = chunk->next;
+        free(chunk);
+    }
+    free(arena);
+}
+
+/* Log every live arena's usage and high-water mark */
+void arena_report_stats(void) {
+    Arena *arena;
+    ArenaChunk *chunk;
+    size_t reserved;
+    int chunks;
+    
+    if (!arena_list) {
+        serial_write_string("Arenas: none\n");
+        return;
+    }
+    
+    for (arena = arena_list; arena; arena = arena->next) {
+        reserved = 0;
+        chunks = 0;
+        for (chunk = arena->chunks; chunk; chunk = chunk->next) {
+            reserved += chunk->size;
+            chunks++;
+        }
+        
+        serial_write_string("Arena ");
+        serial_write_string(arena->name);
+        serial_write_string(": ");
+        serial_write_int(arena->used);
+        serial_write_string(" bytes used, high-water ");
+        serial_write_int(arena->high_water);
+        serial_write_string(", ");
+        serial_write_int(reserved);
+        serial_write_string(" reserved in ");
+        serial_write_int(chunks);
+        serial_write_string(" chunks, ");
+        serial_write_int(arena->resets);
+        serial_write_string(" resets\n");
+    }
+}
@@ -0,0 +1,64 @@
+/* Arena Allocator
+ *
+ * DESIGN
+ * ------
+ * An arena hands out memory by bumping a pointer through chunks it takes
+ * from the heap, and gives it all back at once. Nothing allocated from an
+ * arena is freed individually - arena_reset() rewinds the first chunk and
+ * returns any others to the heap, and arena_destroy() returns them all.
+ * Either costs one free per chunk, however many allocations were made.
+ *
+ * This suits memory whose lifetime is a scope rather than an object: the
+ * temporary data of one frame, or everything a demo session builds (the
+ * layout demo's views live in one). The editor's pages never live in an
+ * arena, so resetting one can't touch them (unlike reset_heap()).
+ *
+ * Every arena is named and registered, so arena_report_stats() can log
+ * how much each one uses and its high-water mark over COM2.
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include "memory.h"
+
+/* A chunk of heap memory owned by an arena */
+typedef struct ArenaChunk {
+    struct ArenaChunk *next;    /* Older chunk */
+    size_t size;                /* Usable bytes after the header */
+    size_t used;                /* Bytes handed out from this chunk */
+    size_t reserved;            /* Pads the header to 16 bytes */
+} ArenaChunk;
+
+typedef struct Arena {
+    const char *name;           /* Shown in statistics */
+    ArenaChunk *chunks;         /* Current chunk first */
+    size_t chunk_size;          /* Size of chunks taken from the heap */
+    size_t used;                /* Bytes handed out since the last reset */
+    size_t high_water;          /* Most bytes ever in use at once */
+    unsigned int resets;        /* Times arena_reset() was called */
+    struct Arena *next;         /* Registry of live arenas */
+} Arena;
+
+/* Create an arena that takes memory from the heap chunk_size bytes at a
+ * time (0 selects a default). Returns NULL if out of memory. */
+Arena* arena_create(const char *name, size_t chunk_size);
+
+/* Allocate size bytes, 16-byte aligned and NOT zeroed.
+ * Returns NULL if the heap is out of memory. */
+void* arena_alloc(Arena *arena, size_t size);
+
+/* Allocate size bytes, zeroed */
+void* arena_calloc(Arena *arena, size_t size);
+
+/* Discard everything allocated from the arena. The first chunk is kept
+ * for reuse; any extra chunks go back to the heap. */
+void arena_reset(Arena *arena);
+
+/* Return all of the arena's memory to the heap and unregister it */
+void arena_destroy(Arena *arena);
+
+/* Log every live arena's usage and high-water mark to COM2 */
+void arena_report_stats(void);
+
+#endif /* ARENA_H */
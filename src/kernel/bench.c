@@ -0,0 +1,748 @@
+/* Microbenchmarks
+ *
+ * DESIGN
+ * ------
+ * Benchmarks are run from the editor with $bench-* commands and print
+ * their results to the COM2 debug port. Timing uses the CPU timestamp
+ * counter (get_cycles), so numbers are in CPU cycles rather than
+ * milliseconds - the 1ms timer tick is far too coarse for a keystroke.
+ *
+ * Each benchmark works on its own static scratch data so that running
+ * one never disturbs the pages the user is editing. Only the heap
+ * benchmark allocates, and it frees everything it takes.
+ */
+
+#include "bench.h"
+#include "page.h"
+#include "timer.h"
+#include "serial.h"
+#include "memory.h"
+#include "arena.h"
+#include "dispi.h"
+#include "dispi_init.h"
+#include "ui_demo.h"
+#include "layout_demo.h"
+#include "graphics.h"
+#include "simd.h"
+#include "paging.h"
+
+/* Page edit benchmark parameters.
+ * A page only holds PAGE_SIZE characters, so the 2,000 keystrokes are
+ * typed in batches: each batch starts from a page filled to within
+ * BENCH_EDIT_BATCH characters of capacity and types at its very start. */
+#define BENCH_EDIT_KEYSTROKES 2000
+#define BENCH_EDIT_BATCH 200
+#define BENCH_EDIT_FILL (PAGE_SIZE - 1 - BENCH_EDIT_BATCH)
+
+/* Cursor benchmark: every BENCH_CURSOR_STEP-th position of a full page */
+#define BENCH_CURSOR_STEP 7
+
+/* Heap benchmark: demo sessions to open and close after one warm-up */
+#define BENCH_HEAP_SESSIONS 20
+
+/* Arena benchmark: frames of small scratch allocations */
+#define BENCH_ARENA_FRAMES 50
+#define BENCH_ARENA_OBJECTS 200
+#define BENCH_ARENA_OBJECT_SIZE 48
+
+/* Memory bandwidth benchmark: a full 640x480 DISPI flip, and the row
+ * copies a dirty-rect flip makes (a 100-pixel wide button row and a
+ * full scanline) */
+#define BENCH_MEM_FLIP_BYTES (DISPI_WIDTH * DISPI_HEIGHT)
+#define BENCH_MEM_FLIP_REPEAT 10
+#define BENCH_MEM_ROW_REPEAT 2000
+
+/* Text benchmark: screens of 6x8 and 9x16 text per path */
+#define BENCH_TEXT_SCREENS 3
+
+/* Mode 12h text benchmark: screens of graphics demo text per path */
+#define BENCH_VGA_SCREENS 3
+
+/* Framebuffer mapping benchmark: full-screen flips per mapping */
+#define BENCH_FB_FLIPS 20
+
+/* SIMD benchmark: screen-sized passes per kernel and path */
+#define BENCH_SIMD_REPEAT 10
+#define BENCH_SIMD_KERNELS 5
+
+static char bench_flat_buffer[PAGE_SIZE];
+static char bench_gap_buffer[PAGE_SIZE];
+static PageLine bench_lines[PAGE_SIZE + 1];
+static Page bench_page;
+
+/* Point the scratch page at its static storage and empty it */
+static void bench_page_reset(void) {
+    bench_page.buffer = bench_gap_buffer;
+    bench_page.lines = bench_lines;
+    bench_page.line_capacity = PAGE_SIZE + 1;
+    page_clear(&bench_page);
+}
+
+/* Produce the filler text used to fill a benchmark page */
+static char bench_fill_char(int i) {
+    static const char line[] = "The quick brown fox jumps over the lazy dog.\n";
+    return line[i % (int)(sizeof(line) - 1)];
+}
+
+/* Insert the way the editor did before pages used a gap buffer:
+ * shift everything after the cursor up by one byte. */
+static void bench_flat_insert(char *buffer, int *length, int pos, char c) {
+    int i;
+    
+    for (i = *length; i > pos; i--) {
+        buffer[i] = buffer[i - 1];
+    }
+    buffer[pos] = c;
+    (*length)++;
+}
+
+/* Write "label: N cycles/<unit>" to the debug port */
+static void bench_report(const char *label, unsigned int cycles, int count,
+                         const char *unit) {
+    serial_write_string(label);
+    serial_write_int((int)(cycles / (unsigned int)count));
+    serial_write_string(" cycles/");
+    serial_write_string(unit);
+    serial_write_string("\n");
+}
+
+/* Write "  speedup: N.Nx" for a slow and a fast cycle count */
+static void bench_report_speedup(unsigned int slow_cycles, unsigned int fast_cycles) {
+    /* Speedup in tenths */
+    unsigned int speedup = fast_cycles >= 10 ? slow_cycles / (fast_cycles / 10) : 0;
+    
+    serial_write_string("  speedup: ");
+    serial_write_int((int)(speedup / 10));
+    serial_write_string(".");
+    serial_write_int((int)(speedup % 10));
+    serial_write_string("x\n");
+}
+
+/* Type 2,000 characters at the start of a nearly full page */
+void bench_page_edit(void) {
+    unsigned int flat_cycles = 0;
+    unsigned int gap_cycles = 0;
+    unsigned int start;
+    int flat_length;
+    int batch;
+    int i;
+    char c;
+    
+    for (batch = 0; batch < BENCH_EDIT_KEYSTROKES / BENCH_EDIT_BATCH; batch++) {
+        /* Before: flat buffer, every keystroke shifts the whole page */
+        for (flat_length = 0; flat_length < BENCH_EDIT_FILL; flat_length++) {
+            bench_flat_buffer[flat_length] = bench_fill_char(flat_length);
+        }
+        start = get_cycles();
+        for (i = 0; i < BENCH_EDIT_BATCH; i++) {
+            bench_flat_insert(bench_flat_buffer, &flat_length, i, 'a' + (i % 26));
+        }
+        flat_cycles += get_cycles() - start;
+        
+        /* After: gap buffer. The fill leaves the gap at the end of the
+         * page, so the first keystroke pays for moving it to the start,
+         * exactly as when the user jumps there and starts typing. */
+        bench_page_reset();
+        for (i = 0; i < BENCH_EDIT_FILL; i++) {
+            c = bench_fill_char(i);
+            page_insert(&bench_page, i, &c, 1);
+        }
+        start = get_cycles();
+        for (i = 0; i < BENCH_EDIT_BATCH; i++) {
+            c = 'a' + (i % 26);
+            page_insert(&bench_page, i, &c, 1);
+        }
+        gap_cycles += get_cycles() - start;
+    }
+    
+    serial_write_string("Page edit benchmark: ");
+    serial_write_int(BENCH_EDIT_KEYSTROKES);
+    serial_write_string(" keystrokes at start of a ");
+    serial_write_int(BENCH_EDIT_FILL);
+    serial_write_string("-char page\n");
+    bench_report("  before (shifting buffer): ", flat_cycles,
+                 BENCH_EDIT_KEYSTROKES, "keystroke");
+    bench_report("  after (gap buffer):       ", gap_cycles,
+                 BENCH_EDIT_KEYSTROKES, "keystroke");
+}
+
+/* Screen offset of a position the way update_cursor used to find it:
+ * walk the whole page from the top expanding newlines and tabs */
+static int bench_scan_screen_offset(const char *buffer, int pos) {
+    int screen_pos = 0;
+    int i;
+    
+    for (i = 0; i < pos; i++) {
+        if (buffer[i] == '\n') {
+            screen_pos += VGA_WIDTH - (screen_pos % VGA_WIDTH);
+        } else if (buffer[i] == '\t') {
+            screen_pos += PAGE_TAB_WIDTH;
+        } else {
+            screen_pos++;
+        }
+    }
+    return screen_pos;
+}
+
+/* Line start of a position found by walking backwards to a newline */
+static int bench_scan_line_start(const char *buffer, int pos) {
+    while (pos > 0 && buffer[pos - 1] != '\n') {
+        pos--;
+    }
+    return pos;
+}
+
+/* Line end of a position found by walking forwards to a newline */
+static int bench_scan_line_end(const char *buffer, int length, int pos) {
+    while (pos < length && buffer[pos] != '\n') {
+        pos++;
+    }
+    return pos;
+}
+
+/* Cursor lookups and vertical motion on a full page of short lines */
+void bench_cursor_motion(void) {
+    static const char line[] = "\tif (page->cursor_pos > 0) {\n";
+    unsigned int scan_offset = 0, index_offset = 0;
+    unsigned int scan_vertical = 0, index_vertical = 0;
+    unsigned int start;
+    volatile int sink = 0;
+    int length = PAGE_SIZE - 1;
+    int samples = 0;
+    int pos;
+    int line_no;
+    int line_start;
+    int i;
+    
+    /* Same text in a flat buffer and in the gap-buffered scratch page */
+    bench_page_reset();
+    for (i = 0; i < length; i++) {
+        bench_flat_buffer[i] = line[i % (int)(sizeof(line) - 1)];
+    }
+    page_insert(&bench_page, 0, bench_flat_buffer, length);
+    
+    for (pos = 0; pos <= length; pos += BENCH_CURSOR_STEP) {
+        samples++;
+        
+        /* Row/column lookup (update_cursor) */
+        start = get_cycles();
+        sink += bench_scan_screen_offset(bench_flat_buffer, pos);
+        scan_offset += get_cycles() - start;
+        
+        start = get_cycles();
+        sink += page_screen_offset(&bench_page, pos);
+        index_offset += get_cycles() - start;
+        
+        /* Vertical motion needs the current line and both neighbours
+         * (move_cursor_up/move_cursor_down) */
+        start = get_cycles();
+        line_start = bench_scan_line_start(bench_flat_buffer, pos);
+        if (line_start > 0) {
+            sink += bench_scan_line_start(bench_flat_buffer, line_start - 1);
+        }
+        i = bench_scan_line_end(bench_flat_buffer, length, pos);
+        if (i < length) {
+            sink += bench_scan_line_end(bench_flat_buffer, length, i + 1);
+        }
+        scan_vertical += get_cycles() - start;
+        
+        start = get_cycles();
+        line_no = page_line_of(&bench_page, pos);
+        if (line_no > 0) {
+            sink += page_line_start(&bench_page, line_no - 1);
+        }
+        if (line_no + 1 < bench_page.line_count) {
+            sink += page_line_end(&bench_page, line_no + 1);
+        }
+        index_vertical += get_cycles() - start;
+    }
+    (void)sink;
+    
+    serial_write_string("Cursor benchmark: ");
+    serial_write_int(samples);
+    serial_write_string(" positions on a page of ");
+    serial_write_int(bench_page.line_count);
+    serial_write_string(" lines\n");
+    bench_report("  row/col before (page scan):  ", scan_offset, samples, "lookup");
+    bench_report("  row/col after (line index):  ", index_offset, samples, "lookup");
+    bench_report("  up/down before (line scans): ", scan_vertical, samples, "move");
+    bench_report("  up/down after (line index):  ", index_vertical, samples, "move");
+}
+
+/* One demo session's worth of allocations: the DISPI backbuffer is taken
+ * first and released last, as dispi_graphics_init/cleanup do, with the
+ * demo's object graph built and destroyed in between */
+static int bench_heap_session(void) {
+    unsigned char *backbuffer;
+    
+    backbuffer = (unsigned char*)malloc(DISPI_WIDTH * DISPI_HEIGHT);
+    if (!backbuffer) return 0;
+    ui_demo_alloc_cycle();
+    free(backbuffer);
+    
+    backbuffer = (unsigned char*)malloc(DISPI_WIDTH * DISPI_HEIGHT);
+    if (!backbuffer) return 0;
+    layout_demo_alloc_cycle();
+    free(backbuffer);
+    
+    return 1;
+}
+
+/* Open and close the UI and layout demos repeatedly and check that the
+ * heap ends where it started */
+void bench_heap_stress(void) {
+    size_t used_before;
+    size_t footprint_warm;
+    unsigned int start;
+    unsigned int cycles;
+    int i;
+    
+    used_before = get_heap_used();
+    
+    /* The first session may leave empty slabs pooled; later ones must
+     * reuse them rather than grow the heap */
+    if (!bench_heap_session()) {
+        serial_write_string("Heap bench: out of memory in warm-up\n");
+        return;
+    }
+    footprint_warm = get_heap_footprint();
+    
+    start = get_cycles();
+    for (i = 0; i < BENCH_HEAP_SESSIONS; i++) {
+        if (!bench_heap_session()) {
+            serial_write_string("Heap bench: out of memory in session ");
+            serial_write_int(i);
+            serial_write_string("\n");
+            break;
+        }
+    }
+    cycles = get_cycles() - start;
+    
+    serial_write_string("Heap bench: ");
+    serial_write_int(i);
+    serial_write_string(" sessions, ");
+    bench_report("", cycles, i > 0 ? i : 1, "session");
+    
+    serial_write_string("Heap bench: in use ");
+    serial_write_int(used_before);
+    serial_write_string(" -> ");
+    serial_write_int(get_heap_used());
+    serial_write_string(" bytes, footprint ");
+    serial_write_int(footprint_warm);
+    serial_write_string(" -> ");
+    serial_write_int(get_heap_footprint());
+    serial_write_string(" bytes");
+    if (get_heap_used() == used_before && get_heap_footprint() <= footprint_warm) {
+        serial_write_string(" (no growth)\n");
+    } else {
+        serial_write_string(" (LEAK)\n");
+    }
+    
+    memory_report_stats();
+}
+
+/* Compare a frame's worth of small scratch allocations freed one by one
+ * with the same allocations from an arena dropped by arena_reset */
+void bench_arena_frames(void) {
+    static void *objects[BENCH_ARENA_OBJECTS];
+    Arena *arena;
+    unsigned int start;
+    unsigned int heap_cycles = 0;
+    unsigned int arena_cycles = 0;
+    int frame;
+    int i;
+    
+    arena = arena_create("bench-frame", 0);
+    if (!arena) return;
+    
+    for (frame = 0; frame < BENCH_ARENA_FRAMES; frame++) {
+        start = get_cycles();
+        for (i = 0; i < BENCH_ARENA_OBJECTS; i++) {
+            objects[i] = malloc(BENCH_ARENA_OBJECT_SIZE);
+        }
+        for (i = 0; i < BENCH_ARENA_OBJECTS; i++) {
+            free(objects[i]);
+        }
+        heap_cycles += get_cycles() - start;
+        
+        start = get_cycles();
+        for (i = 0; i < BENCH_ARENA_OBJECTS; i++) {
+            objects[i] = arena_alloc(arena, BENCH_ARENA_OBJECT_SIZE);
+        }
+        arena_reset(arena);
+        arena_cycles += get_cycles() - start;
+    }
+    
+    bench_report("Frame scratch, malloc/free: ", heap_cycles, BENCH_ARENA_FRAMES, "frame");
+    bench_report("Frame scratch, arena:       ", arena_cycles, BENCH_ARENA_FRAMES, "frame");
+    arena_report_stats();
+    arena_destroy(arena);
+}
+
+/* Copy the way memcpy did before: one byte per loop iteration */
+static void bench_byte_copy(unsigned char *dst, const unsigned char *src,
+                            size_t n) {
+    size_t i;
+    
+    for (i = 0; i < n; i++) {
+        dst[i] = src[i];
+    }
+}
+
+/* Time repeat copies of n bytes with the byte loop and with memcpy,
+ * starting at the given offset into both buffers */
+static void bench_copy_size(const char *label, unsigned char *dst,
+                            const unsigned char *src, size_t n,
+                            size_t offset, int repeat) {
+    unsigned int start;
+    unsigned int byte_cycles;
+    unsigned int copy_cycles;
+    int i;
+    
+    start = get_cycles();
+    for (i = 0; i < repeat; i++) {
+        bench_byte_copy(dst + offset, src + offset, n);
+    }
+    byte_cycles = get_cycles() - start;
+    
+    start = get_cycles();
+    for (i = 0; i < repeat; i++) {
+        memcpy(dst + offset, src + offset, n);
+    }
+    copy_cycles = get_cycles() - start;
+    
+    serial_write_string(label);
+    serial_write_int(n);
+    serial_write_string(" bytes\n");
+    bench_report("  byte loop: ", byte_cycles, repeat, "copy");
+    bench_report("  memcpy:    ", copy_cycles, repeat, "copy");
+    if (memcmp(dst + offset, src + offset, n) != 0) {
+        serial_write_string("  ERROR: memcpy result differs from source\n");
+    }
+}
+
+/* Measure copy and fill bandwidth for flip-sized and row-sized blocks,
+ * and check memmove on overlapping regions */
+void bench_memory_bandwidth(void) {
+    unsigned char *src;
+    unsigned char *dst;
+    unsigned int start;
+    unsigned int cycles;
+    int i;
+    
+    src = (unsigned char*)malloc(BENCH_MEM_FLIP_BYTES);
+    dst = (unsigned char*)malloc(BENCH_MEM_FLIP_BYTES);
+    if (!src || !dst) {
+        serial_write_string("Memory bench: out of memory\n");
+        free(src);
+        free(dst);
+        return;
+    }
+    
+    for (i = 0; i < BENCH_MEM_FLIP_BYTES; i++) {
+        src[i] = (unsigned char)(i * 7);
+    }
+    
+    bench_copy_size("Full flip: ", dst, src, BENCH_MEM_FLIP_BYTES, 0,
+                    BENCH_MEM_FLIP_REPEAT);
+    /* Dirty rects rarely start on a dword boundary */
+    bench_copy_size("Dirty row: ", dst, src, 100, 3, BENCH_MEM_ROW_REPEAT);
+    bench_copy_size("Scanline:  ", dst, src, DISPI_WIDTH, 0, BENCH_MEM_ROW_REPEAT);
+    
+    start = get_cycles();
+    for (i = 0; i < BENCH_MEM_FLIP_REPEAT; i++) {
+        memset(dst, i, BENCH_MEM_FLIP_BYTES);
+    }
+    cycles = get_cycles() - start;
+    serial_write_string("Full clear: ");
+    bench_report("memset ", cycles, BENCH_MEM_FLIP_REPEAT, "fill");
+    
+    /* Shift by one byte both ways, as page_move_gap does */
+    memcpy(dst, src, BENCH_MEM_FLIP_BYTES);
+    start = get_cycles();
+    memmove(dst + 1, dst, BENCH_MEM_FLIP_BYTES - 1);
+    memmove(dst, dst + 1, BENCH_MEM_FLIP_BYTES - 1);
+    cycles = get_cycles() - start;
+    serial_write_string("Overlapping: ");
+    bench_report("memmove ", cycles, 2, "move");
+    if (dst[0] != src[0] || memcmp(dst + 1, src, BENCH_MEM_FLIP_BYTES - 1) != 0) {
+        serial_write_string("  ERROR: memmove result is wrong\n");
+    }
+    
+    free(src);
+    free(dst);
+}
+
+/* Fill the 640x480 screen with characters of one font, returning cycles */
+static unsigned int bench_text_screen(int bios_font, int pass) {
+    unsigned int start;
+    int char_w = bios_font ? 9 : 6;
+    int char_h = bios_font ? 16 : 8;
+    int x, y;
+    unsigned char c = (unsigned char)('!' + pass);
+    
+    start = get_cycles();
+    for (y = 0; y + char_h <= DISPI_HEIGHT; y += char_h) {
+        for (x = 0; x + char_w <= DISPI_WIDTH; x += char_w) {
+            if (bios_font) {
+                dispi_draw_char_bios(x, y, c, 5, 1);
+            } else {
+                dispi_draw_char(x, y, c, 5, 1);
+            }
+            if (++c > '~') c = '!';
+        }
+    }
+    return get_cycles() - start;
+}
+
+/* Time full screens of text drawn per pixel and from the glyph atlas */
+static void bench_text_font(const char *label, int bios_font) {
+    unsigned int pixel_cycles = 0;
+    unsigned int atlas_cycles = 0;
+    int i;
+    
+    /* Build the atlas outside the timed loop */
+    dispi_set_glyph_cache(1);
+    bench_text_screen(bios_font, 0);
+    
+    for (i = 0; i < BENCH_TEXT_SCREENS; i++) {
+        dispi_set_glyph_cache(0);
+        pixel_cycles += bench_text_screen(bios_font, i);
+        dispi_flip_buffers();
+        
+        dispi_set_glyph_cache(1);
+        atlas_cycles += bench_text_screen(bios_font, i);
+        dispi_flip_buffers();
+    }
+    
+    serial_write_string(label);
+    serial_write_string("\n");
+    bench_report("  per pixel:   ", pixel_cycles, BENCH_TEXT_SCREENS, "screen");
+    bench_report("  glyph atlas: ", atlas_cycles, BENCH_TEXT_SCREENS, "screen");
+    bench_report_speedup(pixel_cycles, atlas_cycles);
+}
+
+/* Fill the DISPI screen with 6x8 and 9x16 text, per pixel and with the
+ * glyph atlas. Switches to graphics mode for the duration. */
+void bench_text_render(void) {
+    if (!dispi_graphics_init()) {
+        serial_write_string("Text bench: DISPI graphics unavailable\n");
+        return;
+    }
+    
+    bench_text_font("Text 6x8, full screen:", 0);
+    bench_text_font("Text 9x16 (BIOS font), full screen:", 1);
+    
+    dispi_graphics_cleanup(NULL);
+}
+
+/* Fill the mode 12h screen the way the graphics demo draws text: lines
+ * of opaque 9-pixel BIOS font text, each with transparent 6x8 text over
+ * its lower half. Returns cycles. */
+static unsigned int bench_vga_text_screen(int pass) {
+    static const char line[] =
+        "The quick brown fox jumps over the lazy dog 0123456789 !@#$%^&*()[]";
+    unsigned int start;
+    int y;
+    
+    start = get_cycles();
+    for (y = 0; y + CHAR_HEIGHT <= VGA_HEIGHT_12H; y += LINE_SPACING) {
+        draw_text_spaced(pass & 7, y, line, 5, 1, CHAR_WIDTH_NORMAL);
+        draw_string_6x8(pass & 7, y + 8, line, 14, COLOR_TRANSPARENT);
+    }
+    return get_cycles() - start;
+}
+
+/* Draw mode 12h text per pixel and in write mode 3. Switches to VGA
+ * mode 12h for the duration, like $graphics. */
+void bench_vga_text(void) {
+    unsigned int pixel_cycles = 0;
+    unsigned int planar_cycles = 0;
+    int i;
+    
+    save_vga_font();
+    set_mode_12h();
+    set_aquinas_palette();
+    clear_graphics_screen(0);
+    
+    for (i = 0; i < BENCH_VGA_SCREENS; i++) {
+        graphics_set_planar_text(0);
+        pixel_cycles += bench_vga_text_screen(i);
+    
+        graphics_set_planar_text(1);
+        planar_cycles += bench_vga_text_screen(i);
+    }
+    
+    set_mode_03h();
+    restore_vga_font();
+    restore_dac_palette();
+    
+    serial_write_string("Mode 12h text, full screen:\n");
+    bench_report("  per pixel:    ", pixel_cycles, BENCH_VGA_SCREENS, "screen");
+    bench_report("  write mode 3: ", planar_cycles, BENCH_VGA_SCREENS, "screen");
+    bench_report_speedup(pixel_cycles, planar_cycles);
+}
+
+/* Run one pixel kernel over a 640x480 buffer, the way the DISPI driver
+ * uses it, and return cycles */
+static unsigned int bench_simd_pass(int kernel, unsigned char *dst,
+                                    const unsigned char *src) {
+    static const unsigned char pattern[8] = { 15, 0, 0, 15, 15, 0, 0, 15 };
+    static const unsigned int mask[4] = { 0xFF0000FFU, 0x00FF00FFU, 0x000000FFU, 0 };
+    static const unsigned int extent[4] = { 0xFFFFFFFFU, 0xFFFFFFFFU, 0x000000FFU, 0 };
+    unsigned int start;
+    int row, x;
+    
+    start = get_cycles();
+    switch (kernel) {
+        case 0:     /* Full flip */
+            simd_copy(dst, src, BENCH_MEM_FLIP_BYTES);
+            break;
+        case 1:     /* Clear screen */
+            simd_fill(dst, 3, BENCH_MEM_FLIP_BYTES);
+            break;
+        case 2:     /* 200-pixel rectangle rows, unaligned like most rects */
+            for (row = 0; row < DISPI_HEIGHT; row++) {
+                simd_fill(dst + row * DISPI_WIDTH + 3, 7, 200);
+            }
+            break;
+        case 3:     /* Full-width pattern fill */
+            for (row = 0; row < DISPI_HEIGHT; row++) {
+                simd_fill_pattern8(dst + row * DISPI_WIDTH, pattern, DISPI_WIDTH);
+            }
+            break;
+        default:    /* Opaque 9-pixel glyph rows across every scanline */
+            for (row = 0; row < DISPI_HEIGHT; row++) {
+                for (x = 0; x + 16 <= DISPI_WIDTH; x += 9) {
+                    simd_glyph_row16(dst + row * DISPI_WIDTH + x, mask, extent,
+                                     5 * 0x01010101U, 1 * 0x01010101U, 0);
+                }
+            }
+            break;
+    }
+    return get_cycles() - start;
+}
+
+/* Time each pixel kernel scalar and, when available, with SSE2 */
+void bench_simd_kernels(void) {
+    static const char *labels[BENCH_SIMD_KERNELS] = {
+        "Flip copy:", "Clear:", "Rect fill rows:", "Pattern fill:", "Glyph rows:"
+    };
+    unsigned char *src;
+    unsigned char *dst;
+    unsigned int scalar_cycles;
+    unsigned int sse2_cycles;
+    int previous;
+    int kernel, i;
+    
+    src = (unsigned char*)malloc(BENCH_MEM_FLIP_BYTES);
+    dst = (unsigned char*)malloc(BENCH_MEM_FLIP_BYTES);
+    if (!src || !dst) {
+        serial_write_string("SIMD bench: out of memory\n");
+        free(src);
+        free(dst);
+        return;
+    }
+    memset(src, 0x5A, BENCH_MEM_FLIP_BYTES);
+    memset(dst, 0, BENCH_MEM_FLIP_BYTES);
+    
+    if (!simd_sse2_available()) {
+        serial_write_string("SSE2 kernels unavailable (build with SSE2=1 on an SSE2 CPU); scalar only\n");
+    }
+    
+    previous = simd_set_sse2(0);
+    for (kernel = 0; kernel < BENCH_SIMD_KERNELS; kernel++) {
+        scalar_cycles = 0;
+        sse2_cycles = 0;
+        for (i = 0; i < BENCH_SIMD_REPEAT; i++) {
+            simd_set_sse2(0);
+            scalar_cycles += bench_simd_pass(kernel, dst, src);
+            if (simd_sse2_available()) {
+                simd_set_sse2(1);
+                sse2_cycles += bench_simd_pass(kernel, dst, src);
+            }
+        }
+    
+        serial_write_string(labels[kernel]);
+        serial_write_string("\n");
+        bench_report("  scalar: ", scalar_cycles, BENCH_SIMD_REPEAT, "screen");
+        if (simd_sse2_available()) {
+            bench_report("  SSE2:   ", sse2_cycles, BENCH_SIMD_REPEAT, "screen");
+            bench_report_speedup(scalar_cycles, sse2_cycles);
+        }
+    }
+    simd_set_sse2(previous);
+    
+    free(src);
+    free(dst);
+}
+
+    
+/* Copy a frame from the heap to the shown page BENCH_FB_FLIPS times,
+ * alternating two images so every store changes the screen. Returns
+ * cycles. */
+static unsigned int bench_fb_flips(unsigned char *fb, unsigned char *frames) {
+    unsigned int start;
+    int i;
+    
+    start = get_cycles();
+    for (i = 0; i < BENCH_FB_FLIPS; i++) {
+        simd_copy(fb, frames + (i & 1) * BENCH_MEM_FLIP_BYTES, BENCH_MEM_FLIP_BYTES);
+    }
+    return get_cycles() - start;
+}
+
+/* Time full-screen flips into the framebuffer mapped with the MTRR
+ * default type (uncached) and write-combining. Switches to graphics mode
+ * for the duration. */
+void bench_framebuffer_mapping(void) {
+    unsigned char *frames;
+    unsigned char *fb;
+    unsigned int uncached_cycles;
+    unsigned int wc_cycles;
+    int previous;
+    
+    if (!paging_has_pat()) {
+        serial_write_string("Framebuffer bench: no PAT, write-combining unavailable\n");
+        return;
+    }
+    
+    frames = (unsigned char*)malloc(2 * BENCH_MEM_FLIP_BYTES);
+    if (!frames) {
+        serial_write_string("Framebuffer bench: out of memory\n");
+        return;
+    }
+    memset(frames, 1, BENCH_MEM_FLIP_BYTES);
+    memset(frames + BENCH_MEM_FLIP_BYTES, 9, BENCH_MEM_FLIP_BYTES);
+    
+    if (!dispi_graphics_init()) {
+        serial_write_string("Framebuffer bench: DISPI graphics unavailable\n");
+        free(frames);
+        return;
+    }
+    fb = dispi_get_framebuffer();
+    previous = dispi_is_write_combining();
+    
+    if (!dispi_set_write_combining(0)) {
+        serial_write_string("Framebuffer bench: could not change the mapping\n");
+        dispi_graphics_cleanup(NULL);
+        free(frames);
+        return;
+    }
+    bench_fb_flips(fb, frames);     /* Warm up */
+    uncached_cycles = bench_fb_flips(fb, frames);
+    
+    dispi_set_write_combining(1);
+    bench_fb_flips(fb, frames);
+    wc_cycles = bench_fb_flips(fb, frames);
+    
+    dispi_set_write_combining(previous);
+    dispi_graphics_cleanup(NULL);
+    free(frames);
+    
+    serial_write_string("Full-screen flip to the framebuffer:\n");
+    bench_report("  uncached:        ", uncached_cycles, BENCH_FB_FLIPS, "flip");
+    bench_report("  write-combining: ", wc_cycles, BENCH_FB_FLIPS, "flip");
+    bench_report_speedup(uncached_cycles, wc_cycles);
+}
+    
\ No newline at end of file
@@ -0,0 +1,46 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+/* Microbenchmarks
+ * Each benchmark runs against private scratch data (never the user's
+ * pages) and reports cycle counts over the COM2 debug port.
+ */
+
+/* Type 2,000 characters at the start of a nearly full page, comparing
+ * the old shift-everything insert with the gap buffer */
+void bench_page_edit(void);
+
+/* Time cursor row/column lookups and up/down motion over a full page,
+ * comparing text rescans with the page line index */
+void bench_cursor_motion(void);
+
+/* Open and close the UI and layout demos' object graphs (plus a DISPI
+ * backbuffer) repeatedly and report time per session and heap growth */
+void bench_heap_stress(void);
+
+/* Time a frame of small scratch allocations with malloc/free against an
+ * arena that is reset once per frame */
+void bench_arena_frames(void);
+
+/* Time flip-sized and row-sized copies with memcpy against a byte loop,
+ * plus full-screen memset and overlapping memmove */
+void bench_memory_bandwidth(void);
+
+/* Switch to DISPI graphics and time filling the screen with 6x8 and 9x16
+ * text per pixel against the glyph atlas */
+void bench_text_render(void);
+
+/* Switch to VGA mode 12h and time the graphics demo's text drawn per
+ * pixel against the write mode 3 glyph routines */
+void bench_vga_text(void);
+
+/* Time the pixel kernels (flip copy, clear, rectangle fill, pattern fill
+ * and glyph rows) over screen-sized heap buffers, scalar against SSE2
+ * when the SSE2 build runs on a CPU that has it */
+void bench_simd_kernels(void);
+
+/* Switch to DISPI graphics and time full-screen copies to the
+ * framebuffer mapped uncached against write-combining */
+void bench_framebuffer_mapping(void);
+
+#endif /* BENCH_H */
@@ -8,6 +8,11 @@
 #include "dispi_demo.h"
 #include "layout_demo.h"
 #include "ui_demo.h"
+#include "bench.h"
+#include "memory.h"
+#include "arena.h"
+#include "frame_pacer.h"
+#include "input_irq.h"
 
 /* Helper function to check if command matches a string */
 static int command_matches(const char *cmd_name, int cmd_len, const char *target) {
@@ -44,16 +49,14 @@ void execute_command(Page* page, int cmd_start, int cmd_end) {
     int output_len;
     rtc_time_t now;
     int space_after;
-    int visual_space_count;
-    int scan_pos;
-    int col;
+    int space_count;
     
     /* Extract command name */
     cmd_len = cmd_end - cmd_start;
     if (cmd_len >= 32) cmd_len = 31;
     
     for (i = 0; i < cmd_len; i++) {
-        cmd_name[i] = page->buffer[cmd_start + i];
+        cmd_name[i] = page_char_at(page, cmd_start + i);
     }
     cmd_name[cmd_len] = '\0';
     
@@ -119,89 +122,42 @@ void execute_command(Page* page, int cmd_start, int cmd_end) {
         
         /* Check if there's already a space after the command */
         space_after = 0;
-        if (insert_pos < page->length && page->buffer[insert_pos] == ' ') {
+        if (insert_pos < page->length && page_char_at(page, insert_pos) == ' ') {
             space_after = 1;
             insert_pos++;  /* Skip the existing space */
         }
         
-        /* Count visual whitespace after command position */
-        visual_space_count = 0;
-        scan_pos = insert_pos;
-        col = 0;
-        
-        /* Calculate column position of insert_pos */
-        for (i = 0; i < insert_pos && i < page->length; i++) {
-            if (page->buffer[i] == '\n') {
-                col = 0;
-            } else if (page->buffer[i] == '\t') {
-                col += 2;
-            } else {
-                col++;
-            }
-        }
+        /* Add space to output to separate from following text */
+        output[output_len++] = ' ';
         
-        /* Count spaces until we hit non-whitespace or newline */
-        while (scan_pos < page->length && visual_space_count < output_len) {
-            if (page->buffer[scan_pos] == ' ') {
-                visual_space_count++;
-                scan_pos++;
-                col++;
-            } else if (page->buffer[scan_pos] == '\n') {
-                /* Count remaining columns in the line as available space */
-                while (col < VGA_WIDTH && visual_space_count < output_len) {
-                    visual_space_count++;
-                    col++;
-                }
-                break;
-            } else {
-                /* Hit non-whitespace character */
-                break;
-            }
+        /* Count spaces after the insert position that the output can
+         * overwrite. Why: reusing existing whitespace keeps text further
+         * along the line where the user put it. */
+        space_count = 0;
+        while (insert_pos + space_count < page->length &&
+               space_count < output_len &&
+               page_char_at(page, insert_pos + space_count) == ' ') {
+            space_count++;
         }
         
-        /* Check if we have enough room */
-        if (page->length + output_len + 1 - visual_space_count >= PAGE_SIZE) {
+        /* Check if we have enough room for the bytes that must be added */
+        if (page->length + output_len + (space_after ? 0 : 1) - space_count >= PAGE_SIZE) {
             serial_write_string("Not enough space for command output\n");
             return;
         }
         
-        /* Add space to output to separate from following text */
-        output[output_len++] = ' ';
+        /* Insert space before output if not already there */
+        if (!space_after) {
+            page_insert(page, cmd_end, " ", 1);
+            insert_pos = cmd_end + 1;
+        }
         
-        /* If we have enough visual space, overwrite it */
-        if (visual_space_count >= output_len) {
-            /* Just overwrite the spaces */
-            for (i = 0; i < output_len; i++) {
-                page->buffer[insert_pos + i] = output[i];
-            }
-        } else {
-            /* Need to make room - shift text right */
-            int shift_amount = output_len - visual_space_count;
-            
-            /* Add space before output if not already there */
-            if (!space_after) {
-                shift_amount++;  /* Need one more byte for the space */
-            }
-            
-            /* Shift existing text to make room */
-            for (i = page->length - 1; i >= insert_pos + visual_space_count; i--) {
-                page->buffer[i + shift_amount] = page->buffer[i];
-            }
-            
-            /* Insert space if needed */
-            if (!space_after) {
-                page->buffer[cmd_end] = ' ';
-                insert_pos = cmd_end + 1;
-            }
-            
-            /* Insert the output */
-            for (i = 0; i < output_len; i++) {
-                page->buffer[insert_pos + i] = output[i];
-            }
-            
-            /* Update page length */
-            page->length += shift_amount;
+        /* Overwrite the available spaces, then insert whatever is left */
+        for (i = 0; i < space_count; i++) {
+            page_set_char(page, insert_pos + i, output[i]);
         }
+        page_insert(page, insert_pos + space_count, output + space_count,
+                    output_len - space_count);
         
         /* Clear highlight after command execution */
         page->highlight_start = 0;
@@ -217,16 +173,16 @@ void execute_command(Page* page, int cmd_start, int cmd_end) {
         int j;
         
         /* Skip any spaces after $rename */
-        while (name_start < page->length && page->buffer[name_start] == ' ') {
+        while (name_start < page->length && page_char_at(page, name_start) == ' ') {
             name_start++;
         }
         
         /* Find the end of the name (next space or newline) */
         name_end = name_start;
         while (name_end < page->length && 
-               page->buffer[name_end] != ' ' && 
-               page->buffer[name_end] != '\n' &&
-               page->buffer[name_end] != '\t') {
+               page_char_at(page, name_end) != ' ' && 
+               page_char_at(page, name_end) != '\n' &&
+               page_char_at(page, name_end) != '\t') {
             name_end++;
         }
         
@@ -238,7 +194,7 @@ void execute_command(Page* page, int cmd_start, int cmd_end) {
             
             /* Copy the name */
             for (j = 0; j < name_len; j++) {
-                page->name[j] = page->buffer[name_start + j];
+                page->name[j] = page_char_at(page, name_start + j);
             }
             page->name[name_len] = '\0';
             
@@ -309,6 +265,108 @@ void execute_command(Page* page, int cmd_start, int cmd_end) {
         /* Clear highlight after command execution */
         page->highlight_start = 0;
         page->highlight_end = 0;
+    } else if (command_matches(cmd_name, cmd_len, "$bench-edit")) {
+        /* $bench-edit command - gap buffer keystroke benchmark */
+        serial_write_string("Running page edit benchmark\n");
+        bench_page_edit();
+        
+        /* Clear highlight after command execution */
+        page->highlight_start = 0;
+        page->highlight_end = 0;
+        refresh_screen();
+    } else if (command_matches(cmd_name, cmd_len, "$bench-cursor")) {
+        /* $bench-cursor command - line index cursor benchmark */
+        serial_write_string("Running cursor benchmark\n");
+        bench_cursor_motion();
+        
+        /* Clear highlight after command execution */
+        page->highlight_start = 0;
+        page->highlight_end = 0;
+        refresh_screen();
+    } else if (command_matches(cmd_name, cmd_len, "$bench-heap")) {
+        /* $bench-heap command - open/close demo sessions, check for leaks */
+        serial_write_string("Running heap benchmark\n");
+        bench_heap_stress();
+        bench_arena_frames();
+        
+        /* Clear highlight after command execution */
+        page->highlight_start = 0;
+        page->highlight_end = 0;
+        refresh_screen();
+    } else if (command_matches(cmd_name, cmd_len, "$bench-mem")) {
+        /* $bench-mem command - memcpy/memset/memmove bandwidth */
+        serial_write_string("Running memory bandwidth benchmark\n");
+        bench_memory_bandwidth();
+        
+        /* Clear highlight after command execution */
+        page->highlight_start = 0;
+        page->highlight_end = 0;
+        refresh_screen();
+    } else if (command_matches(cmd_name, cmd_len, "$bench-text")) {
+        /* $bench-text command - DISPI text rendering benchmark */
+        serial_write_string("Running text rendering benchmark\n");
+        bench_text_render();
+        
+        /* Clear highlight after command execution */
+        page->highlight_start = 0;
+        page->highlight_end = 0;
+        
+        /* Screen needs to be redrawn after returning from graphics mode */
+        refresh_screen();
+    } else if (command_matches(cmd_name, cmd_len, "$bench-vga")) {
+        /* $bench-vga command - mode 12h text rendering benchmark */
+        serial_write_string("Running mode 12h text benchmark\n");
+        bench_vga_text();
+    
+        /* Clear highlight after command execution */
+        page->highlight_start = 0;
+        page->highlight_end = 0;
+    
+        /* Screen needs to be redrawn after returning from graphics mode */
+        refresh_screen();
+    } else if (command_matches(cmd_name, cmd_len, "$bench-simd")) {
+        /* $bench-simd command - scalar vs SSE2 pixel kernels */
+        serial_write_string("Running SIMD kernel benchmark\n");
+        bench_simd_kernels();
+    
+        /* Clear highlight after command execution */
+        page->highlight_start = 0;
+        page->highlight_end = 0;
+        refresh_screen();
+    } else if (command_matches(cmd_name, cmd_len, "$bench-fb")) {
+        /* $bench-fb command - flips to uncached vs write-combining VRAM */
+        serial_write_string("Running framebuffer mapping benchmark\n");
+        bench_framebuffer_mapping();
+    
+        /* Clear highlight after command execution */
+        page->highlight_start = 0;
+        page->highlight_end = 0;
+        refresh_screen();
+    } else if (command_matches(cmd_name, cmd_len, "$input")) {
+        /* $input command - log keyboard and mouse ring statistics */
+        input_irq_report_stats();
+    
+        /* Clear highlight after command execution */
+        page->highlight_start = 0;
+        page->highlight_end = 0;
+        refresh_screen();
+    } else if (command_matches(cmd_name, cmd_len, "$heap")) {
+        /* $heap command - log allocator and arena statistics */
+        memory_report_stats();
+        arena_report_stats();
+        
+        /* Clear highlight after command execution */
+        page->highlight_start = 0;
+        page->highlight_end = 0;
+        refresh_screen();
+    } else if (command_matches(cmd_name, cmd_len, "$frames")) {
+        /* $frames command - log frame time histograms of the last demo */
+        frame_pacer_report();
+    
+        /* Clear highlight after command execution */
+        page->highlight_start = 0;
+        page->highlight_end = 0;
+        refresh_screen();
     } else {
         /* Command not recognized */
         serial_write_string("Command not found: ");
@@ -335,7 +393,7 @@ void execute_link(Page* page, int link_start, int link_end) {
     if (link_len >= 64) link_len = 63;
     
     for (i = 0; i < link_len; i++) {
-        link_text[i] = page->buffer[link_start + 1 + i];  /* +1 to skip # */
+        link_text[i] = page_char_at(page, link_start + 1 + i);  /* +1 to skip # */
     }
     link_text[link_len] = '\0';
     
@@ -16,19 +16,76 @@
 #include "memory.h"
 #include "font_6x8.h"
 #include "graphics.h"
+#include "surface.h"
+#include "timer.h"
+#include "simd.h"
+#include "paging.h"
 
 /* Framebuffer information */
 static unsigned char* framebuffer = (unsigned char*)DISPI_LFB_PHYSICAL_ADDRESS;
 static unsigned int framebuffer_size = 0;
 static int dispi_available = 0;
 
-/* Double buffering support */
+/* Video memory size, for mapping the framebuffer BAR write-combining */
+static unsigned int vram_bytes = 0;
+static int write_combining = 0;
+
+/* Double buffering support.
+ * With page flipping, the framebuffer holds two pages stacked vertically
+ * and frontbuffer/backbuffer point at the shown and hidden one. Without
+ * it, backbuffer is a heap copy and frontbuffer is the framebuffer. */
+static unsigned char* frontbuffer = (unsigned char*)DISPI_LFB_PHYSICAL_ADDRESS;
 static unsigned char* backbuffer = NULL;
 static int double_buffered = 0;
+static int page_flipping = 0;
+static int front_page = 0;
+
+/* Flip statistics for the current graphics session: bytes copied to
+ * present frames (or, with page flipping, to keep the pages in sync) */
+static unsigned int flip_count = 0;
+static unsigned int flip_bytes_total = 0;
+static unsigned int flip_bytes_last = 0;
+static unsigned int flip_bytes_max = 0;
+
+/* Dirty tile tracking: one bit per DISPI_TILE_SIZE square of the screen.
+ * Why tiles instead of a list of rectangles: drawing marks a pixel or a
+ * glyph at a time, and a short rectangle list overflowed into full-screen
+ * copies. Setting a bit costs the same however many regions are dirty,
+ * and the copy never grows beyond the tiles actually touched. */
+#define DIRTY_TILE_WORDS ((DISPI_TILE_COLS + 31) / 32)
+static unsigned int dirty_tiles[DISPI_TILE_ROWS][DIRTY_TILE_WORDS];
+static int dirty_pending = 0;
+
+/* Vertical retrace. DISPI has no retrace register of its own, but the
+ * adapter is still a VGA and reports retrace in input status 1. */
+#define VGA_INPUT_STATUS_1      0x3DA
+#define VGA_STATUS_VRETRACE     0x08
+#define DISPI_VSYNC_TIMEOUT_MS  50          /* Three frames at 60Hz */
+#define DISPI_VSYNC_MAX_POLLS   0x100000    /* In case the timer is off */
+static int vsync_usable = 1;
+
+/* Overlay sprite (the mouse cursor), composited over the page shown.
+ * Why it never goes into the backbuffer: a flip used to wipe it out, so
+ * every demo redrew the cursor after every flip and moving it meant a
+ * layout redraw to erase the old one. The backbuffer stays clean, a flip
+ * blends the sprite into the spans it copies, and a move re-presents
+ * only the old and new boxes. */
+#define DISPI_OVERLAY_MAX       32
+static const unsigned char *overlay_pixels = NULL;
+static int overlay_width = 0;
+static int overlay_height = 0;
+static unsigned char overlay_key = 0;
+static int overlay_x = 0;
+static int overlay_y = 0;
+static int overlay_visible = 0;
 
-/* Dirty rectangle tracking */
-static DirtyRect dirty_rects[MAX_DIRTY_RECTS];
-static int num_dirty_rects = 0;
+/* Pixels the overlay covers: with page flipping, the clean back page
+ * pixels blended over at the flip; single buffered, the framebuffer
+ * pixels it hides. Kept at the size of the overlay. */
+static unsigned char overlay_under[DISPI_OVERLAY_MAX * DISPI_OVERLAY_MAX];
+static int overlay_under_x = 0;
+static int overlay_under_y = 0;
+static int overlay_under_valid = 0;
 
 /* Write to DISPI register */
 void dispi_write(unsigned short index, unsigned short value) {
@@ -81,6 +138,7 @@ void dispi_init(void) {
     fb_addr = pci_find_vga_framebuffer();
     if (fb_addr != 0) {
         framebuffer = (unsigned char*)fb_addr;
+        frontbuffer = framebuffer;
         serial_write_string("Using detected framebuffer at: ");
         serial_write_hex(fb_addr);
         serial_write_string("\n");
@@ -116,6 +174,34 @@ void dispi_init(void) {
     serial_write_string("x");
     serial_write_hex(bpp);
     serial_write_string("\n");
+    
+    /* Why write-combining: the framebuffer is uncached MMIO, so without
+     * it every store in a flip is its own bus write */
+    vram_bytes = (unsigned int)dispi_read(VBE_DISPI_INDEX_VIDEO_MEMORY_64K) * 65536;
+    paging_report_mtrr((unsigned int)framebuffer);
+    dispi_set_write_combining(1);
+}
+
+/* Map all of video memory write-combining or back to the MTRR default */
+int dispi_set_write_combining(int enabled) {
+    unsigned int changed;
+    
+    if (!dispi_available || vram_bytes == 0) return 0;
+    
+    changed = paging_set_memory_type((unsigned int)framebuffer, vram_bytes,
+                                     enabled ? PAGING_WRITE_COMBINING : PAGING_WRITE_BACK);
+    if (changed == 0) return 0;
+    
+    write_combining = enabled ? 1 : 0;
+    serial_write_string(enabled ? "Framebuffer mapped write-combining: " :
+                                  "Framebuffer mapped with MTRR default type: ");
+    serial_write_hex(changed);
+    serial_write_string(" bytes\n");
+    return 1;
+}
+
+int dispi_is_write_combining(void) {
+    return write_combining;
 }
 
 /* Set display mode */
@@ -169,9 +255,9 @@ void dispi_disable(void) {
     dispi_write(VBE_DISPI_INDEX_ENABLE, VBE_DISPI_DISABLED);
 }
 
-/* Get framebuffer address */
+/* Get the address of the page being displayed */
 unsigned char* dispi_get_framebuffer(void) {
-    return framebuffer;
+    return frontbuffer;
 }
 
 /* Get framebuffer size */
@@ -190,6 +276,7 @@ static void dispi_driver_set_pixel(int x, int y, unsigned char color);
 static unsigned char dispi_driver_get_pixel(int x, int y);
 static void dispi_driver_fill_rect(int x, int y, int w, int h, unsigned char color);
 static void dispi_driver_blit(int x, int y, int w, int h, unsigned char *src, int src_stride);
+static void dispi_driver_copy_rect(int dst_x, int dst_y, int src_x, int src_y, int w, int h);
 static void dispi_driver_set_palette(unsigned char palette[16][3]);
 static void dispi_driver_get_palette(unsigned char palette[16][3]);
 static void dispi_driver_clear_screen(unsigned char color);
@@ -270,7 +357,7 @@ static void dispi_driver_fill_rect(int x, int y, int w, int h, unsigned char col
 static void dispi_driver_blit(int x, int y, int w, int h, unsigned char *src, int src_stride) {
     unsigned char* target;
     unsigned char* fb;
-    int row, col;
+    int row;
     
     /* Clip to screen bounds */
     if (x < 0) { src -= x; w += x; x = 0; }
@@ -280,13 +367,11 @@ static void dispi_driver_blit(int x, int y, int w, int h, unsigned char *src, in
     
     if (w <= 0 || h <= 0) return;
     
-    /* Copy the buffer */
+    /* Copy the buffer a row at a time */
     target = double_buffered ? backbuffer : framebuffer;
     fb = target + y * DISPI_WIDTH + x;
     for (row = 0; row < h; row++) {
-        for (col = 0; col < w; col++) {
-            fb[col] = src[col];
-        }
+        memcpy(fb, src, w);
         src += src_stride;
         fb += DISPI_WIDTH;
     }
@@ -297,6 +382,21 @@ static void dispi_driver_blit(int x, int y, int w, int h, unsigned char *src, in
     }
 }
 
+/* Move a block within the page being drawn.
+ * Why not get_pixel/set_pixel: a console scroll moves nearly the whole
+ * screen, and two calls per pixel cost far more than the row memmoves
+ * surface_copy_rect does (in the right order when the blocks overlap). */
+static void dispi_driver_copy_rect(int dst_x, int dst_y, int src_x, int src_y, int w, int h) {
+    Surface screen;
+    
+    if (!surface_get_screen(&screen)) return;
+    
+    surface_copy_rect(&screen, dst_x, dst_y, &screen, src_x, src_y, w, h);
+    if (double_buffered) {
+        dispi_mark_dirty(dst_x, dst_y, w, h);
+    }
+}
+
 /* Set palette using VGA DAC registers */
 static void dispi_driver_set_palette(unsigned char palette[16][3]) {
     int i;
@@ -322,15 +422,9 @@ static void dispi_driver_get_palette(unsigned char palette[16][3]) {
 
 /* Clear the entire screen */
 static void dispi_driver_clear_screen(unsigned char color) {
-    /* Fast clear using memset-like operation */
     unsigned char* target = double_buffered ? backbuffer : framebuffer;
-    unsigned int size = DISPI_WIDTH * DISPI_HEIGHT;
-    unsigned int i;
     
-    /* Fill screen with color */
-    for (i = 0; i < size; i++) {
-        target[i] = color;
-    }
+    simd_fill(target, color, DISPI_WIDTH * DISPI_HEIGHT);
     
     /* Mark entire screen as dirty */
     if (double_buffered) {
@@ -338,11 +432,9 @@ static void dispi_driver_clear_screen(unsigned char color) {
     }
 }
 
-/* Wait for vsync (stub - DISPI doesn't provide vsync) */
+/* Wait for vsync */
 static void dispi_driver_vsync(void) {
-    /* DISPI doesn't have a vsync register, so this is a no-op
-     * In a real implementation, we might use a timer or VGA port 0x3DA
-     */
+    dispi_wait_vsync();
 }
 
 /* Get the DISPI driver */
@@ -360,12 +452,14 @@ DisplayDriver* dispi_get_driver(void) {
     
     dispi_driver.fill_rect = dispi_driver_fill_rect;
     dispi_driver.blit = dispi_driver_blit;
+    dispi_driver.copy_rect = dispi_driver_copy_rect;
     
     dispi_driver.set_palette = dispi_driver_set_palette;
     dispi_driver.get_palette = dispi_driver_get_palette;
     
     dispi_driver.clear_screen = dispi_driver_clear_screen;
     dispi_driver.vsync = dispi_driver_vsync;
+    dispi_driver.get_surface = surface_get_screen;
     
     dispi_driver.name = dispi_driver_name;
     
@@ -385,6 +479,299 @@ DisplayDriver* dispi_get_driver(void) {
     return &dispi_driver;
 }
 
+/* Set up two pages in video memory: page 0 at the top of the framebuffer
+ * and page 1 right below it, shown by moving the Y offset.
+ * Why: presenting a frame becomes one register write instead of copying
+ * 300KB, and the backbuffer no longer takes 300KB of heap. */
+static int dispi_init_page_flip(void) {
+    unsigned int vram_size;
+    
+    /* Needs ID4 or later for the video memory size register */
+    vram_size = (unsigned int)dispi_read(VBE_DISPI_INDEX_VIDEO_MEMORY_64K) * 65536;
+    if (vram_size < 2 * framebuffer_size) {
+        serial_write_string("Page flipping unavailable: not enough video memory\n");
+        return 0;
+    }
+    
+    dispi_write(VBE_DISPI_INDEX_VIRT_HEIGHT, 2 * DISPI_HEIGHT);
+    if (dispi_read(VBE_DISPI_INDEX_VIRT_HEIGHT) < 2 * DISPI_HEIGHT) {
+        serial_write_string("Page flipping unavailable: virtual height rejected\n");
+        dispi_write(VBE_DISPI_INDEX_VIRT_HEIGHT, DISPI_HEIGHT);
+        return 0;
+    }
+    dispi_write(VBE_DISPI_INDEX_Y_OFFSET, 0);
+    
+    front_page = 0;
+    frontbuffer = framebuffer;
+    backbuffer = framebuffer + framebuffer_size;
+    
+    /* The mode switch only cleared the visible page */
+    memset(backbuffer, 0, framebuffer_size);
+    
+    page_flipping = 1;
+    double_buffered = 1;
+    
+    serial_write_string("Double buffering initialized with page flipping, back page at ");
+    serial_write_hex((unsigned int)backbuffer);
+    serial_write_string(" (no heap backbuffer)\n");
+    
+    return 1;
+}
+
+/* Record the bytes copied by one flip */
+static void dispi_note_flip(unsigned int bytes) {
+    flip_count++;
+    flip_bytes_total += bytes;
+    flip_bytes_last = bytes;
+    if (bytes > flip_bytes_max) {
+        flip_bytes_max = bytes;
+    }
+}
+
+/* Blend the overlay into columns x0..x1-1 of row y of a page */
+static void dispi_overlay_blend_row(unsigned char *page, int y, int x0, int x1) {
+    const unsigned char *src;
+    unsigned char *dst;
+    int x;
+    
+    if (!overlay_visible || !overlay_pixels) return;
+    if (y < overlay_y || y >= overlay_y + overlay_height) return;
+    
+    if (x0 < overlay_x) x0 = overlay_x;
+    if (x1 > overlay_x + overlay_width) x1 = overlay_x + overlay_width;
+    if (x0 < 0) x0 = 0;
+    if (x1 > DISPI_WIDTH) x1 = DISPI_WIDTH;
+    
+    src = overlay_pixels + (y - overlay_y) * overlay_width - overlay_x;
+    dst = page + y * DISPI_WIDTH;
+    for (x = x0; x < x1; x++) {
+        if (src[x] != overlay_key) {
+            dst[x] = src[x];
+        }
+    }
+}
+
+/* Blend the overlay into every row of a page it covers */
+static void dispi_overlay_blend(unsigned char *page) {
+    int y;
+    
+    for (y = overlay_y; y < overlay_y + overlay_height; y++) {
+        if (y >= 0 && y < DISPI_HEIGHT) {
+            dispi_overlay_blend_row(page, y, 0, DISPI_WIDTH);
+        }
+    }
+}
+
+/* Save the page pixels under the overlay's box (save != 0), or put the
+ * saved ones back where they came from */
+static void dispi_overlay_swap_under(unsigned char *page, int save) {
+    int x0, x1, y;
+    unsigned char *under;
+    unsigned char *pixels;
+    
+    if (save) {
+        overlay_under_x = overlay_x;
+        overlay_under_y = overlay_y;
+    } else if (!overlay_under_valid) {
+        return;
+    }
+    
+    x0 = overlay_under_x < 0 ? 0 : overlay_under_x;
+    x1 = overlay_under_x + overlay_width;
+    if (x1 > DISPI_WIDTH) x1 = DISPI_WIDTH;
+    
+    for (y = overlay_under_y; y < overlay_under_y + overlay_height; y++) {
+        if (y < 0 || y >= DISPI_HEIGHT || x0 >= x1) continue;
+        under = overlay_under + (y - overlay_under_y) * overlay_width + (x0 - overlay_under_x);
+        pixels = page + y * DISPI_WIDTH + x0;
+        if (save) {
+            memcpy(under, pixels, x1 - x0);
+        } else {
+            memcpy(pixels, under, x1 - x0);
+        }
+    }
+    
+    overlay_under_valid = save;
+}
+
+/* Copy a rectangle of the backbuffer to the page shown and blend the
+ * overlay over it */
+static void dispi_present_rect(int x, int y, int w, int h) {
+    int row;
+    unsigned int offset;
+    
+    if (x < 0) { w += x; x = 0; }
+    if (y < 0) { h += y; y = 0; }
+    if (x + w > DISPI_WIDTH) w = DISPI_WIDTH - x;
+    if (y + h > DISPI_HEIGHT) h = DISPI_HEIGHT - y;
+    if (w <= 0 || h <= 0) return;
+    
+    for (row = y; row < y + h; row++) {
+        offset = row * DISPI_WIDTH + x;
+        memcpy(frontbuffer + offset, backbuffer + offset, w);
+        dispi_overlay_blend_row(frontbuffer, row, x, x + w);
+    }
+}
+
+/* Move, show or hide the overlay on the page shown */
+static void dispi_overlay_update(int x, int y, int visible) {
+    int old_x = overlay_x;
+    int old_y = overlay_y;
+    int was_visible = overlay_visible && overlay_pixels;
+    
+    overlay_x = x;
+    overlay_y = y;
+    overlay_visible = visible;
+    
+    if (!dispi_available || !overlay_pixels) {
+        return;
+    }
+    
+    if (double_buffered && backbuffer) {
+        /* The backbuffer holds what the last flip showed, minus the overlay */
+        if (was_visible) {
+            dispi_present_rect(old_x, old_y, overlay_width, overlay_height);
+        }
+        if (visible) {
+            dispi_present_rect(x, y, overlay_width, overlay_height);
+        }
+        return;
+    }
+    
+    /* Single buffered: put back what the overlay hid, then keep what it
+     * is about to cover */
+    dispi_overlay_swap_under(framebuffer, 0);
+    if (visible) {
+        dispi_overlay_swap_under(framebuffer, 1);
+        dispi_overlay_blend(framebuffer);
+    }
+}
+
+/* Set the overlay sprite */
+void dispi_overlay_set(const unsigned char *pixels, int w, int h, unsigned char key) {
+    int visible = overlay_visible;
+    
+    if (w <= 0 || h <= 0 || w > DISPI_OVERLAY_MAX || h > DISPI_OVERLAY_MAX) {
+        serial_write_string("ERROR: Overlay sprite too large\n");
+        return;
+    }
+    
+    dispi_overlay_update(overlay_x, overlay_y, 0);
+    overlay_pixels = pixels;
+    overlay_width = w;
+    overlay_height = h;
+    overlay_key = key;
+    dispi_overlay_update(overlay_x, overlay_y, visible);
+}
+
+/* Move the overlay's top-left corner */
+void dispi_overlay_move(int x, int y) {
+    if (x == overlay_x && y == overlay_y) {
+        return;
+    }
+    dispi_overlay_update(x, y, overlay_visible);
+}
+
+/* Show or hide the overlay */
+void dispi_overlay_show(int visible) {
+    visible = visible ? 1 : 0;
+    if (visible == overlay_visible) {
+        return;
+    }
+    dispi_overlay_update(overlay_x, overlay_y, visible);
+}
+
+/* Copy the dirty tiles from one full-screen buffer to another.
+ * Each run of dirty tiles in a tile row becomes one span per scanline,
+ * and a completely dirty tile row is copied as a single block. With
+ * blend set, the overlay is blended into each span as it lands.
+ * Returns the number of bytes copied. */
+static unsigned int dispi_copy_dirty_tiles(unsigned char *dst_buffer,
+                                           const unsigned char *src_buffer,
+                                           int blend) {
+    int ty, tx, start, row, word;
+    unsigned int offset;
+    unsigned int span;
+    unsigned int bytes = 0;
+    unsigned int *bits;
+    
+    for (ty = 0; ty < DISPI_TILE_ROWS; ty++) {
+        bits = dirty_tiles[ty];
+        for (word = 0; word < DIRTY_TILE_WORDS; word++) {
+            if (bits[word]) break;
+        }
+        if (word == DIRTY_TILE_WORDS) continue;  /* Clean tile row */
+        
+        tx = 0;
+        while (tx < DISPI_TILE_COLS) {
+            if (!(bits[tx >> 5] & (1U << (tx & 31)))) {
+                tx++;
+                continue;
+            }
+            start = tx;
+            while (tx < DISPI_TILE_COLS && (bits[tx >> 5] & (1U << (tx & 31)))) {
+                tx++;
+            }
+            
+            offset = ty * DISPI_TILE_SIZE * DISPI_WIDTH + start * DISPI_TILE_SIZE;
+            span = (tx - start) * DISPI_TILE_SIZE;
+            if (span == DISPI_WIDTH) {
+                simd_copy(dst_buffer + offset, src_buffer + offset,
+                          DISPI_TILE_SIZE * DISPI_WIDTH);
+                for (row = 0; blend && row < DISPI_TILE_SIZE; row++) {
+                    dispi_overlay_blend_row(dst_buffer, ty * DISPI_TILE_SIZE + row,
+                                            0, DISPI_WIDTH);
+                }
+            } else {
+                for (row = 0; row < DISPI_TILE_SIZE; row++) {
+                    simd_copy(dst_buffer + offset, src_buffer + offset, span);
+                    if (blend) {
+                        dispi_overlay_blend_row(dst_buffer, ty * DISPI_TILE_SIZE + row,
+                                                start * DISPI_TILE_SIZE,
+                                                start * DISPI_TILE_SIZE + span);
+                    }
+                    offset += DISPI_WIDTH;
+                }
+            }
+            bytes += span * DISPI_TILE_SIZE;
+        }
+    }
+    
+    return bytes;
+}
+
+/* Show the back page and make the old front page the new back page.
+ * The new back page is one frame behind, so the regions drawn this frame
+ * are copied into it (video memory to video memory) to keep both pages
+ * identical outside whatever the next frame redraws. The overlay is
+ * blended into the page before it is shown, and the pixels it covered
+ * are put back into the new back page after the copy. */
+static void dispi_flip_pages(void) {
+    unsigned char *old_front;
+    
+    /* Nothing drawn since the last flip: both pages already match */
+    if (!dirty_pending) {
+        return;
+    }
+    
+    if (overlay_visible && overlay_pixels) {
+        dispi_overlay_swap_under(backbuffer, 1);
+        dispi_overlay_blend(backbuffer);
+    }
+    
+    front_page = 1 - front_page;
+    dispi_write(VBE_DISPI_INDEX_Y_OFFSET, front_page * DISPI_HEIGHT);
+    
+    old_front = frontbuffer;
+    frontbuffer = backbuffer;
+    backbuffer = old_front;
+    
+    dispi_note_flip(dispi_copy_dirty_tiles(backbuffer, frontbuffer, 0));
+    dispi_overlay_swap_under(backbuffer, 0);
+    
+    dispi_clear_dirty();
+}
+
 /* Initialize double buffering */
 int dispi_init_double_buffer(void) {
     serial_write_string("dispi_init_double_buffer: dispi_available = ");
@@ -401,6 +788,18 @@ int dispi_init_double_buffer(void) {
         return 1;
     }
     
+    flip_count = 0;
+    flip_bytes_total = 0;
+    flip_bytes_last = 0;
+    flip_bytes_max = 0;
+    dispi_clear_dirty();
+    overlay_under_valid = 0;
+    
+    /* Prefer flipping between two pages of video memory */
+    if (dispi_init_page_flip()) {
+        return 1;
+    }
+    
     /* Allocate backbuffer */
     backbuffer = (unsigned char*)malloc(framebuffer_size);
     if (!backbuffer) {
@@ -419,20 +818,25 @@ int dispi_init_double_buffer(void) {
     return 1;
 }
 
-/* Flip buffers - copy backbuffer to framebuffer */
+/* Flip buffers - show the back page, or copy backbuffer to framebuffer */
 void dispi_flip_buffers(void) {
     if (!double_buffered || !backbuffer) {
         return;
     }
     
-    /* If we have dirty rectangles, use optimized flip */
-    if (num_dirty_rects > 0) {
+    if (page_flipping) {
+        dispi_flip_pages();
+        return;
+    }
+    
+    /* If we have dirty tiles, copy only those */
+    if (dirty_pending) {
         dispi_flip_dirty_rects();
     } else {
-        /* No dirty rects tracked, copy entire buffer
-         * This is where we'd ideally use hardware page flipping,
-         * but DISPI doesn't support multiple framebuffers */
-        memcpy(framebuffer, backbuffer, framebuffer_size);
+        /* Nothing tracked, copy entire buffer */
+        simd_copy(framebuffer, backbuffer, framebuffer_size);
+        dispi_overlay_blend(framebuffer);
+        dispi_note_flip(framebuffer_size);
     }
 }
 
@@ -448,23 +852,32 @@ unsigned char* dispi_get_backbuffer(void) {
 /* Direct framebuffer access for cursor (bypasses double buffering) */
 void dispi_set_pixel_direct(int x, int y, unsigned char color) {
     if (x >= 0 && x < DISPI_WIDTH && y >= 0 && y < DISPI_HEIGHT) {
-        framebuffer[y * DISPI_WIDTH + x] = color;
+        frontbuffer[y * DISPI_WIDTH + x] = color;
     }
 }
 
 /* Direct framebuffer read for cursor (bypasses double buffering) */
 unsigned char dispi_get_pixel_direct(int x, int y) {
     if (x >= 0 && x < DISPI_WIDTH && y >= 0 && y < DISPI_HEIGHT) {
-        return framebuffer[y * DISPI_WIDTH + x];
+        return frontbuffer[y * DISPI_WIDTH + x];
     }
     return 0;
 }
 
 /* Cleanup double buffering */
 void dispi_cleanup_double_buffer(void) {
-    if (backbuffer) {
-        /* Note: free() is a no-op in our bump allocator,
-         * but we clear the pointer for safety */
+    dispi_report_flip_stats();
+    
+    if (page_flipping) {
+        /* Back to a single page at the top of video memory */
+        dispi_write(VBE_DISPI_INDEX_Y_OFFSET, 0);
+        dispi_write(VBE_DISPI_INDEX_VIRT_HEIGHT, DISPI_HEIGHT);
+        frontbuffer = framebuffer;
+        backbuffer = NULL;
+        page_flipping = 0;
+        front_page = 0;
+    } else if (backbuffer) {
+        /* Returns the 300KB to the heap for the next session */
         free(backbuffer);
         backbuffer = NULL;
     }
@@ -476,10 +889,62 @@ int dispi_is_double_buffered(void) {
     return double_buffered;
 }
 
-/* Mark a region as dirty (needs to be copied on next flip) */
+/* Poll until the retrace bit reads as wanted. Returns 0 on timeout. */
+static int dispi_poll_retrace(int wanted, unsigned int start, unsigned int *polls) {
+    while (((inb(VGA_INPUT_STATUS_1) & VGA_STATUS_VRETRACE) != 0) != wanted) {
+        if (get_elapsed_ms(start) > DISPI_VSYNC_TIMEOUT_MS || ++*polls > DISPI_VSYNC_MAX_POLLS) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* Wait for the start of the next vertical retrace.
+ * Why wait out a retrace already in progress: the caller flips as soon
+ * as this returns, and a flip late in a retrace runs into the next
+ * frame's scanout. Starting at the leading edge leaves the whole
+ * retrace for the copy. */
+int dispi_wait_vsync(void) {
+    unsigned int start, polls;
+    
+    if (!vsync_usable) return 0;
+    
+    start = get_ticks();
+    polls = 0;
+    if (dispi_poll_retrace(0, start, &polls) && dispi_poll_retrace(1, start, &polls)) {
+        return 1;
+    }
+    
+    /* The bit is stuck, so every later wait would time out too */
+    vsync_usable = 0;
+    serial_write_string("DISPI: no vertical retrace on 0x3DA, vsync disabled\n");
+    return 0;
+}
+
+/* Whether dispi_wait_vsync still waits for retrace */
+int dispi_has_vsync(void) {
+    return vsync_usable;
+}
+
+/* Log flip statistics for the current graphics session */
+void dispi_report_flip_stats(void) {
+    serial_write_string(page_flipping ? "Page flips: " : "Buffer flips: ");
+    serial_write_int(flip_count);
+    serial_write_string(", bytes copied last ");
+    serial_write_int(flip_bytes_last);
+    serial_write_string(", average ");
+    serial_write_int(flip_count ? flip_bytes_total / flip_count : 0);
+    serial_write_string(", max ");
+    serial_write_int(flip_bytes_max);
+    serial_write_string(" (full screen ");
+    serial_write_int(DISPI_WIDTH * DISPI_HEIGHT);
+    serial_write_string(")\n");
+}
+
+/* Mark a region as dirty (needs to be copied on next flip).
+ * Sets the bit of every tile the region touches - one for a pixel. */
 void dispi_mark_dirty(int x, int y, int w, int h) {
-    int i;
-    DirtyRect *rect;
+    int tx, ty, tx_end, ty_end;
     
     /* Clip to screen bounds */
     if (x < 0) { w += x; x = 0; }
@@ -489,96 +954,58 @@ void dispi_mark_dirty(int x, int y, int w, int h) {
     
     if (w <= 0 || h <= 0) return;
     
-    /* Try to merge with existing rectangles first */
-    for (i = 0; i < num_dirty_rects; i++) {
-        rect = &dirty_rects[i];
-        if (!rect->valid) continue;
-        
-        /* Check if rectangles overlap or are adjacent */
-        if (!(x >= rect->x + rect->w || x + w <= rect->x ||
-              y >= rect->y + rect->h || y + h <= rect->y)) {
-            /* Merge by expanding existing rectangle */
-            int new_x = x < rect->x ? x : rect->x;
-            int new_y = y < rect->y ? y : rect->y;
-            int new_x2 = (x + w) > (rect->x + rect->w) ? (x + w) : (rect->x + rect->w);
-            int new_y2 = (y + h) > (rect->y + rect->h) ? (y + h) : (rect->y + rect->h);
-            
-            rect->x = new_x;
-            rect->y = new_y;
-            rect->w = new_x2 - new_x;
-            rect->h = new_y2 - new_y;
-            return;
+    tx_end = (x + w - 1) / DISPI_TILE_SIZE;
+    ty_end = (y + h - 1) / DISPI_TILE_SIZE;
+    for (ty = y / DISPI_TILE_SIZE; ty <= ty_end; ty++) {
+        for (tx = x / DISPI_TILE_SIZE; tx <= tx_end; tx++) {
+            dirty_tiles[ty][tx >> 5] |= 1U << (tx & 31);
         }
     }
-    
-    /* Add new rectangle if space available */
-    if (num_dirty_rects < MAX_DIRTY_RECTS) {
-        rect = &dirty_rects[num_dirty_rects];
-        rect->x = x;
-        rect->y = y;
-        rect->w = w;
-        rect->h = h;
-        rect->valid = 1;
-        num_dirty_rects++;
-    } else {
-        /* If out of space, mark entire screen as dirty */
-        dirty_rects[0].x = 0;
-        dirty_rects[0].y = 0;
-        dirty_rects[0].w = DISPI_WIDTH;
-        dirty_rects[0].h = DISPI_HEIGHT;
-        dirty_rects[0].valid = 1;
-        num_dirty_rects = 1;
-    }
+    dirty_pending = 1;
 }
 
-/* Clear all dirty rectangles */
+/* Clear all dirty tiles */
 void dispi_clear_dirty(void) {
-    int i;
-    for (i = 0; i < MAX_DIRTY_RECTS; i++) {
-        dirty_rects[i].valid = 0;
+    int ty, word;
+    
+    for (ty = 0; ty < DISPI_TILE_ROWS; ty++) {
+        for (word = 0; word < DIRTY_TILE_WORDS; word++) {
+            dirty_tiles[ty][word] = 0;
+        }
     }
-    num_dirty_rects = 0;
+    dirty_pending = 0;
+}
+
+/* Check for pending damage */
+int dispi_has_damage(void) {
+    return dirty_pending;
 }
 
-/* Flip only dirty rectangles from backbuffer to framebuffer */
+/* Flip only dirty tiles from backbuffer to framebuffer */
 void dispi_flip_dirty_rects(void) {
-    int i, row;
-    DirtyRect *rect;
-    unsigned char *src, *dst;
-    
     if (!double_buffered || !backbuffer) {
         return;
     }
     
-    /* If no dirty rects, nothing to flip */
-    if (num_dirty_rects == 0) {
+    if (page_flipping) {
+        dispi_flip_pages();
         return;
     }
     
-    /* Copy each dirty rectangle */
-    for (i = 0; i < num_dirty_rects; i++) {
-        rect = &dirty_rects[i];
-        if (!rect->valid) continue;
-        
-        /* Copy rectangle row by row */
-        for (row = 0; row < rect->h; row++) {
-            src = backbuffer + ((rect->y + row) * DISPI_WIDTH + rect->x);
-            dst = framebuffer + ((rect->y + row) * DISPI_WIDTH + rect->x);
-            memcpy(dst, src, rect->w);
-        }
+    /* If nothing is dirty, nothing to flip */
+    if (!dirty_pending) {
+        return;
     }
     
-    /* Clear dirty rectangles after flip */
+    dispi_note_flip(dispi_copy_dirty_tiles(framebuffer, backbuffer, 1));
+    
+    /* Clear dirty tiles after flip */
     dispi_clear_dirty();
 }
 
 /* Optimized horizontal line drawing using 32-bit writes when possible */
 void dispi_hline_fast(int x, int y, int width, unsigned char color) {
     unsigned char *target;
-    unsigned int color32;
-    unsigned int *dst32;
-    int aligned_start, aligned_end;
-    int i;
     
     /* Bounds check */
     if (y < 0 || y >= DISPI_HEIGHT) return;
@@ -587,39 +1014,11 @@ void dispi_hline_fast(int x, int y, int width, unsigned char color) {
     if (width <= 0) return;
     
     target = double_buffered ? backbuffer : framebuffer;
-    target += y * DISPI_WIDTH + x;
-    
-    /* Handle unaligned start bytes */
-    aligned_start = (4 - ((unsigned int)target & 3)) & 3;
-    if (aligned_start > width) aligned_start = width;
-    
-    for (i = 0; i < aligned_start; i++) {
-        *target++ = color;
-    }
-    width -= aligned_start;
-    
-    /* Handle aligned middle with 32-bit writes */
-    if (width >= 4) {
-        color32 = color | (color << 8) | (color << 16) | (color << 24);
-        dst32 = (unsigned int*)target;
-        aligned_end = width / 4;
-        
-        for (i = 0; i < aligned_end; i++) {
-            *dst32++ = color32;
-        }
-        
-        target = (unsigned char*)dst32;
-        width &= 3;
-    }
-    
-    /* Handle remaining unaligned bytes */
-    for (i = 0; i < width; i++) {
-        *target++ = color;
-    }
+    simd_fill(target + y * DISPI_WIDTH + x, color, width);
     
     /* Mark as dirty */
     if (double_buffered) {
-        dispi_mark_dirty(x, y, width + aligned_start, 1);
+        dispi_mark_dirty(x, y, width, 1);
     }
 }
 
@@ -648,9 +1047,8 @@ static int abs(int n) {
 
 /* Blit with transparency - pixels matching transparent_color are not drawn */
 void dispi_blit_transparent(int x, int y, int w, int h, unsigned char *src, int src_stride, unsigned char transparent_color) {
-    int row, col;
-    int src_x, src_y;
-    unsigned char pixel;
+    int row, col, run_end;
+    const unsigned char *src_row;
     unsigned char *target = double_buffered ? backbuffer : framebuffer;
     
     /* Clip to screen bounds */
@@ -663,17 +1061,21 @@ void dispi_blit_transparent(int x, int y, int w, int h, unsigned char *src, int
         return;
     }
     
-    /* Blit the visible portion */
+    /* Blit the visible portion, copying each run of opaque pixels whole */
     for (row = y_start; row < y_end; row++) {
-        src_y = row - y;
-        for (col = x_start; col < x_end; col++) {
-            src_x = col - x;
-            pixel = src[src_y * src_stride + src_x];
-            
-            /* Only draw if not transparent */
-            if (pixel != transparent_color) {
-                target[row * DISPI_WIDTH + col] = pixel;
+        src_row = src + (row - y) * src_stride - x;
+        col = x_start;
+        while (col < x_end) {
+            if (src_row[col] == transparent_color) {
+                col++;
+                continue;
             }
+            run_end = col;
+            while (run_end < x_end && src_row[run_end] != transparent_color) {
+                run_end++;
+            }
+            memcpy(target + row * DISPI_WIDTH + col, src_row + col, run_end - col);
+            col = run_end;
         }
     }
     
@@ -787,8 +1189,8 @@ void dispi_fill_circle(int cx, int cy, int radius, unsigned char color) {
 /* Fill rectangle with an 8x8 pattern */
 void dispi_fill_pattern(int x, int y, int w, int h, unsigned char pattern[8]) {
     int row, col;
-    int pattern_y, pattern_x;
     unsigned char pattern_byte;
+    unsigned char row_pixels[8];
     unsigned char *target = double_buffered ? backbuffer : framebuffer;
     
     /* Clip to screen bounds */
@@ -801,21 +1203,15 @@ void dispi_fill_pattern(int x, int y, int w, int h, unsigned char pattern[8]) {
         return;
     }
     
-    /* Fill with pattern */
+    /* Expand each pattern row into the 8 pixels that repeat from
+     * x_start, white where the bit is set and black elsewhere */
     for (row = y_start; row < y_end; row++) {
-        pattern_y = (row - y) & 7;  /* Modulo 8 */
-        pattern_byte = pattern[pattern_y];
-        
-        for (col = x_start; col < x_end; col++) {
-            pattern_x = (col - x) & 7;  /* Modulo 8 */
-            
-            /* Check if bit is set in pattern */
-            if (pattern_byte & (0x80 >> pattern_x)) {
-                target[row * DISPI_WIDTH + col] = 15;  /* White */
-            } else {
-                target[row * DISPI_WIDTH + col] = 0;   /* Black */
-            }
+        pattern_byte = pattern[(row - y) & 7];
+        for (col = 0; col < 8; col++) {
+            row_pixels[col] = (pattern_byte & (0x80 >> ((x_start - x + col) & 7))) ? 15 : 0;
         }
+        simd_fill_pattern8(target + row * DISPI_WIDTH + x_start, row_pixels,
+                           x_end - x_start);
     }
     
     /* Mark the affected area as dirty */
@@ -824,10 +1220,288 @@ void dispi_fill_pattern(int x, int y, int w, int h, unsigned char pattern[8]) {
     }
 }
 
+/* ============================================================================
+ * Glyph Atlas
+ * ============================================================================
+ *
+ * Each glyph row is pre-expanded into byte masks (0xFF where the font bit
+ * is set) packed into 32-bit words, so drawing a row is a few masked
+ * dword stores into the target buffer instead of one driver call, bounds
+ * check and dirty mark per pixel. The dirty region is marked once per
+ * glyph. The atlases are built on first use: the 6x8 one from
+ * font_hp100lx_6x8, the 9x16 one from the BIOS font saved by
+ * save_vga_font() (whose 9th column is always background).
+ */
+
+#define GLYPH_MAX_WORDS 4
+
+typedef struct {
+    int width;                          /* Pixels drawn per row */
+    int height;
+    int words;                          /* Dwords per expanded row */
+    unsigned int extent[GLYPH_MAX_WORDS];   /* Bytes inside the glyph cell */
+    unsigned int *masks;                /* 256 * height * words dwords */
+} GlyphAtlas;
+
+static GlyphAtlas atlas_6x8 = { FONT_hp100lx_WIDTH, FONT_hp100lx_HEIGHT, 2, { 0, 0, 0 }, NULL };
+static GlyphAtlas atlas_bios = { 9, 16, 3, { 0, 0, 0 }, NULL };
+static int glyph_cache_enabled = 1;
+
+/* Expand a 1bpp font (8 pixels per source byte, MSB first) into the atlas.
+ * glyph_stride is the distance in bytes between consecutive glyphs. */
+static int dispi_atlas_build(GlyphAtlas *atlas, const unsigned char *bits,
+                             int glyph_stride) {
+    unsigned int *out;
+    unsigned char byte;
+    int c, row, col, word;
+    
+    /* With SSE2, rows are padded to 16 bytes so one vector merge draws
+     * them; bytes past the cell are outside extent and kept */
+    if (simd_sse2_available()) {
+        atlas->words = GLYPH_MAX_WORDS;
+    }
+    
+    atlas->masks = (unsigned int*)malloc(256 * atlas->height * atlas->words * sizeof(unsigned int));
+    if (!atlas->masks) {
+        serial_write_string("WARNING: No memory for glyph atlas, drawing per pixel\n");
+        return 0;
+    }
+    
+    for (word = 0; word < atlas->words; word++) {
+        atlas->extent[word] = 0;
+    }
+    for (col = 0; col < atlas->width; col++) {
+        atlas->extent[col >> 2] |= 0xFFU << ((col & 3) * 8);
+    }
+    
+    out = atlas->masks;
+    for (c = 0; c < 256; c++) {
+        for (row = 0; row < atlas->height; row++) {
+            byte = bits[c * glyph_stride + row];
+            for (word = 0; word < atlas->words; word++) {
+                out[word] = 0;
+            }
+            for (col = 0; col < 8 && col < atlas->width; col++) {
+                if (byte & (0x80 >> col)) {
+                    out[col >> 2] |= 0xFFU << ((col & 3) * 8);
+                }
+            }
+            out += atlas->words;
+        }
+    }
+    
+    return 1;
+}
+
+/* Get the atlas for a font, building it on first use. Returns NULL if
+ * the atlas is disabled or can't be built. */
+static GlyphAtlas* dispi_glyph_atlas(int bios_font) {
+    unsigned char *font_base;
+    
+    if (!glyph_cache_enabled) return NULL;
+    
+    if (bios_font) {
+        if (!atlas_bios.masks) {
+            font_base = get_saved_font();
+            if (!font_base) return NULL;
+            /* In VGA, each character is 32 bytes (16 rows, with padding) */
+            dispi_atlas_build(&atlas_bios, font_base, 32);
+        }
+        return atlas_bios.masks ? &atlas_bios : NULL;
+    }
+    
+    if (!atlas_6x8.masks) {
+        dispi_atlas_build(&atlas_6x8, &font_hp100lx_6x8[0][0], FONT_hp100lx_HEIGHT);
+    }
+    return atlas_6x8.masks ? &atlas_6x8 : NULL;
+}
+
+/* Write one expanded glyph row at dst with masked dword stores.
+ * With a transparent background only foreground bytes change; otherwise
+ * every byte inside the glyph cell does. Bytes past the cell are kept. */
+static void dispi_atlas_row(const GlyphAtlas *atlas, unsigned int *dst,
+                            const unsigned int *mask, unsigned int fg32,
+                            unsigned int bg32, int transparent) {
+    unsigned int m;
+    int word;
+    
+    if (atlas->words == GLYPH_MAX_WORDS) {
+        simd_glyph_row16((unsigned char*)dst, mask, atlas->extent, fg32, bg32,
+                         transparent);
+        return;
+    }
+    
+    if (transparent) {
+        for (word = 0; word < atlas->words; word++) {
+            m = mask[word];
+            if (m) {
+                dst[word] = (dst[word] & ~m) | (fg32 & m);
+            }
+        }
+    } else {
+        for (word = 0; word < atlas->words; word++) {
+            m = (fg32 & mask[word]) | (bg32 & ~mask[word]);
+            dst[word] = (dst[word] & ~atlas->extent[word]) |
+                        (m & atlas->extent[word]);
+        }
+    }
+}
+
+/* Draw a glyph from an atlas.
+ * Returns 0 (drawing nothing) if the glyph's dwords would leave the
+ * screen, so the caller can fall back to clipped per-pixel drawing. */
+static int dispi_atlas_draw(const GlyphAtlas *atlas, int x, int y,
+                            unsigned char c, unsigned char fg, unsigned char bg) {
+    unsigned char *target;
+    const unsigned int *mask;
+    int row;
+    
+    if (x < 0 || y < 0 || x + atlas->words * 4 > DISPI_WIDTH ||
+        y + atlas->height > DISPI_HEIGHT) {
+        return 0;
+    }
+    
+    target = double_buffered ? backbuffer : framebuffer;
+    mask = atlas->masks + c * atlas->height * atlas->words;
+    
+    for (row = 0; row < atlas->height; row++) {
+        dispi_atlas_row(atlas, (unsigned int*)(target + (y + row) * DISPI_WIDTH + x),
+                        mask, fg * 0x01010101U, bg * 0x01010101U, bg == 255);
+        mask += atlas->words;
+    }
+    
+    if (double_buffered) {
+        dispi_mark_dirty(x, y, atlas->width, atlas->height);
+    }
+    return 1;
+}
+
+/* Draw len characters as one clipped text run into a width x height
+ * buffer, and return the visible box through box (0 if nothing shows).
+ * The run is intersected with the clip rectangle first, so characters
+ * outside it cost nothing. Each scanline of the run is then drawn left
+ * to right across every visible glyph: whole glyphs from the atlas,
+ * glyphs cut by the clip edge column by column from the font bits. */
+static int dispi_text_run(unsigned char *target, int width, int height, int stride,
+                          int x, int y, const char *str, int len, int bios_font,
+                          unsigned char fg, unsigned char bg,
+                          int clip_x, int clip_y, int clip_w, int clip_h, int box[4]) {
+    const GlyphAtlas *atlas;
+    const unsigned char *bits;
+    unsigned char *line;
+    unsigned char byte;
+    unsigned int fg32 = fg * 0x01010101U;
+    unsigned int bg32 = bg * 0x01010101U;
+    int glyph_stride, cell_w, cell_h;
+    int x0, y0, x1, y1;
+    int first, last, i, gx, px, px_end, py, row;
+    unsigned char c;
+    
+    if (!str || len <= 0) return 0;
+    
+    if (bios_font) {
+        bits = get_saved_font();
+        if (!bits) return 0;
+        glyph_stride = 32;
+        cell_w = 9;
+        cell_h = 16;
+    } else {
+        bits = &font_hp100lx_6x8[0][0];
+        glyph_stride = FONT_hp100lx_HEIGHT;
+        cell_w = FONT_hp100lx_WIDTH;
+        cell_h = FONT_hp100lx_HEIGHT;
+    }
+    
+    /* Visible box: the run clipped to the clip rectangle and the buffer */
+    x0 = x > clip_x ? x : clip_x;
+    y0 = y > clip_y ? y : clip_y;
+    x1 = x + len * cell_w;
+    y1 = y + cell_h;
+    if (x1 > clip_x + clip_w) x1 = clip_x + clip_w;
+    if (y1 > clip_y + clip_h) y1 = clip_y + clip_h;
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 > width) x1 = width;
+    if (y1 > height) y1 = height;
+    if (x0 >= x1 || y0 >= y1) return 0;
+    
+    first = (x0 - x) / cell_w;
+    last = (x1 - 1 - x) / cell_w;
+    atlas = dispi_glyph_atlas(bios_font);
+    
+    for (py = y0; py < y1; py++) {
+        row = py - y;
+        line = target + py * stride;
+        
+        for (i = first; i <= last; i++) {
+            c = (unsigned char)str[i];
+            gx = x + i * cell_w;
+            
+            if (atlas && gx >= x0 && gx + cell_w <= x1 &&
+                gx + atlas->words * 4 <= width) {
+                dispi_atlas_row(atlas, (unsigned int*)(line + gx),
+                                atlas->masks + (c * cell_h + row) * atlas->words,
+                                fg32, bg32, bg == 255);
+                continue;
+            }
+            
+            /* Glyph cut by the clip edge (or no atlas) */
+            byte = bits[c * glyph_stride + row];
+            px = gx > x0 ? gx : x0;
+            px_end = gx + cell_w < x1 ? gx + cell_w : x1;
+            for (; px < px_end; px++) {
+                if (px - gx < 8 && (byte & (0x80 >> (px - gx)))) {
+                    line[px] = fg;
+                } else if (bg != 255) {
+                    line[px] = bg;
+                }
+            }
+        }
+    }
+    
+    box[0] = x0;
+    box[1] = y0;
+    box[2] = x1 - x0;
+    box[3] = y1 - y0;
+    return 1;
+}
+
+/* Draw a clipped text run to the screen, marking it dirty once */
+void dispi_draw_text_run(int x, int y, const char *str, int len, int bios_font,
+                         unsigned char fg, unsigned char bg,
+                         int clip_x, int clip_y, int clip_w, int clip_h) {
+    int box[4];
+    
+    if (dispi_text_run(double_buffered ? backbuffer : framebuffer,
+                       DISPI_WIDTH, DISPI_HEIGHT, DISPI_WIDTH, x, y, str, len,
+                       bios_font, fg, bg, clip_x, clip_y, clip_w, clip_h, box) &&
+        double_buffered) {
+        dispi_mark_dirty(box[0], box[1], box[2], box[3]);
+    }
+}
+
+/* Draw a clipped text run into an offscreen buffer */
+void dispi_draw_text_run_to(unsigned char *pixels, int width, int height, int stride,
+                            int x, int y, const char *str, int len, int bios_font,
+                            unsigned char fg, unsigned char bg,
+                            int clip_x, int clip_y, int clip_w, int clip_h) {
+    int box[4];
+    
+    if (!pixels) return;
+    dispi_text_run(pixels, width, height, stride, x, y, str, len, bios_font,
+                   fg, bg, clip_x, clip_y, clip_w, clip_h, box);
+}
+
+/* Turn the glyph atlas on or off (for benchmarking the per-pixel path) */
+void dispi_set_glyph_cache(int enabled) {
+    glyph_cache_enabled = enabled;
+}
+
 /* Draw character using saved VGA font (9x16) */
 void dispi_draw_char_bios(int x, int y, unsigned char c, unsigned char fg_color, unsigned char bg_color) {
     unsigned char *font_base = get_saved_font();
     unsigned char *char_data;
+    const GlyphAtlas *atlas;
     int row, col;
     unsigned char byte;
     
@@ -836,6 +1510,11 @@ void dispi_draw_char_bios(int x, int y, unsigned char c, unsigned char fg_color,
         return;
     }
     
+    atlas = dispi_glyph_atlas(1);
+    if (atlas && dispi_atlas_draw(atlas, x, y, c, fg_color, bg_color)) {
+        return;
+    }
+    
     /* In VGA, each character is 32 bytes (16 rows, with padding) */
     char_data = font_base + (c * 32);
     
@@ -885,9 +1564,15 @@ void dispi_draw_string_bios(int x, int y, const char *str, unsigned char fg_colo
 /* Text rendering functions for DISPI using 6x8 font */
 void dispi_draw_char(int x, int y, unsigned char c, unsigned char fg, unsigned char bg) {
     const unsigned char *char_data;
+    const GlyphAtlas *atlas;
     int row, col;
     unsigned char byte;
     
+    atlas = display_get_driver() == &dispi_driver ? dispi_glyph_atlas(0) : NULL;
+    if (atlas && dispi_atlas_draw(atlas, x, y, c, fg, bg)) {
+        return;
+    }
+    
     /* Get character bitmap from 6x8 font */
     char_data = font_hp100lx_6x8[c];
     
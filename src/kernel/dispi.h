@@ -46,13 +46,11 @@
 #define DISPI_HEIGHT                    480
 #define DISPI_BPP                       8
 
-/* Dirty rectangle tracking */
-#define MAX_DIRTY_RECTS                 16
-
-typedef struct {
-    int x, y, w, h;
-    int valid;
-} DirtyRect;
+/* Dirty region tracking: the screen is split into 16x16-pixel tiles
+ * (40x30), and a flip copies only the tiles marked since the last one */
+#define DISPI_TILE_SIZE                 16
+#define DISPI_TILE_COLS                 (DISPI_WIDTH / DISPI_TILE_SIZE)
+#define DISPI_TILE_ROWS                 (DISPI_HEIGHT / DISPI_TILE_SIZE)
 
 /* DISPI functions */
 void dispi_write(unsigned short index, unsigned short value);
@@ -65,18 +63,40 @@ void dispi_disable(void);
 unsigned char* dispi_get_framebuffer(void);
 unsigned int dispi_get_framebuffer_size(void);
 
-/* Double buffering support */
+/* Map video memory write-combining (1) or with the firmware's MTRR
+ * type, normally uncached (0). dispi_init turns it on when paging has a
+ * PAT. Returns 0 if the mapping could not be changed. */
+int dispi_set_write_combining(int enabled);
+int dispi_is_write_combining(void);
+
+/* Double buffering support.
+ * Uses two pages of video memory and flips between them by changing the
+ * Y offset when the adapter has room; otherwise a heap backbuffer is
+ * copied to the framebuffer. Either way, draw into dispi_get_backbuffer()
+ * and present with dispi_flip_buffers(). */
 int dispi_init_double_buffer(void);
 void dispi_flip_buffers(void);
 unsigned char* dispi_get_backbuffer(void);
 void dispi_cleanup_double_buffer(void);
 int dispi_is_double_buffered(void);
 
-/* Dirty rectangle management */
+/* Dirty region management */
 void dispi_mark_dirty(int x, int y, int w, int h);
 void dispi_clear_dirty(void);
 void dispi_flip_dirty_rects(void);
 
+/* 1 if anything has been marked dirty since the last flip */
+int dispi_has_damage(void);
+
+/* Wait for the start of the next vertical retrace (VGA input status
+ * register 0x3DA). Returns 0 without waiting if retrace never showed up
+ * within a few frames, which turns waiting off for good. */
+int dispi_wait_vsync(void);
+int dispi_has_vsync(void);
+
+/* Log flip count and bytes copied per flip (last, average, max) */
+void dispi_report_flip_stats(void);
+
 /* Optimized drawing operations */
 void dispi_fill_rect_fast(int x, int y, int w, int h, unsigned char color);
 void dispi_hline_fast(int x, int y, int width, unsigned char color);
@@ -96,10 +116,38 @@ void dispi_draw_string_bios(int x, int y, const char *str, unsigned char fg_colo
 void dispi_draw_char(int x, int y, unsigned char c, unsigned char fg, unsigned char bg);
 void dispi_draw_string(int x, int y, const char *str, unsigned char fg, unsigned char bg);
 
+/* Draw len characters in the 6x8 font (or the 9x16 BIOS font if
+ * bios_font), clipped to the given rectangle and the screen. Used by
+ * gc_draw_text; newlines and tabs are not interpreted. */
+void dispi_draw_text_run(int x, int y, const char *str, int len, int bios_font,
+                         unsigned char fg, unsigned char bg,
+                         int clip_x, int clip_y, int clip_w, int clip_h);
+
+/* The same, into an offscreen width x height buffer (not marked dirty) */
+void dispi_draw_text_run_to(unsigned char *pixels, int width, int height, int stride,
+                            int x, int y, const char *str, int len, int bios_font,
+                            unsigned char fg, unsigned char bg,
+                            int clip_x, int clip_y, int clip_w, int clip_h);
+
+/* Both fonts draw from a glyph atlas of pre-expanded row masks (built on
+ * first use) unless it is disabled here; 1 by default */
+void dispi_set_glyph_cache(int enabled);
+
 /* Get the display driver for DISPI */
 struct DisplayDriver* dispi_get_driver(void);
 
-/* Direct framebuffer access (bypasses double buffering - for cursor) */
+/* Overlay sprite (the mouse cursor) composited over the page shown.
+ * It is never drawn into the backbuffer: flips blend it into the spans
+ * they copy, and moving it re-presents only its old and new boxes, so
+ * nothing under it has to be redrawn. Pixels equal to key are
+ * transparent; the sprite is at most 32x32 and is not copied, so keep
+ * it alive while set. x and y are the sprite's top-left corner. */
+void dispi_overlay_set(const unsigned char *pixels, int w, int h, unsigned char key);
+void dispi_overlay_move(int x, int y);
+void dispi_overlay_show(int visible);
+
+/* Direct access to the page being shown (bypasses double buffering - for
+ * cursor). Anything drawn this way is gone after the next flip. */
 void dispi_set_pixel_direct(int x, int y, unsigned char color);
 unsigned char dispi_get_pixel_direct(int x, int y);
 
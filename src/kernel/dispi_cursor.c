@@ -40,75 +40,50 @@ static struct {
 };
 
 
-/* Draw the cursor with black outline */
-static void draw_cursor_at(int x, int y) {
-    DisplayDriver *driver = display_get_driver();
-    int row, col, px, py;
-    int byte_index, bit_index;
-    int dx, dy, n_row, n_col;
+/* The cursor as an overlay sprite: the arrow plus a one-pixel outline
+ * on every side, so the sprite's (1, 1) is the bitmap's (0, 0) */
+#define CURSOR_SPRITE_WIDTH  (CURSOR_WIDTH + 2)
+#define CURSOR_SPRITE_HEIGHT (CURSOR_HEIGHT + 2)
+#define CURSOR_SPRITE_KEY    255    /* Outside the 16-color palette */
+static unsigned char cursor_sprite[CURSOR_SPRITE_WIDTH * CURSOR_SPRITE_HEIGHT];
     
-    if (!driver || !driver->set_pixel) {
-        return;
+/* Is bitmap pixel (col, row) part of the arrow? */
+static int cursor_bit(int col, int row) {
+    if (col < 0 || col >= CURSOR_WIDTH || row < 0 || row >= CURSOR_HEIGHT) {
+        return 0;
     }
+    return (cursor_arrow[row * 2 + (col / 8)] >> (7 - (col % 8))) & 1;
+}
     
-    /* First pass: Draw black outline */
-    for (row = 0; row < CURSOR_HEIGHT; row++) {
-        for (col = 0; col < CURSOR_WIDTH; col++) {
-            byte_index = row * 2 + (col / 8);
-            bit_index = 7 - (col % 8);
+/* Expand the bitmap into the sprite: white body, black outline wherever
+ * a pixel outside the arrow touches it, transparent elsewhere */
+static void build_cursor_sprite(void) {
+    int row, col, dx, dy;
+    unsigned char pixel;
             
-            /* Check if this pixel is part of cursor */
-            if (cursor_arrow[byte_index] & (1 << bit_index)) {
-                /* Check all 8 neighbors for outline */
+    for (row = 0; row < CURSOR_SPRITE_HEIGHT; row++) {
+        for (col = 0; col < CURSOR_SPRITE_WIDTH; col++) {
+            pixel = CURSOR_SPRITE_KEY;
+            if (cursor_bit(col - 1, row - 1)) {
+                pixel = 5;  /* White cursor */
+            } else {
                 for (dy = -1; dy <= 1; dy++) {
                     for (dx = -1; dx <= 1; dx++) {
-                        if (dx == 0 && dy == 0) continue;
-                        
-                        px = x + col + dx - CURSOR_HOTSPOT_X;
-                        py = y + row + dy - CURSOR_HOTSPOT_Y;
-                        
-                        /* Check bounds */
-                        if (px >= 0 && px < driver->width && py >= 0 && py < driver->height) {
-                            /* Check if neighbor is outside cursor shape */
-                            n_col = col + dx;
-                            n_row = row + dy;
-                            
-                            if (n_col < 0 || n_col >= CURSOR_WIDTH || 
-                                n_row < 0 || n_row >= CURSOR_HEIGHT) {
-                                /* Neighbor is outside cursor bounds - draw outline */
-                                dispi_set_pixel_direct(px, py, 0); /* Black outline */
-                            } else {
-                                /* Check if neighbor pixel is not part of cursor */
-                                int n_byte = n_row * 2 + (n_col / 8);
-                                int n_bit = 7 - (n_col % 8);
-                                if (!(cursor_arrow[n_byte] & (1 << n_bit))) {
-                                    dispi_set_pixel_direct(px, py, 0); /* Black outline */
-                                }
-                            }
+                        if (cursor_bit(col - 1 + dx, row - 1 + dy)) {
+                            pixel = 0;  /* Black outline */
                         }
                     }
                 }
             }
+            cursor_sprite[row * CURSOR_SPRITE_WIDTH + col] = pixel;
         }
     }
+}
     
-    /* Second pass: Draw white cursor body */
-    for (row = 0; row < CURSOR_HEIGHT; row++) {
-        for (col = 0; col < CURSOR_WIDTH; col++) {
-            byte_index = row * 2 + (col / 8);
-            bit_index = 7 - (col % 8);
-            
-            if (cursor_arrow[byte_index] & (1 << bit_index)) {
-                px = x + col - CURSOR_HOTSPOT_X;
-                py = y + row - CURSOR_HOTSPOT_Y;
-                
-                /* Check bounds */
-                if (px >= 0 && px < driver->width && py >= 0 && py < driver->height) {
-                    dispi_set_pixel_direct(px, py, 5); /* White cursor */
-                }
-            }
-        }
-    }
+/* Place the sprite so the hotspot lands on the cursor position */
+static void place_cursor_sprite(void) {
+    dispi_overlay_move(cursor_state.x - CURSOR_HOTSPOT_X - 1,
+                       cursor_state.y - CURSOR_HOTSPOT_Y - 1);
 }
 
 /* Initialize the cursor system */
@@ -117,26 +92,34 @@ void dispi_cursor_init(void) {
     cursor_state.y = 240;
     cursor_state.visible = 0;
     
+    build_cursor_sprite();
+    dispi_overlay_show(0);
+    dispi_overlay_set(cursor_sprite, CURSOR_SPRITE_WIDTH, CURSOR_SPRITE_HEIGHT,
+                      CURSOR_SPRITE_KEY);
+    place_cursor_sprite();
+    
     serial_write_string("DISPI cursor initialized\n");
 }
 
 /* Show the cursor */
 void dispi_cursor_show(void) {
     if (!cursor_state.visible) {
-        draw_cursor_at(cursor_state.x, cursor_state.y);
         cursor_state.visible = 1;
+        dispi_overlay_show(1);
     }
 }
 
-/* Hide the cursor */
+/* Hide the cursor, putting back what it covered */
 void dispi_cursor_hide(void) {
     if (cursor_state.visible) {
         cursor_state.visible = 0;
-        /* Note: We don't restore background since double buffering handles that */
+        dispi_overlay_show(0);
     }
 }
 
-/* Update cursor position */
+/* Update cursor position.
+ * Only the old and new sprite boxes are re-presented; nothing under the
+ * cursor is redrawn. */
 void dispi_cursor_move(int x, int y) {
     DisplayDriver *driver = display_get_driver();
     
@@ -155,14 +138,9 @@ void dispi_cursor_move(int x, int y) {
         return;
     }
     
-    /* Update position */
     cursor_state.x = x;
     cursor_state.y = y;
-    
-    if (cursor_state.visible) {
-        /* Just redraw at new position */
-        draw_cursor_at(cursor_state.x, cursor_state.y);
-    }
+    place_cursor_sprite();
 }
 
 /* Get current cursor position */
@@ -87,15 +87,16 @@ DisplayDriver* dispi_graphics_init(void) {
     /* Clear screen with warm gray background to actually enable graphics mode */
     display_clear(15);  /* Use color 15 (warm gray) for background */
     
-    /* Initialize and show mouse cursor for DISPI mode */
-    dispi_cursor_init();
-    dispi_cursor_show();
-    
     /* Flip buffers if double buffering is enabled to show initial clear */
     if (dispi_is_double_buffered()) {
         dispi_flip_buffers();
     }
     
+    /* Initialize and show mouse cursor for DISPI mode. It is an overlay
+     * composited at flip time, so later flips keep it on screen. */
+    dispi_cursor_init();
+    dispi_cursor_show();
+    
     serial_write_string("DISPI graphics initialization complete\n");
     
     return driver;
@@ -4,6 +4,7 @@
 #include "modes.h"
 #include "rtc.h"
 #include "serial.h"
+#include "memory.h"
 
 /* Mouse state */
 int mouse_x = 40;          /* Mouse X position (0-79) */
@@ -13,8 +14,22 @@ int mouse_visible = 0;     /* Is mouse cursor visible */
 /* Graphics mode flag (defined elsewhere, just declared extern here) */
 extern int graphics_mode_active;
 
-/* Draw navigation bar at top of screen */
-void draw_nav_bar(void) {
+/* VGA text page cache.
+ * Each of the eight hardware text pages can hold one editor page. The
+ * current page and its neighbours are kept in slots so that moving to
+ * the previous or next page only flips the CRTC start address. A slot
+ * may be stale (clock, page count, or the page was edited after it was
+ * rendered), so it is always brought up to date with a differential
+ * present before it is shown; that writes only the cells that changed. */
+static int vga_slot_page[VGA_TEXT_PAGES];       /* Editor page, or -1 */
+static unsigned int vga_slot_used[VGA_TEXT_PAGES]; /* LRU stamp */
+static unsigned int vga_slot_clock = 0;
+static int vga_slots_ready = 0;
+static int displayed_page = -1;  /* Editor page shown by last refresh */
+
+/* Compose navigation bar for an editor page into the top row of the
+ * shadow buffer */
+static void compose_nav_bar(int page_index) {
     int i;
     unsigned short color;
     char page_info[40];
@@ -33,14 +48,7 @@ void draw_nav_bar(void) {
     }
     
     /* Fill top line with white background (inverse colors) */
-    for (i = 0; i < VGA_WIDTH; i++) {
-        color = VGA_COLOR_NAV_BAR;  /* Gray background, black text */
-        /* Check if mouse is on this position */
-        if (mouse_visible && mouse_y == 0 && mouse_x == i) {
-            color = VGA_COLOR_MOUSE;  /* Green background for mouse cursor */
-        }
-        vga_write_char(i, ' ', color);
-    }
+    vga_fill_region(0, VGA_WIDTH, ' ', VGA_COLOR_NAV_BAR);
     
     /* Display mode on the left side */
     mode_str = get_mode_string();
@@ -52,15 +60,12 @@ void draw_nav_bar(void) {
         color = editor_mode == MODE_INSERT ? 0x7200 : /* Green bg for insert */
                 editor_mode == MODE_VISUAL ? 0x7400 : /* Red bg for visual */
                 0x7800;  /* Yellow bg for normal */
-        if (mouse_visible && mouse_y == 0 && mouse_x == i + 1) {
-            color = VGA_COLOR_MOUSE;
-        }
         vga_write_char(i + 1, mode_str[i], color);
     }
     
     /* Display page name if it exists */
     {
-        Page *page = pages[current_page];
+        Page *page = pages[page_index];
         int name_start = mode_len + 2;  /* Start after mode and a space */
         int name_len = 0;
         
@@ -75,11 +80,7 @@ void draw_nav_bar(void) {
             
             /* Write page name */
             for (i = 0; i < name_len; i++) {
-                color = 0x7000;  /* Gray background */
-                if (mouse_visible && mouse_y == 0 && mouse_x == name_start + i) {
-                    color = VGA_COLOR_MOUSE;
-                }
-                vga_write_char(name_start + i, page->name[i], color);
+                vga_write_char(name_start + i, page->name[i], 0x7000);
             }
         }
     }
@@ -87,7 +88,7 @@ void draw_nav_bar(void) {
     /* Format page info string */
     
     /* Always reserve space for [prev], but only draw if not on first page */
-    if (current_page > 0) {
+    if (page_index > 0) {
         page_info[len++] = '[';
         page_info[len++] = 'p';
         page_info[len++] = 'r';
@@ -113,7 +114,7 @@ void draw_nav_bar(void) {
     page_info[len++] = ' ';
     
     /* Add current page number */
-    page_num = current_page + 1;
+    page_num = page_index + 1;
     if (page_num >= 10) {
         page_info[len++] = '0' + (page_num / 10);
     }
@@ -141,12 +142,7 @@ void draw_nav_bar(void) {
     /* Center the text in the nav bar */
     start_pos = (VGA_WIDTH - len) / 2;
     for (i = 0; i < len; i++) {
-        color = 0x7000;  /* Gray background */
-        /* Check if mouse is on this position */
-        if (mouse_visible && mouse_y == 0 && mouse_x == start_pos + i) {
-            color = VGA_COLOR_MOUSE;  /* Green background for mouse cursor */
-        }
-        vga_write_char(start_pos + i, page_info[i], color);
+        vga_write_char(start_pos + i, page_info[i], 0x7000);  /* Gray background */
     }
     
     /* Get current time for display in upper right */
@@ -202,85 +198,58 @@ void draw_nav_bar(void) {
     /* Display datetime in upper right corner (with 1 space padding from edge) */
     start_pos = VGA_WIDTH - dt_len - 1;
     for (i = 0; i < dt_len; i++) {
-        color = 0x7F00;  /* Gray background, white text */
-        /* Check if mouse is on this position */
-        if (mouse_visible && mouse_y == 0 && mouse_x == start_pos + i) {
-            color = VGA_COLOR_MOUSE;  /* Green background for mouse cursor */
-        }
-        vga_write_char(start_pos + i, datetime_str[i], color);
+        vga_write_char(start_pos + i, datetime_str[i], 0x7F00);  /* Gray background, white text */
+    }
+}
+
+/* Draw navigation bar at top of screen */
+void draw_nav_bar(void) {
+    if (graphics_mode_active) {
+        return;
     }
+    
+    compose_nav_bar(current_page);
+    vga_present();
 }
 
 /* Update hardware cursor position */
 void update_cursor(void) {
-    /* Calculate visual position accounting for newlines and tabs */
+    /* The page's line index knows the screen row of every line and
+     * expands tabs the same way refresh_screen does */
     Page *page = pages[current_page];
-    int screen_pos = VGA_WIDTH;  /* Start after nav bar */
-    int buf_pos = 0;
-    
-    while (buf_pos < page->cursor_pos && screen_pos < VGA_WIDTH * VGA_HEIGHT) {
-        if (buf_pos < page->length) {
-            char c = page->buffer[buf_pos];
-            if (c == '\n') {
-                /* Jump to next line */
-                int col = screen_pos % VGA_WIDTH;
-                screen_pos += (VGA_WIDTH - col);
-            } else if (c == '\t') {
-                /* Tab takes 2 screen positions */
-                screen_pos += 2;
-            } else {
-                screen_pos++;
-            }
-        } else {
-            screen_pos++;
-        }
-        buf_pos++;
-    }
+    int screen_pos = VGA_WIDTH + page_screen_offset(page, page->cursor_pos);
     
-    /* Use VGA module to set cursor position */
+    /* Use VGA module to set cursor position (hides it if off screen) */
     vga_set_cursor(screen_pos);
 }
 
-/* Redraw the screen from the buffer */
-void refresh_screen(void) {
-    int i;
-    Page *page;
+/* Move the text-mode mouse cursor to mouse_x/mouse_y */
+void update_mouse(void) {
+    if (graphics_mode_active) {
+        return;
+    }
+    
+    vga_set_mouse(mouse_visible ? mouse_y * VGA_WIDTH + mouse_x : -1);
+}
+
+/* Compose page text into the shadow buffer, from the first screen row of
+ * the given line to the bottom of the screen. Rows above are left as
+ * they were last composed. */
+static void compose_page_text(Page *page, int line) {
     int screen_pos;
     int buf_pos;
     unsigned short color;
     char c;
     int col;
     int j;
-    unsigned short tab_color;
-    
-    /* Don't draw text mode content when in graphics mode */
-    if (graphics_mode_active) {
-        return;
-    }
-    
-    /* Clear only the text area (not nav bar) to prevent flickering */
-    for (i = VGA_WIDTH; i < VGA_WIDTH * VGA_HEIGHT; i++) {
-        vga_write_char(i, ' ', VGA_COLOR);
-    }
-    
-    /* Always redraw navigation bar to update mouse cursor */
-    draw_nav_bar();
-    
-    /* Get current page */
-    page = pages[current_page];
     
-    /* Start drawing text from line 1 (after nav bar) */
-    screen_pos = VGA_WIDTH;  /* Skip first line */
-    buf_pos = 0;
+    /* Start at the line's row, skipping the nav bar on screen row 0 */
+    screen_pos = VGA_WIDTH + page->lines[line].row * VGA_WIDTH;
+    buf_pos = page_line_start(page, line);
     
     while (screen_pos < VGA_WIDTH * VGA_HEIGHT && buf_pos < page->length) {
         color = VGA_COLOR;
         
-        /* Check if this is the mouse position */
-        if (mouse_visible && screen_pos == (mouse_y * VGA_WIDTH + mouse_x)) {
-            color = VGA_COLOR_MOUSE;  /* Green background for mouse cursor */
-        }
-        
         /* Check if this position is highlighted (using per-page highlight) */
         if (page->highlight_end > 0 && page->highlight_end <= page->length &&
             page->highlight_start >= 0 && page->highlight_start < page->highlight_end &&
@@ -288,28 +257,17 @@ void refresh_screen(void) {
             color = VGA_COLOR_HIGHLIGHT;  /* Red background for highlighted text */
         }
         
-        c = page->buffer[buf_pos];
+        c = page_char_at(page, buf_pos);
         if (c == '\n') {
             /* Fill rest of line with spaces */
             col = screen_pos % VGA_WIDTH;
-            while (col < VGA_WIDTH && screen_pos < VGA_WIDTH * VGA_HEIGHT) {
-                /* Check mouse position for each space */
-                if (mouse_visible && screen_pos == (mouse_y * VGA_WIDTH + mouse_x)) {
-                    vga_write_char(screen_pos++, ' ', VGA_COLOR_MOUSE);
-                } else {
-                    vga_write_char(screen_pos++, ' ', VGA_COLOR);
-                }
-                col++;
-            }
+            vga_fill_region(screen_pos, VGA_WIDTH - col, ' ', VGA_COLOR);
+            screen_pos += VGA_WIDTH - col;
             buf_pos++;
         } else if (c == '\t') {
             /* Display tab as two spaces */
             for (j = 0; j < 2 && screen_pos < VGA_WIDTH * VGA_HEIGHT; j++) {
-                tab_color = color;
-                if (mouse_visible && screen_pos == (mouse_y * VGA_WIDTH + mouse_x)) {
-                    tab_color = 0x2F00;
-                }
-                vga_write_char(screen_pos++, ' ', tab_color);
+                vga_write_char(screen_pos++, ' ', color);
             }
             buf_pos++;
         } else {
@@ -320,13 +278,126 @@ void refresh_screen(void) {
     }
     
     /* Fill remaining screen with spaces */
-    while (screen_pos < VGA_WIDTH * VGA_HEIGHT) {
-        if (mouse_visible && screen_pos == (mouse_y * VGA_WIDTH + mouse_x)) {
-            vga_write_char(screen_pos++, ' ', VGA_COLOR_MOUSE);
-        } else {
-            vga_write_char(screen_pos++, ' ', VGA_COLOR);
+    if (screen_pos < VGA_WIDTH * VGA_HEIGHT) {
+        vga_fill_region(screen_pos, VGA_WIDTH * VGA_HEIGHT - screen_pos, ' ', VGA_COLOR);
+    }
+}
+
+/* Find the hardware page holding an editor page, or -1 */
+static int vga_slot_find(int page_index) {
+    int i;
+    
+    for (i = 0; i < VGA_TEXT_PAGES; i++) {
+        if (vga_slot_page[i] == page_index) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/* Get a hardware page for an editor page, evicting the least recently
+ * used slot that is not holding the current page or its neighbours */
+static int vga_slot_get(int page_index) {
+    int i;
+    int slot;
+    int held;
+    
+    if (!vga_slots_ready) {
+        for (i = 0; i < VGA_TEXT_PAGES; i++) {
+            vga_slot_page[i] = -1;
+            vga_slot_used[i] = 0;
+        }
+        vga_slots_ready = 1;
+    }
+    
+    slot = vga_slot_find(page_index);
+    if (slot < 0) {
+        for (i = 0; i < VGA_TEXT_PAGES; i++) {
+            held = vga_slot_page[i];
+            if (held >= 0 && held >= current_page - 1 && held <= current_page + 1) {
+                continue;
+            }
+            if (slot < 0 || vga_slot_used[i] < vga_slot_used[slot]) {
+                slot = i;
+            }
         }
+        vga_slot_page[slot] = page_index;
     }
+    
+    vga_slot_used[slot] = ++vga_slot_clock;
+    return slot;
+}
+
+/* Render an editor page into its own hardware page off-screen, unless a
+ * slot already holds it */
+static void prerender_page(int page_index) {
+    int slot;
+    
+    if (page_index < 0 || page_index >= total_pages || !pages[page_index]) {
+        return;
+    }
+    if (vga_slot_find(page_index) >= 0) {
+        return;
+    }
+    
+    slot = vga_slot_get(page_index);
+    compose_nav_bar(page_index);
+    compose_page_text(pages[page_index], 0);
+    vga_present_page(slot);
+}
+
+/* Redraw the screen from the buffer */
+void refresh_screen(void) {
+    int slot;
+    
+    /* Don't draw text mode content when in graphics mode */
+    if (graphics_mode_active) {
+        return;
+    }
+    
+    /* After a page switch, get the new neighbours ready off-screen so
+     * the next Shift+Left/Right is just a flip. This composes into the
+     * shadow buffer, so it must happen before the current page is
+     * composed below. */
+    if (current_page != displayed_page) {
+        prerender_page(current_page - 1);
+        prerender_page(current_page + 1);
+    }
+    
+    /* Compose the whole screen into the shadow buffer. Every text cell
+     * is written, so no clearing pass is needed, and nothing reaches
+     * VGA memory until vga_present_page() sends the changed cells. For a
+     * page that was cached off-screen that is only what went stale. */
+    slot = vga_slot_get(current_page);
+    compose_nav_bar(current_page);
+    compose_page_text(pages[current_page], 0);
+    vga_present_page(slot);
+    
+    /* Show it only once it is complete, so a switch never tears */
+    if (vga_get_visible_page() != slot) {
+        vga_show_page(slot);
+    }
+    displayed_page = current_page;
+    
+    update_cursor();
+    update_mouse();
+}
+
+/* Redraw only the text at and after pos.
+ * Why this is enough after an edit: text before pos did not change, so
+ * the rows above pos's line are still correct in the shadow buffer, and
+ * everything below is recomposed to pick up shifted lines. */
+void refresh_screen_from(int pos) {
+    Page *page;
+    
+    if (graphics_mode_active) {
+        return;
+    }
+    
+    page = pages[current_page];
+    compose_page_text(page, page_line_of(page, pos));
+    
+    vga_present();
     update_cursor();
 }
 
@@ -337,9 +408,9 @@ void clear_screen(void) {
     /* Use VGA module to clear screen */
     vga_clear_screen();
     
-    /* Clear current page */
+    /* Clear current page (pages may not be allocated yet at boot) */
     page = pages[current_page];
-    page->cursor_pos = 0;
-    page->length = 0;
+    if (page == NULL) return;
+    page_clear(page);
     update_cursor();
 }
\ No newline at end of file
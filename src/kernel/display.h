@@ -15,7 +15,9 @@ extern int graphics_mode_active;
 /* Display functions */
 void draw_nav_bar(void);
 void update_cursor(void);
+void update_mouse(void);
 void refresh_screen(void);
+void refresh_screen_from(int pos);
 void clear_screen(void);
 
 #endif /* DISPLAY_H */
\ No newline at end of file
@@ -88,6 +88,31 @@ void display_blit(int x, int y, int w, int h, unsigned char *src, int src_stride
     }
 }
 
+/* Move a block of the screen, for scrolling. Drivers without copy_rect
+ * go a pixel at a time, in the order that reads every source pixel
+ * before it is overwritten. */
+void display_copy_rect(int dst_x, int dst_y, int src_x, int src_y, int w, int h) {
+    DisplayDriver *driver = active_display_driver;
+    int row, col, r, c;
+    
+    if (!driver || w <= 0 || h <= 0) return;
+    
+    if (driver->copy_rect) {
+        driver->copy_rect(dst_x, dst_y, src_x, src_y, w, h);
+        return;
+    }
+    
+    if (!driver->get_pixel || !driver->set_pixel) return;
+    
+    for (row = 0; row < h; row++) {
+        r = dst_y > src_y ? h - 1 - row : row;
+        for (col = 0; col < w; col++) {
+            c = dst_x > src_x ? w - 1 - col : col;
+            driver->set_pixel(dst_x + c, dst_y + r, driver->get_pixel(src_x + c, src_y + r));
+        }
+    }
+}
+
 /* Clear the screen */
 void display_clear(unsigned char color) {
     if (active_display_driver) {
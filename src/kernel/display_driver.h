@@ -5,6 +5,8 @@
  * Supports both VGA mode 12h and DISPI/VBE implementations
  */
 
+struct Surface;
+
 typedef struct DisplayDriver {
     /* Display properties */
     int width;
@@ -23,6 +25,10 @@ typedef struct DisplayDriver {
     void (*fill_rect)(int x, int y, int w, int h, unsigned char color);
     void (*blit)(int x, int y, int w, int h, unsigned char *src, int src_stride);
     
+    /* Optional: move a w x h block of the page being drawn from
+     * (src_x, src_y) to (dst_x, dst_y). The blocks may overlap. */
+    void (*copy_rect)(int dst_x, int dst_y, int src_x, int src_y, int w, int h);
+    
     /* Palette management - 16 colors with RGB components */
     void (*set_palette)(unsigned char palette[16][3]);
     void (*get_palette)(unsigned char palette[16][3]);
@@ -31,6 +37,12 @@ typedef struct DisplayDriver {
     void (*clear_screen)(unsigned char color);
     void (*vsync)(void);  /* Wait for vertical sync */
     
+    /* Optional: describe the page being drawn as an 8bpp surface so
+     * callers can write pixels directly (and mark what they touch with
+     * the driver's dirty tracking). NULL or returning 0 means the
+     * display is only reachable through the calls above. */
+    int (*get_surface)(struct Surface *out);
+    
     /* Driver name for debugging */
     const char *name;
 } DisplayDriver;
@@ -49,6 +61,7 @@ void display_set_pixel(int x, int y, unsigned char color);
 unsigned char display_get_pixel(int x, int y);
 void display_fill_rect(int x, int y, int w, int h, unsigned char color);
 void display_blit(int x, int y, int w, int h, unsigned char *src, int src_stride);
+void display_copy_rect(int dst_x, int dst_y, int src_x, int src_y, int w, int h);
 void display_clear(unsigned char color);
 
 #endif
\ No newline at end of file
@@ -3,13 +3,92 @@
 #include "display.h"
 #include "modes.h"
 
+/* Edit transactions
+ *
+ * Editor primitives report what they changed instead of redrawing:
+ * edit_mark_dirty() when text changed, edit_mark_cursor() when only the
+ * cursor moved, and edit_mark_all() for anything else on screen (such
+ * as a highlight). Outside a transaction each mark updates the screen
+ * immediately. Between edit_begin() and edit_commit() marks only
+ * accumulate a dirty range - from the first changed text position to
+ * the end of the page - and the commit renders once. A compound command
+ * like dd, d$ or a replayed key sequence therefore costs one redraw no
+ * matter how many primitive steps it takes. */
+static int edit_depth = 0;          /* Nesting depth of edit_begin calls */
+static int edit_page = 0;           /* Page the transaction started on */
+static int edit_dirty_from = -1;    /* First changed text position, -1 if none */
+static int edit_dirty_all = 0;      /* Whole screen needs composing */
+static int edit_cursor_moved = 0;   /* Hardware cursor needs updating */
+
+/* Start a transaction (transactions nest) */
+void edit_begin(void) {
+    if (edit_depth == 0) {
+        edit_page = current_page;
+        edit_dirty_from = -1;
+        edit_dirty_all = 0;
+        edit_cursor_moved = 0;
+    }
+    edit_depth++;
+}
+
+/* End a transaction, rendering everything it changed in one pass */
+void edit_commit(void) {
+    if (edit_depth == 0) return;
+    edit_depth--;
+    if (edit_depth > 0) return;
+    
+    /* Dirty positions are meaningless if the page changed underneath */
+    if (current_page != edit_page &&
+        (edit_dirty_from >= 0 || edit_cursor_moved)) {
+        edit_dirty_all = 1;
+    }
+    
+    if (edit_dirty_all) {
+        refresh_screen();
+    } else if (edit_dirty_from >= 0) {
+        refresh_screen_from(edit_dirty_from);
+    } else if (edit_cursor_moved) {
+        update_cursor();
+    }
+}
+
+/* Text from pos to the end of the page changed */
+void edit_mark_dirty(int pos) {
+    if (edit_depth == 0) {
+        refresh_screen_from(pos);
+        return;
+    }
+    if (edit_dirty_from < 0 || pos < edit_dirty_from) {
+        edit_dirty_from = pos;
+    }
+}
+
+/* Only the cursor moved - no text cells change */
+void edit_mark_cursor(void) {
+    if (edit_depth == 0) {
+        update_cursor();
+        return;
+    }
+    edit_cursor_moved = 1;
+}
+
+/* Something other than the text changed, redraw everything */
+void edit_mark_all(void) {
+    if (edit_depth == 0) {
+        refresh_screen();
+        return;
+    }
+    edit_dirty_all = 1;
+}
+
 /* Insert a character at cursor position */
 void insert_char(char c) {
     Page *page = pages[current_page];
+    int start_pos = page->cursor_pos;
     int line_start;
     int indent_count;
-    int check_pos;
     int i;
+    char indent_char;
     
     /* Check if page is full.
      * Why PAGE_SIZE - 1: We reserve one byte as a safety margin to prevent
@@ -20,71 +99,49 @@ void insert_char(char c) {
     /* If inserting newline, handle auto-indentation */
     if (c == '\n') {
         /* Find the start of the current line */
-        line_start = page->cursor_pos;
-        while (line_start > 0 && page->buffer[line_start - 1] != '\n') {
-            line_start--;
-        }
+        line_start = page_line_start(page, page_line_of(page, page->cursor_pos));
         
         /* Count leading spaces/tabs on current line */
         indent_count = 0;
-        check_pos = line_start;
-        while (check_pos < page->length && 
-               (page->buffer[check_pos] == ' ' || page->buffer[check_pos] == '\t')) {
+        while (line_start + indent_count < page->length &&
+               (page_char_at(page, line_start + indent_count) == ' ' ||
+                page_char_at(page, line_start + indent_count) == '\t')) {
             indent_count++;
-            check_pos++;
         }
         
         /* Make sure we have enough space for newline + indentation */
         if (page->length + 1 + indent_count >= PAGE_SIZE - 1) return;
         
-        /* Shift everything after cursor forward to make room for newline + indentation */
-        for (i = page->length + indent_count; i > page->cursor_pos; i--) {
-            page->buffer[i] = page->buffer[i - 1 - indent_count];
-        }
-        
-        /* Insert newline */
-        page->buffer[page->cursor_pos] = '\n';
+        /* Insert newline at the cursor */
+        page_insert(page, page->cursor_pos, "\n", 1);
         page->cursor_pos++;
-        page->length++;
         
-        /* Copy indentation from current line */
+        /* Copy indentation from current line. The current line lies before
+         * the cursor, so inserting at the cursor never moves it. */
         for (i = 0; i < indent_count; i++) {
-            page->buffer[page->cursor_pos] = page->buffer[line_start + i];
+            indent_char = page_char_at(page, line_start + i);
+            page_insert(page, page->cursor_pos, &indent_char, 1);
             page->cursor_pos++;
-            page->length++;
         }
     } else {
         /* Normal character insertion */
-        /* Shift everything after cursor forward */
-        for (i = page->length; i > page->cursor_pos; i--) {
-            page->buffer[i] = page->buffer[i - 1];
-        }
-        
-        /* Insert the character */
-        page->buffer[page->cursor_pos] = c;
+        page_insert(page, page->cursor_pos, &c, 1);
         page->cursor_pos++;
-        page->length++;
     }
     
-    refresh_screen();
+    edit_mark_dirty(start_pos);
 }
 
 /* Delete character before cursor (backspace) */
 void delete_char(void) {
     Page *page = pages[current_page];
-    int i;
     
     if (page->cursor_pos == 0) return;
     
-    /* Shift everything after cursor backward */
-    for (i = page->cursor_pos - 1; i < page->length - 1; i++) {
-        page->buffer[i] = page->buffer[i + 1];
-    }
-    
+    page_delete(page, page->cursor_pos - 1, 1);
     page->cursor_pos--;
-    page->length--;
     
-    refresh_screen();
+    edit_mark_dirty(page->cursor_pos);
 }
 
 /* Move cursor left */
@@ -92,7 +149,7 @@ void move_cursor_left(void) {
     Page *page = pages[current_page];
     if (page->cursor_pos > 0) {
         page->cursor_pos--;
-        refresh_screen();
+        edit_mark_cursor();
     }
 }
 
@@ -101,32 +158,27 @@ void move_cursor_right(void) {
     Page *page = pages[current_page];
     if (page->cursor_pos < page->length) {
         page->cursor_pos++;
-        refresh_screen();
+        edit_mark_cursor();
     }
 }
 
 /* Move cursor up one line */
 void move_cursor_up(void) {
     Page *page = pages[current_page];
+    int line;
     int line_start;
     int prev_line_start;
     int col;
     int prev_line_length;
     
-    /* Find start of current line */
-    line_start = page->cursor_pos;
-    while (line_start > 0 && page->buffer[line_start - 1] != '\n') {
-        line_start--;
-    }
+    /* Find current line from the line index */
+    line = page_line_of(page, page->cursor_pos);
     
     /* If at first line, can't go up */
-    if (line_start == 0) return;
+    if (line == 0) return;
     
-    /* Find start of previous line */
-    prev_line_start = line_start - 1;
-    while (prev_line_start > 0 && page->buffer[prev_line_start - 1] != '\n') {
-        prev_line_start--;
-    }
+    line_start = page_line_start(page, line);
+    prev_line_start = page_line_start(page, line - 1);
     
     /* Calculate position in line */
     col = page->cursor_pos - line_start;
@@ -139,43 +191,30 @@ void move_cursor_up(void) {
         page->cursor_pos = prev_line_start + col;
     }
     
-    refresh_screen();
+    edit_mark_cursor();
 }
 
 /* Move cursor down one line */
 void move_cursor_down(void) {
     Page *page = pages[current_page];
-    int line_end;
-    int line_start;
+    int line;
     int col;
     int next_line_start;
     int next_line_end;
     int next_line_length;
     
-    /* Find end of current line */
-    line_end = page->cursor_pos;
-    while (line_end < page->length && page->buffer[line_end] != '\n') {
-        line_end++;
-    }
+    /* Find current line from the line index */
+    line = page_line_of(page, page->cursor_pos);
     
     /* If at last line, can't go down */
-    if (line_end >= page->length) return;
-    
-    /* Find start of current line */
-    line_start = page->cursor_pos;
-    while (line_start > 0 && page->buffer[line_start - 1] != '\n') {
-        line_start--;
-    }
+    if (line + 1 >= page->line_count) return;
     
     /* Calculate position in line */
-    col = page->cursor_pos - line_start;
+    col = page->cursor_pos - page_line_start(page, line);
     
-    /* Find length of next line */
-    next_line_start = line_end + 1;
-    next_line_end = next_line_start;
-    while (next_line_end < page->length && page->buffer[next_line_end] != '\n') {
-        next_line_end++;
-    }
+    /* Find extent of next line */
+    next_line_start = page_line_start(page, line + 1);
+    next_line_end = page_line_end(page, line + 1);
     
     /* Move to same column in next line */
     next_line_length = next_line_end - next_line_start;
@@ -185,51 +224,39 @@ void move_cursor_down(void) {
         page->cursor_pos = next_line_start + col;
     }
     
-    refresh_screen();
+    edit_mark_cursor();
 }
 
 /* Delete current line */
 void delete_line(void) {
     Page *page = pages[current_page];
+    int line;
     int line_start, line_end;
     int delete_count;
-    int i;
-    
-    /* Find start of current line */
-    line_start = page->cursor_pos;
-    while (line_start > 0 && page->buffer[line_start - 1] != '\n') {
-        line_start--;
-    }
     
-    /* Find end of current line (including newline) */
-    line_end = line_start;
-    while (line_end < page->length && page->buffer[line_end] != '\n') {
-        line_end++;
-    }
-    if (line_end < page->length && page->buffer[line_end] == '\n') {
+    /* Find start and end of current line (including newline) */
+    line = page_line_of(page, page->cursor_pos);
+    line_start = page_line_start(page, line);
+    line_end = page_line_end(page, line);
+    if (line_end < page->length && page_char_at(page, line_end) == '\n') {
         line_end++;  /* Include the newline */
     }
     
     /* Calculate how many characters to delete */
     delete_count = line_end - line_start;
     
-    /* Shift remaining text left */
-    for (i = line_end; i < page->length; i++) {
-        page->buffer[i - delete_count] = page->buffer[i];
-    }
-    
-    /* Update length and cursor */
-    page->length -= delete_count;
+    /* Remove the line and put the cursor where it started */
+    page_delete(page, line_start, delete_count);
     page->cursor_pos = line_start;
     
     /* Move to first non-space character of next line if exists */
     while (page->cursor_pos < page->length && 
-           (page->buffer[page->cursor_pos] == ' ' || 
-            page->buffer[page->cursor_pos] == '\t')) {
+           (page_char_at(page, page->cursor_pos) == ' ' || 
+            page_char_at(page, page->cursor_pos) == '\t')) {
         page->cursor_pos++;
     }
     
-    refresh_screen();
+    edit_mark_dirty(line_start);
 }
 
 /* Delete to end of line */
@@ -237,27 +264,17 @@ void delete_to_eol(void) {
     Page *page = pages[current_page];
     int line_end;
     int delete_count;
-    int i;
     
     /* Find end of current line (not including newline) */
-    line_end = page->cursor_pos;
-    while (line_end < page->length && page->buffer[line_end] != '\n') {
-        line_end++;
-    }
+    line_end = page_line_end(page, page_line_of(page, page->cursor_pos));
     
     /* Calculate how many characters to delete */
     delete_count = line_end - page->cursor_pos;
     
     if (delete_count > 0) {
-        /* Shift remaining text left */
-        for (i = line_end; i < page->length; i++) {
-            page->buffer[i - delete_count] = page->buffer[i];
-        }
-        
-        /* Update length */
-        page->length -= delete_count;
+        page_delete(page, page->cursor_pos, delete_count);
         
-        refresh_screen();
+        edit_mark_dirty(page->cursor_pos);
     }
 }
 
@@ -268,20 +285,16 @@ void delete_to_bol(void) {
     int first_non_ws;
     int delete_start;
     int delete_count;
-    int i;
     
     /* Find start of current line */
-    line_start = page->cursor_pos;
-    while (line_start > 0 && page->buffer[line_start - 1] != '\n') {
-        line_start--;
-    }
+    line_start = page_line_start(page, page_line_of(page, page->cursor_pos));
     
     /* Find first non-whitespace character position */
     first_non_ws = line_start;
     while (first_non_ws < page->length && 
            first_non_ws < page->cursor_pos &&
-           (page->buffer[first_non_ws] == ' ' || 
-            page->buffer[first_non_ws] == '\t')) {
+           (page_char_at(page, first_non_ws) == ' ' || 
+            page_char_at(page, first_non_ws) == '\t')) {
         first_non_ws++;
     }
     
@@ -290,16 +303,11 @@ void delete_to_bol(void) {
     delete_count = page->cursor_pos - delete_start;
     
     if (delete_count > 0) {
-        /* Shift remaining text left */
-        for (i = page->cursor_pos; i < page->length; i++) {
-            page->buffer[i - delete_count] = page->buffer[i];
-        }
-        
-        /* Update length and cursor position */
-        page->length -= delete_count;
+        /* Delete the text and move the cursor to where it started */
+        page_delete(page, delete_start, delete_count);
         page->cursor_pos = delete_start;
         
-        refresh_screen();
+        edit_mark_dirty(delete_start);
     }
 }
 
@@ -308,18 +316,17 @@ void delete_till_char(char target) {
     Page *page = pages[current_page];
     int end_pos;
     int delete_count;
-    int i;
     
     /* Find target character */
     end_pos = page->cursor_pos;
     while (end_pos < page->length && 
-           page->buffer[end_pos] != target && 
-           page->buffer[end_pos] != '\n') {
+           page_char_at(page, end_pos) != target && 
+           page_char_at(page, end_pos) != '\n') {
         end_pos++;
     }
     
     /* Don't delete if we hit newline or end of buffer instead of target */
-    if (end_pos >= page->length || page->buffer[end_pos] != target) {
+    if (end_pos >= page->length || page_char_at(page, end_pos) != target) {
         return;
     }
     
@@ -327,44 +334,33 @@ void delete_till_char(char target) {
     delete_count = end_pos - page->cursor_pos;
     
     if (delete_count > 0) {
-        /* Shift remaining text left */
-        for (i = end_pos; i < page->length; i++) {
-            page->buffer[i - delete_count] = page->buffer[i];
-        }
-        
-        /* Update length */
-        page->length -= delete_count;
+        page_delete(page, page->cursor_pos, delete_count);
         
-        refresh_screen();
+        edit_mark_dirty(page->cursor_pos);
     }
 }
 
 /* Insert new line below current line */
 void insert_line_below(void) {
     Page *page = pages[current_page];
+    int line;
     int line_end;
     int line_start;
     int indent_count;
     int check_pos;
     int i;
+    char indent_char;
     
-    /* Find end of current line */
-    line_end = page->cursor_pos;
-    while (line_end < page->length && page->buffer[line_end] != '\n') {
-        line_end++;
-    }
-    
-    /* Find start of current line to get indentation */
-    line_start = page->cursor_pos;
-    while (line_start > 0 && page->buffer[line_start - 1] != '\n') {
-        line_start--;
-    }
+    /* Find end of current line, and its start to get indentation */
+    line = page_line_of(page, page->cursor_pos);
+    line_end = page_line_end(page, line);
+    line_start = page_line_start(page, line);
     
     /* Count leading spaces/tabs on current line for auto-indent */
     indent_count = 0;
     check_pos = line_start;
     while (check_pos < page->length && 
-           (page->buffer[check_pos] == ' ' || page->buffer[check_pos] == '\t')) {
+           (page_char_at(page, check_pos) == ' ' || page_char_at(page, check_pos) == '\t')) {
         indent_count++;
         check_pos++;
     }
@@ -372,55 +368,40 @@ void insert_line_below(void) {
     /* Check if we have enough space for newline + indentation */
     if (page->length + 1 + indent_count >= PAGE_SIZE - 1) return;
     
-    /* Move cursor to end of current line */
-    page->cursor_pos = line_end;
-    
-    /* Shift everything after line_end forward to make room */
-    for (i = page->length + indent_count; i > line_end; i--) {
-        page->buffer[i] = page->buffer[i - 1 - indent_count];
-    }
-    
-    /* Insert newline */
-    page->buffer[line_end] = '\n';
+    /* Insert newline at the end of the current line */
+    page_insert(page, line_end, "\n", 1);
     page->cursor_pos = line_end + 1;
-    page->length++;
     
     /* Copy indentation from current line (preserving tabs/spaces) */
     for (i = 0; i < indent_count; i++) {
-        page->buffer[page->cursor_pos] = page->buffer[line_start + i];
+        indent_char = page_char_at(page, line_start + i);
+        page_insert(page, page->cursor_pos, &indent_char, 1);
         page->cursor_pos++;
-        page->length++;
     }
     
     /* Enter insert mode */
     set_mode(MODE_INSERT);
-    refresh_screen();
+    edit_mark_dirty(line_end);
 }
 
 /* Insert new line above current line */
 void insert_line_above(void) {
     Page *page = pages[current_page];
     int line_start;
-    int original_line_start;
     int indent_count;
     int check_pos;
-    int i;
     char indent_chars[80];  /* Store indentation characters */
     
     /* Find start of current line */
-    line_start = page->cursor_pos;
-    while (line_start > 0 && page->buffer[line_start - 1] != '\n') {
-        line_start--;
-    }
-    original_line_start = line_start;
+    line_start = page_line_start(page, page_line_of(page, page->cursor_pos));
     
     /* Count and save indentation from current line */
     indent_count = 0;
     check_pos = line_start;
     while (check_pos < page->length && 
-           (page->buffer[check_pos] == ' ' || page->buffer[check_pos] == '\t') &&
+           (page_char_at(page, check_pos) == ' ' || page_char_at(page, check_pos) == '\t') &&
            indent_count < 80) {
-        indent_chars[indent_count] = page->buffer[check_pos];
+        indent_chars[indent_count] = page_char_at(page, check_pos);
         indent_count++;
         check_pos++;
     }
@@ -428,40 +409,15 @@ void insert_line_above(void) {
     /* Check if we have enough space for newline + indentation */
     if (page->length + 1 + indent_count >= PAGE_SIZE - 1) return;
     
-    /* Shift everything from line_start forward to make room for newline + indentation */
-    for (i = page->length + indent_count; i >= line_start; i--) {
-        if (i - 1 - indent_count >= line_start) {
-            page->buffer[i] = page->buffer[i - 1 - indent_count];
-        }
-    }
-    
-    /* Now insert the indentation and newline */
-    if (line_start > 0) {
-        /* Not at beginning - insert indentation then newline */
-        for (i = 0; i < indent_count; i++) {
-            page->buffer[line_start + i] = indent_chars[i];
-        }
-        /* Add newline after indentation */
-        page->buffer[line_start + indent_count] = '\n';
-        /* Position cursor at end of indentation on new line */
-        page->cursor_pos = line_start + indent_count;
-    } else {
-        /* At beginning of buffer */
-        for (i = 0; i < indent_count; i++) {
-            page->buffer[i] = indent_chars[i];
-        }
-        /* Add newline after indentation */
-        page->buffer[indent_count] = '\n';
-        /* Position cursor at end of indentation */
-        page->cursor_pos = indent_count;
-    }
-    
-    /* Update length */
-    page->length += 1 + indent_count;
+    /* Insert the indentation and newline in front of the current line,
+     * leaving the cursor at the end of the indentation on the new line */
+    page_insert(page, line_start, indent_chars, indent_count);
+    page_insert(page, line_start + indent_count, "\n", 1);
+    page->cursor_pos = line_start + indent_count;
     
     /* Enter insert mode */
     set_mode(MODE_INSERT);
-    refresh_screen();
+    edit_mark_dirty(line_start);
 }
 
 /* Move to end of line */
@@ -469,21 +425,18 @@ void move_to_end_of_line(void) {
     Page *page = pages[current_page];
     
     /* Find end of current line */
-    while (page->cursor_pos < page->length && 
-           page->buffer[page->cursor_pos] != '\n') {
-        page->cursor_pos++;
-    }
+    page->cursor_pos = page_line_end(page, page_line_of(page, page->cursor_pos));
     
     /* If not at end of buffer and not on empty line, move back one 
      * to be on last character rather than newline */
     if (page->cursor_pos > 0 && 
         page->cursor_pos < page->length &&
-        page->buffer[page->cursor_pos] == '\n' &&
-        (page->cursor_pos == 0 || page->buffer[page->cursor_pos - 1] != '\n')) {
+        page_char_at(page, page->cursor_pos) == '\n' &&
+        (page->cursor_pos == 0 || page_char_at(page, page->cursor_pos - 1) != '\n')) {
         page->cursor_pos--;
     }
     
-    refresh_screen();
+    edit_mark_cursor();
 }
 
 /* Move to first non-whitespace character of line */
@@ -492,23 +445,20 @@ void move_to_first_non_whitespace(void) {
     int line_start;
     
     /* Find start of current line */
-    line_start = page->cursor_pos;
-    while (line_start > 0 && page->buffer[line_start - 1] != '\n') {
-        line_start--;
-    }
+    line_start = page_line_start(page, page_line_of(page, page->cursor_pos));
     
     /* Move to start of line first */
     page->cursor_pos = line_start;
     
     /* Skip whitespace to find first non-whitespace character */
     while (page->cursor_pos < page->length && 
-           page->buffer[page->cursor_pos] != '\n' &&
-           (page->buffer[page->cursor_pos] == ' ' || 
-            page->buffer[page->cursor_pos] == '\t')) {
+           page_char_at(page, page->cursor_pos) != '\n' &&
+           (page_char_at(page, page->cursor_pos) == ' ' || 
+            page_char_at(page, page->cursor_pos) == '\t')) {
         page->cursor_pos++;
     }
     
-    refresh_screen();
+    edit_mark_cursor();
 }
 
 /* Move forward one word */
@@ -518,22 +468,22 @@ void move_word_forward(void) {
     
     /* Skip current word (alphanumeric chars) */
     while (pos < page->length && 
-           ((page->buffer[pos] >= 'a' && page->buffer[pos] <= 'z') ||
-            (page->buffer[pos] >= 'A' && page->buffer[pos] <= 'Z') ||
-            (page->buffer[pos] >= '0' && page->buffer[pos] <= '9'))) {
+           ((page_char_at(page, pos) >= 'a' && page_char_at(page, pos) <= 'z') ||
+            (page_char_at(page, pos) >= 'A' && page_char_at(page, pos) <= 'Z') ||
+            (page_char_at(page, pos) >= '0' && page_char_at(page, pos) <= '9'))) {
         pos++;
     }
     
     /* Skip whitespace and punctuation to find next word */
     while (pos < page->length && 
-           !((page->buffer[pos] >= 'a' && page->buffer[pos] <= 'z') ||
-             (page->buffer[pos] >= 'A' && page->buffer[pos] <= 'Z') ||
-             (page->buffer[pos] >= '0' && page->buffer[pos] <= '9'))) {
+           !((page_char_at(page, pos) >= 'a' && page_char_at(page, pos) <= 'z') ||
+             (page_char_at(page, pos) >= 'A' && page_char_at(page, pos) <= 'Z') ||
+             (page_char_at(page, pos) >= '0' && page_char_at(page, pos) <= '9'))) {
         pos++;
     }
     
     page->cursor_pos = pos;
-    refresh_screen();
+    edit_mark_cursor();
 }
 
 /* Move backward one word */
@@ -546,20 +496,20 @@ void move_word_backward(void) {
     
     /* Skip whitespace and punctuation backwards */
     while (pos > 0 && 
-           !((page->buffer[pos] >= 'a' && page->buffer[pos] <= 'z') ||
-             (page->buffer[pos] >= 'A' && page->buffer[pos] <= 'Z') ||
-             (page->buffer[pos] >= '0' && page->buffer[pos] <= '9'))) {
+           !((page_char_at(page, pos) >= 'a' && page_char_at(page, pos) <= 'z') ||
+             (page_char_at(page, pos) >= 'A' && page_char_at(page, pos) <= 'Z') ||
+             (page_char_at(page, pos) >= '0' && page_char_at(page, pos) <= '9'))) {
         pos--;
     }
     
     /* Move to beginning of word */
     while (pos > 0 && 
-           ((page->buffer[pos-1] >= 'a' && page->buffer[pos-1] <= 'z') ||
-            (page->buffer[pos-1] >= 'A' && page->buffer[pos-1] <= 'Z') ||
-            (page->buffer[pos-1] >= '0' && page->buffer[pos-1] <= '9'))) {
+           ((page_char_at(page, pos - 1) >= 'a' && page_char_at(page, pos - 1) <= 'z') ||
+            (page_char_at(page, pos - 1) >= 'A' && page_char_at(page, pos - 1) <= 'Z') ||
+            (page_char_at(page, pos - 1) >= '0' && page_char_at(page, pos - 1) <= '9'))) {
         pos--;
     }
     
     page->cursor_pos = pos;
-    refresh_screen();
+    edit_mark_cursor();
 }
\ No newline at end of file
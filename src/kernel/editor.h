@@ -1,6 +1,13 @@
 #ifndef EDITOR_H
 #define EDITOR_H
 
+/* Edit transactions - batch any number of edits into one screen update */
+void edit_begin(void);
+void edit_commit(void);
+void edit_mark_dirty(int pos);
+void edit_mark_cursor(void);
+void edit_mark_all(void);
+
 /* Text editing operations */
 void insert_char(char c);
 void delete_char(void);
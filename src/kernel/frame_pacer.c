@@ -0,0 +1,152 @@
+/* Frame Pacer Implementation */
+
+#include "frame_pacer.h"
+#include "dispi.h"
+#include "timer.h"
+#include "serial.h"
+
+/* Upper bound of each bucket in microseconds; the last is open-ended.
+ * Why these edges: 16.7ms is one refresh at 60Hz and 33.3ms two, so
+ * intervals should pile up in the 16.7ms bucket, and render and flip
+ * times should stay well left of it. */
+#define FRAME_BUDGET_US 16700
+
+static const unsigned int bucket_limits[FRAME_HIST_BUCKETS - 1] = {
+    500, 1000, 2000, 4000, 8000, 12000, 16700, 20000, 33300
+};
+
+static FrameHistogram render_hist;
+static FrameHistogram flip_hist;
+static FrameHistogram interval_hist;
+static unsigned int frames;
+static unsigned int intervals;         /* Samples in interval_hist */
+static unsigned int vsync_waits;       /* Flips that waited for retrace */
+static unsigned int render_start;
+static unsigned int last_flip;         /* Valid once frames > 0 */
+static int use_vsync = 1;
+
+/* Add one sample to a histogram */
+static void frame_hist_add(FrameHistogram *hist, unsigned int us) {
+    int bucket = 0;
+    
+    while (bucket < FRAME_HIST_BUCKETS - 1 && us >= bucket_limits[bucket]) {
+        bucket++;
+    }
+    hist->counts[bucket]++;
+    hist->total_us += us;
+    if (us > hist->max_us) {
+        hist->max_us = us;
+    }
+}
+
+/* Clear a histogram */
+static void frame_hist_clear(FrameHistogram *hist) {
+    int i;
+    
+    for (i = 0; i < FRAME_HIST_BUCKETS; i++) {
+        hist->counts[i] = 0;
+    }
+    hist->total_us = 0;
+    hist->max_us = 0;
+}
+
+/* Start a new set of statistics */
+void frame_pacer_reset(void) {
+    frame_hist_clear(&render_hist);
+    frame_hist_clear(&flip_hist);
+    frame_hist_clear(&interval_hist);
+    frames = 0;
+    intervals = 0;
+    vsync_waits = 0;
+    render_start = get_time_us();
+}
+
+/* Turn waiting for retrace on or off */
+void frame_pacer_set_vsync(int enabled) {
+    use_vsync = enabled;
+}
+
+/* Mark the start of drawing */
+void frame_begin(void) {
+    render_start = get_time_us();
+}
+
+/* Wait for retrace, flip and record.
+ * Why time the flip separately from the wait: the wait is idle time
+ * that only says how early the frame was ready, while the flip is work
+ * done inside the retrace and has to fit in it. */
+void frame_present(void) {
+    unsigned int render_end, flip_start, flip_end;
+    
+    /* Why skip frames with no damage: a redraw that changed nothing
+     * (a hover over a button that is already lit) would otherwise block
+     * for up to a refresh and fill the histograms with empty frames */
+    if (!dispi_has_damage()) {
+        return;
+    }
+    
+    render_end = get_time_us();
+    
+    if (use_vsync && dispi_wait_vsync()) {
+        vsync_waits++;
+    }
+    
+    flip_start = get_time_us();
+    dispi_flip_buffers();
+    flip_end = get_time_us();
+    
+    frame_hist_add(&render_hist, render_end - render_start);
+    frame_hist_add(&flip_hist, flip_end - flip_start);
+    
+    /* Only frames started within a refresh of the last flip are part of
+     * a continuous run; the gap before a redraw after idling says
+     * nothing about pacing */
+    if (frames > 0 && render_start - last_flip < FRAME_BUDGET_US) {
+        frame_hist_add(&interval_hist, flip_start - last_flip);
+        intervals++;
+    }
+    last_flip = flip_start;
+    frames++;
+}
+
+/* Log one histogram as a row of bucket counts */
+static void frame_hist_report(const char *name, const FrameHistogram *hist, unsigned int samples) {
+    int i;
+    
+    serial_write_string(name);
+    for (i = 0; i < FRAME_HIST_BUCKETS; i++) {
+        serial_write_string(" ");
+        serial_write_int(hist->counts[i]);
+    }
+    serial_write_string("  avg ");
+    serial_write_int(samples ? hist->total_us / samples : 0);
+    serial_write_string("us max ");
+    serial_write_int(hist->max_us);
+    serial_write_string("us\n");
+}
+
+/* Log all histograms */
+void frame_pacer_report(void) {
+    int i;
+    
+    serial_write_string("Frames: ");
+    serial_write_int(frames);
+    serial_write_string(", ");
+    serial_write_int(vsync_waits);
+    serial_write_string(" flipped on retrace");
+    if (!dispi_has_vsync()) {
+        serial_write_string(" (no retrace signal)");
+    }
+    serial_write_string("\n");
+    
+    serial_write_string("Bucket upper bounds (us):");
+    for (i = 0; i < FRAME_HIST_BUCKETS - 1; i++) {
+        serial_write_string(" ");
+        serial_write_int(bucket_limits[i]);
+    }
+    serial_write_string(" inf\n");
+    
+    frame_hist_report("  render:  ", &render_hist, frames);
+    frame_hist_report("  flip:    ", &flip_hist, frames);
+    frame_hist_report("  interval:", &interval_hist, intervals);
+}
@@ -0,0 +1,50 @@
+/* Frame Pacer
+ *
+ * DESIGN
+ * ------
+ * The demo loops draw a frame whenever something changed and present it
+ * with frame_present(), which waits for the start of vertical retrace
+ * and flips then. Frames come out at most once per refresh and the flip
+ * happens while nothing is being scanned out, so it doesn't tear. A
+ * frame that left no dirty tiles is not presented or recorded.
+ *
+ * Every presented frame records three times in microseconds:
+ *   render   - frame_begin() to frame_present(), i.e. drawing
+ *   flip     - copying or page-flipping the backbuffer
+ *   interval - flip to flip while frames follow each other, which is
+ *              what the user sees (redraws after an idle pause are
+ *              left out)
+ * They go into histograms with buckets around the 60Hz frame budget.
+ * frame_pacer_report() logs them over COM2 ($frames), so a change that
+ * slows drawing or drops frames shows up as mass moving right.
+ */
+
+#ifndef FRAME_PACER_H
+#define FRAME_PACER_H
+
+#define FRAME_HIST_BUCKETS 10
+
+typedef struct FrameHistogram {
+    unsigned int counts[FRAME_HIST_BUCKETS];
+    unsigned int total_us;
+    unsigned int max_us;
+} FrameHistogram;
+
+/* Start a new set of statistics (each demo calls this on entry) */
+void frame_pacer_reset(void);
+
+/* Wait for retrace before each flip; on by default. With it off, or if
+ * the adapter never shows retrace, frames flip immediately. */
+void frame_pacer_set_vsync(int enabled);
+
+/* Mark the start of drawing a frame */
+void frame_begin(void);
+
+/* Wait for retrace, flip the DISPI buffers and record the frame.
+ * Does nothing if nothing was marked dirty since the last flip. */
+void frame_present(void);
+
+/* Log the render, flip and interval histograms */
+void frame_pacer_report(void);
+
+#endif /* FRAME_PACER_H */
@@ -4,6 +4,8 @@
 #include "memory.h"
 #include "timer.h"
 #include "font_6x8.h"  /* HP 100LX 6x8 pixel font */
+#include "vga.h"
+#include "input_irq.h"
 
 /* VGA font is stored in plane 2 at 0xA0000
  * We need to save it before switching to graphics mode
@@ -468,9 +470,182 @@ void set_mode_03h(void) {
     /* Restore standard DAC palette for proper text mode colors */
     restore_dac_palette();
     
+    /* Graphics mode overwrote text memory, so the next present must
+     * rewrite every cell rather than just the ones that changed */
+    vga_invalidate();
+    
     serial_write_string("Text mode 0x03 restored\n");
 }
 
+/* Chunky shadow buffer.
+ * Why: VRAM in mode 12h is planar, so reading a pixel takes four plane
+ * selects and writing one a handful of register writes, each a port
+ * access (a VM exit under QEMU/KVM). While the shadow is enabled, every
+ * drawing call and read_pixel works on a byte-per-pixel copy of the
+ * screen in system RAM and marks 16x16 tiles dirty; graphics_flush()
+ * then converts the dirty tiles to planar form and writes them one
+ * plane at a time, four Map Mask writes per run of tiles. */
+#define SHADOW_TILE_SIZE    16
+#define SHADOW_TILE_COLS    (VGA_WIDTH_12H / SHADOW_TILE_SIZE)
+#define SHADOW_TILE_ROWS    (VGA_HEIGHT_12H / SHADOW_TILE_SIZE)
+#define SHADOW_TILE_WORDS   ((SHADOW_TILE_COLS + 31) / 32)
+static unsigned char *shadow = NULL;
+static unsigned int shadow_dirty[SHADOW_TILE_ROWS][SHADOW_TILE_WORDS];
+static int shadow_dirty_pending = 0;
+
+/* Chunky-to-planar table: bit p of a color becomes bit 8*p, so eight
+ * shifted lookups OR together into the four plane bytes of 8 pixels */
+static unsigned int c2p_table[16];
+
+/* One tile row converted to planar form, plane by plane */
+static unsigned char shadow_planes[VGA_PLANES][SHADOW_TILE_SIZE][VGA_WIDTH_12H / 8];
+
+/* Mark a rectangle of the shadow dirty (clipped to the screen) */
+static void shadow_mark(int x, int y, int w, int h) {
+    int tx, ty, tx1, tx2, ty1, ty2;
+    
+    if (x < 0) { w += x; x = 0; }
+    if (y < 0) { h += y; y = 0; }
+    if (x + w > VGA_WIDTH_12H) w = VGA_WIDTH_12H - x;
+    if (y + h > VGA_HEIGHT_12H) h = VGA_HEIGHT_12H - y;
+    if (w <= 0 || h <= 0) return;
+    
+    tx1 = x / SHADOW_TILE_SIZE;
+    tx2 = (x + w - 1) / SHADOW_TILE_SIZE;
+    ty1 = y / SHADOW_TILE_SIZE;
+    ty2 = (y + h - 1) / SHADOW_TILE_SIZE;
+    for (ty = ty1; ty <= ty2; ty++) {
+        for (tx = tx1; tx <= tx2; tx++) {
+            shadow_dirty[ty][tx >> 5] |= 1U << (tx & 31);
+        }
+    }
+    shadow_dirty_pending = 1;
+}
+
+/* Convert rows of pixels [x1, x2) (multiples of 8) into shadow_planes */
+static void shadow_convert(int y, int rows, int x1, int x2) {
+    const unsigned char *src;
+    unsigned int planar;
+    int row, x;
+    
+    for (row = 0; row < rows; row++) {
+        src = shadow + (y + row) * VGA_WIDTH_12H;
+        for (x = x1; x < x2; x += 8) {
+            planar = (c2p_table[src[x] & 15] << 7) |
+                     (c2p_table[src[x + 1] & 15] << 6) |
+                     (c2p_table[src[x + 2] & 15] << 5) |
+                     (c2p_table[src[x + 3] & 15] << 4) |
+                     (c2p_table[src[x + 4] & 15] << 3) |
+                     (c2p_table[src[x + 5] & 15] << 2) |
+                     (c2p_table[src[x + 6] & 15] << 1) |
+                     c2p_table[src[x + 7] & 15];
+            shadow_planes[0][row][x >> 3] = (unsigned char)planar;
+            shadow_planes[1][row][x >> 3] = (unsigned char)(planar >> 8);
+            shadow_planes[2][row][x >> 3] = (unsigned char)(planar >> 16);
+            shadow_planes[3][row][x >> 3] = (unsigned char)(planar >> 24);
+        }
+    }
+}
+
+/* Write converted rows to VRAM, one plane at a time */
+static void shadow_write_planes(int y, int rows, int x1, int x2) {
+    unsigned char *vga = (unsigned char *)VGA_GRAPHICS_BUFFER;
+    int plane, row;
+    
+    for (plane = 0; plane < VGA_PLANES; plane++) {
+        outb(0x3C4, 0x02);  /* Map Mask Register */
+        outb(0x3C5, 1 << plane);
+        for (row = 0; row < rows; row++) {
+            memcpy(vga + (y + row) * (VGA_WIDTH_12H / 8) + (x1 >> 3),
+                   &shadow_planes[plane][row][x1 >> 3], (x2 - x1) >> 3);
+        }
+    }
+}
+
+/* Copy the dirty tiles of the shadow buffer to VRAM */
+void graphics_flush(void) {
+    int ty, tx, start;
+    unsigned int *bits;
+    
+    if (!shadow || !shadow_dirty_pending) {
+        return;
+    }
+    
+    /* Plain writes: write mode 0, no Set/Reset, every bit */
+    outb(0x3CE, 0x05);
+    outb(0x3CF, 0x00);
+    outb(0x3CE, 0x01);
+    outb(0x3CF, 0x00);
+    outb(0x3CE, 0x08);
+    outb(0x3CF, 0xFF);
+    
+    for (ty = 0; ty < SHADOW_TILE_ROWS; ty++) {
+        bits = shadow_dirty[ty];
+        tx = 0;
+        while (tx < SHADOW_TILE_COLS) {
+            if (!(bits[tx >> 5] & (1U << (tx & 31)))) {
+                tx++;
+                continue;
+            }
+            start = tx;
+            while (tx < SHADOW_TILE_COLS && (bits[tx >> 5] & (1U << (tx & 31)))) {
+                tx++;
+            }
+            shadow_convert(ty * SHADOW_TILE_SIZE, SHADOW_TILE_SIZE,
+                           start * SHADOW_TILE_SIZE, tx * SHADOW_TILE_SIZE);
+            shadow_write_planes(ty * SHADOW_TILE_SIZE, SHADOW_TILE_SIZE,
+                                start * SHADOW_TILE_SIZE, tx * SHADOW_TILE_SIZE);
+        }
+    }
+    
+    outb(0x3C4, 0x02);
+    outb(0x3C5, 0x0F);  /* Enable all 4 planes again */
+    
+    memset(shadow_dirty, 0, sizeof(shadow_dirty));
+    shadow_dirty_pending = 0;
+}
+
+/* Start drawing into a shadow buffer. It starts out black and is all
+ * dirty, so the first flush writes the whole screen. Returns 0 (and
+ * drawing stays direct to VRAM) if out of memory. */
+int graphics_shadow_enable(void) {
+    int color, plane;
+    
+    if (shadow) {
+        return 1;
+    }
+    
+    shadow = (unsigned char *)malloc(VGA_WIDTH_12H * VGA_HEIGHT_12H);
+    if (!shadow) {
+        serial_write_string("ERROR: No memory for mode 12h shadow buffer\n");
+        return 0;
+    }
+    
+    for (color = 0; color < 16; color++) {
+        c2p_table[color] = 0;
+        for (plane = 0; plane < VGA_PLANES; plane++) {
+            if (color & (1 << plane)) {
+                c2p_table[color] |= 1U << (8 * plane);
+            }
+        }
+    }
+    
+    memset(shadow, 0, VGA_WIDTH_12H * VGA_HEIGHT_12H);
+    shadow_mark(0, 0, VGA_WIDTH_12H, VGA_HEIGHT_12H);
+    return 1;
+}
+
+/* Flush and free the shadow buffer; drawing goes straight to VRAM again */
+void graphics_shadow_disable(void) {
+    if (!shadow) {
+        return;
+    }
+    
+    graphics_flush();
+    free(shadow);
+    shadow = NULL;
+}
+
 /* Read a pixel value from VGA memory */
 unsigned char read_pixel(int x, int y) {
     unsigned char *vga = (unsigned char *)VGA_GRAPHICS_BUFFER;
@@ -483,6 +658,10 @@ unsigned char read_pixel(int x, int y) {
         return 0;
     }
     
+    if (shadow) {
+        return shadow[y * VGA_WIDTH_12H + x];
+    }
+    
     offset = (y * (VGA_WIDTH_12H / 8)) + (x / 8);
     mask = 0x80 >> (x & 7);
     
@@ -509,6 +688,12 @@ void set_pixel(int x, int y, unsigned char color) {
         return;
     }
     
+    if (shadow) {
+        shadow[y * VGA_WIDTH_12H + x] = color & 0x0F;
+        shadow_mark(x, y, 1, 1);
+        return;
+    }
+    
     offset = (y * (VGA_WIDTH_12H / 8)) + (x / 8);
     mask = 0x80 >> (x & 7);  /* Single pixel bit mask */
     
@@ -545,14 +730,213 @@ void set_pixel(int x, int y, unsigned char color) {
     outb(0x3CF, 0xFF);
 }
 
-void draw_rectangle(int x, int y, int width, int height, unsigned char color) {
+/* Byte-granular drawing in write mode 3.
+ * Why: set_pixel programs about ten VGA registers for every pixel, and
+ * each port write is a VM exit under QEMU/KVM. In write mode 3 the color
+ * comes from the Set/Reset register and the byte the CPU writes is the
+ * bit mask, so after one register setup per color a whole byte of pixels
+ * (a glyph row, or eight pixels of a span) costs a latch read and one
+ * memory write. Calls go between vga12_begin() and vga12_end(). With
+ * the shadow buffer enabled they write its pixels instead, and the
+ * callers mark what they drew dirty. */
+#define VGA12_BYTES_PER_ROW (VGA_WIDTH_12H / 8)
+static int planar_text_enabled = 1;
+static unsigned char vga12_color = 0;
+
+/* Select write mode 3 with all planes and all bits enabled */
+static void vga12_begin(void) {
+    if (shadow) return;
+    
+    outb(0x3CE, 0x05);  /* Graphics Mode Register */
+    outb(0x3CF, 0x03);  /* Write mode 3 */
+    outb(0x3C4, 0x02);  /* Map Mask Register */
+    outb(0x3C5, 0x0F);  /* Enable all 4 planes */
+    outb(0x3CE, 0x08);  /* Bit Mask Register */
+    outb(0x3CF, 0xFF);  /* Masking comes from the CPU byte */
+}
+
+/* Color for the writes that follow */
+static void vga12_set_color(unsigned char color) {
+    vga12_color = color & 0x0F;
+    if (shadow) return;
+    
+    outb(0x3CE, 0x00);  /* Set/Reset Register */
+    outb(0x3CF, color);
+}
+
+/* Back to write mode 0 with Set/Reset off, as everything else expects */
+static void vga12_end(void) {
+    if (shadow) return;
+    
+    outb(0x3CE, 0x05);
+    outb(0x3CF, 0x00);
+    outb(0x3CE, 0x01);
+    outb(0x3CF, 0x00);
+    outb(0x3CE, 0x08);
+    outb(0x3CF, 0xFF);
+}
+
+/* Set the pixels of one byte that are 1 in bits to the current color.
+ * The read loads the latches so the other pixels keep their colors. */
+static void vga12_write_bits(unsigned int offset, unsigned char bits) {
+    volatile unsigned char *vga = (volatile unsigned char *)VGA_GRAPHICS_BUFFER;
+    unsigned char latch;
+    
+    if (!bits) return;
+    
+    if (shadow) {
+        unsigned char *pixels = shadow + offset * 8;
+        int bit;
+    
+        for (bit = 0; bit < 8; bit++) {
+            if (bits & (0x80 >> bit)) {
+                pixels[bit] = vga12_color;
+            }
+        }
+        return;
+    }
+    
+    latch = vga[offset];
+    (void)latch;
+    vga[offset] = bits;
+}
+
+/* Set up to 16 pixels of row y starting at x: bit 15 of bits is column x */
+static void vga12_row_bits(int x, int y, unsigned int bits) {
+    unsigned int offset;
+    unsigned int spread;
+    int byte;
+    
+    if (y < 0 || y >= VGA_HEIGHT_12H || x >= VGA_WIDTH_12H) return;
+    if (x < 0) {
+        if (x <= -16) return;
+        bits = (bits << -x) & 0xFFFF;
+        x = 0;
+    }
+    
+    /* Three bytes cover 16 bits at any alignment; bytes past the right
+     * edge would wrap onto the next row, so they are dropped */
+    spread = (bits << 8) >> (x & 7);
+    byte = x >> 3;
+    offset = y * VGA12_BYTES_PER_ROW + byte;
+    vga12_write_bits(offset, (unsigned char)(spread >> 16));
+    if (byte + 1 < VGA12_BYTES_PER_ROW) {
+        vga12_write_bits(offset + 1, (unsigned char)(spread >> 8));
+    }
+    if (byte + 2 < VGA12_BYTES_PER_ROW) {
+        vga12_write_bits(offset + 2, (unsigned char)spread);
+    }
+}
+
+/* Set pixels x1..x2 of row y (already clipped) to the current color */
+static void vga12_span(int x1, int x2, int y) {
     unsigned char *vga = (unsigned char *)VGA_GRAPHICS_BUFFER;
-    int row, col;
+    unsigned int offset = y * VGA12_BYTES_PER_ROW;
+    int start_byte = x1 >> 3;
+    int end_byte = x2 >> 3;
+    
+    if (shadow) {
+        memset(shadow + y * VGA_WIDTH_12H + x1, vga12_color, x2 - x1 + 1);
+        return;
+    }
+    
+    if (start_byte == end_byte) {
+        vga12_write_bits(offset + start_byte,
+                         (0xFF >> (x1 & 7)) & (0xFF << (7 - (x2 & 7))));
+        return;
+    }
+    
+    vga12_write_bits(offset + start_byte, 0xFF >> (x1 & 7));
+    /* Whole bytes need no latch read: every bit is replaced */
+    if (end_byte > start_byte + 1) {
+        memset(&vga[offset + start_byte + 1], 0xFF, end_byte - start_byte - 1);
+    }
+    vga12_write_bits(offset + end_byte, 0xFF << (7 - (x2 & 7)));
+}
+
+/* Draw a glyph cell from rows of foreground bits (bit 15 = left column),
+ * cell bits wide: the background pass first, then the foreground */
+static void vga12_glyph(int x, int y, const unsigned short *rows, int height,
+                        int cell, unsigned char fg, unsigned char bg) {
+    unsigned int cell_bits = (0xFFFF0000U >> cell) & 0xFFFF;
+    int row;
+    
+    if (shadow) {
+        shadow_mark(x, y, cell, height);
+    }
+    
+    if (bg != COLOR_TRANSPARENT) {
+        vga12_set_color(bg);
+        for (row = 0; row < height; row++) {
+            vga12_row_bits(x, y + row, cell_bits & ~rows[row]);
+        }
+    }
+    
+    vga12_set_color(fg);
+    for (row = 0; row < height; row++) {
+        vga12_row_bits(x, y + row, rows[row] & cell_bits);
+    }
+}
+
+/* Check if character is a box-drawing character */
+static int is_box_drawing(unsigned char c) {
+    return (c >= 0xB0 && c <= 0xDF);  /* Box drawing range in CP437 */
+}
+
+/* Draw a BIOS font character in write mode 3; see draw_char_extended */
+static void vga12_char_extended(int x, int y, unsigned char c,
+                                unsigned char fg, unsigned char bg,
+                                int char_spacing) {
+    unsigned short rows[CHAR_HEIGHT];
+    unsigned char *char_data = saved_font + (c * 32);
+    int extend_8th = char_spacing > 8 && is_box_drawing(c);
+    int cell = char_spacing < 16 ? char_spacing : 16;
+    int row;
+    
+    /* All 8 font columns are drawn even when spacing is tighter */
+    if (cell < 8) cell = 8;
+    
+    for (row = 0; row < CHAR_HEIGHT; row++) {
+        rows[row] = (unsigned short)(char_data[row] << 8);
+        if (extend_8th && (char_data[row] & 0x01)) {
+            rows[row] |= 0x80;  /* 9th column repeats the 8th */
+        }
+    }
+    vga12_glyph(x, y, rows, CHAR_HEIGHT, cell, fg, bg);
+    
+    /* Spacing wider than 16 pixels is all background */
+    if (char_spacing > 16 && bg != COLOR_TRANSPARENT) {
+        if (shadow) {
+            shadow_mark(x + 16, y, char_spacing - 16, CHAR_HEIGHT);
+        }
+        vga12_set_color(bg);
+        for (row = 0; row < CHAR_HEIGHT; row++) {
+            vga12_row_bits(x + 16, y + row,
+                           (0xFFFF0000U >> (char_spacing - 16)) & 0xFFFF);
+        }
+    }
+}
+
+/* Draw a 6x8 font character in write mode 3 */
+static void vga12_char_6x8(int x, int y, unsigned char c,
+                           unsigned char fg, unsigned char bg) {
+    unsigned short rows[FONT_hp100lx_HEIGHT];
+    int row;
+    
+    for (row = 0; row < FONT_hp100lx_HEIGHT; row++) {
+        rows[row] = (unsigned short)(font_hp100lx_6x8[c][row] << 8);
+    }
+    vga12_glyph(x, y, rows, FONT_hp100lx_HEIGHT, FONT_hp100lx_WIDTH, fg, bg);
+}
+
+/* Choose write mode 3 text (1, the default) or the per-pixel path */
+void graphics_set_planar_text(int enabled) {
+    planar_text_enabled = enabled;
+}
+
+void draw_rectangle(int x, int y, int width, int height, unsigned char color) {
+    int row;
     int x1, x2, y1, y2;
-    int start_byte, end_byte;
-    unsigned int offset;
-    unsigned char mask;
-    volatile unsigned char dummy;  /* For latch operations */
     
     if (x >= VGA_WIDTH_12H || y >= VGA_HEIGHT_12H) return;
     if (width <= 0 || height <= 0) return;
@@ -567,80 +951,19 @@ void draw_rectangle(int x, int y, int width, int height, unsigned char color) {
     if (y1 < 0) y1 = 0;
     if (x2 >= VGA_WIDTH_12H) x2 = VGA_WIDTH_12H - 1;
     if (y2 >= VGA_HEIGHT_12H) y2 = VGA_HEIGHT_12H - 1;
+    if (x2 < x1 || y2 < y1) return;
     
-    /* Set up VGA for efficient filled rectangle drawing */
-    
-    /* Set Graphics Mode to Write Mode 0 */
-    outb(0x3CE, 0x05);  /* Graphics Mode Register */
-    outb(0x3CF, 0x00);  /* Write mode 0 */
-    
-    /* Enable all planes for writing */
-    outb(0x3C4, 0x02);  /* Map Mask Register */
-    outb(0x3C5, 0x0F);  /* Enable all 4 planes */
-    
-    /* Set the color in the Set/Reset register */
-    outb(0x3CE, 0x00);  /* Set/Reset Register */
-    outb(0x3CF, color); /* Color value to be used for all planes */
-    
-    /* Enable Set/Reset for all planes */
-    outb(0x3CE, 0x01);  /* Enable Set/Reset Register */
-    outb(0x3CF, 0x0F);  /* Enable Set/Reset for all 4 planes */
+    if (shadow) {
+        shadow_mark(x1, y1, x2 - x1 + 1, y2 - y1 + 1);
+    }
     
-    /* Draw the rectangle row by row */
+    /* One register setup for the whole rectangle, then one span per row */
+    vga12_begin();
+    vga12_set_color(color);
     for (row = y1; row <= y2; row++) {
-        start_byte = x1 / 8;
-        end_byte = x2 / 8;
-        offset = row * (VGA_WIDTH_12H / 8);
-        
-        if (start_byte == end_byte) {
-            /* Rectangle fits within a single byte */
-            mask = (0xFF >> (x1 & 7)) & (0xFF << (7 - (x2 & 7)));
-            outb(0x3CE, 0x08);  /* Bit Mask Register */
-            outb(0x3CF, mask);
-            /* Read to latch, then write back latched value */
-            dummy = vga[offset + start_byte];
-            vga[offset + start_byte] = dummy;  /* Write back latched value */
-        } else {
-            /* First byte (partial) */
-            if (x1 & 7) {  /* Only if not byte-aligned */
-                mask = 0xFF >> (x1 & 7);
-                outb(0x3CE, 0x08);  /* Bit Mask Register */
-                outb(0x3CF, mask);
-                dummy = vga[offset + start_byte];
-                vga[offset + start_byte] = dummy;  /* Write back latched value */
-                start_byte++;
-            }
-            
-            /* Middle bytes (full bytes) - only if there are bytes between first and last */
-            if (start_byte < end_byte) {  /* Changed condition - now correctly checks for middle bytes */
-                outb(0x3CE, 0x08);  /* Bit Mask Register */
-                outb(0x3CF, 0xFF);  /* All pixels in byte */
-                /* Use memset for faster filling of middle bytes */
-                memset(&vga[offset + start_byte], 0x00, end_byte - start_byte);
-            }
-            
-            /* Last byte (partial or full) */
-            if ((x2 & 7) != 7) {  /* Last byte is partial */
-                mask = 0xFF << (7 - (x2 & 7));
-                outb(0x3CE, 0x08);  /* Bit Mask Register */
-                outb(0x3CF, mask);
-                dummy = vga[offset + end_byte];
-                vga[offset + end_byte] = dummy;  /* Write back latched value */
-            } else {
-                /* Last byte is full */
-                outb(0x3CE, 0x08);  /* Bit Mask Register */
-                outb(0x3CF, 0xFF);  /* All pixels */
-                dummy = vga[offset + end_byte];  /* Latch first */
-                vga[offset + end_byte] = dummy;  /* Then write back latched value */
-            }
-        }
+        vga12_span(x1, x2, row);
     }
-    
-    /* Restore default state */
-    outb(0x3CE, 0x01);  /* Enable Set/Reset Register */
-    outb(0x3CF, 0x00);  /* Disable Set/Reset */
-    outb(0x3CE, 0x08);  /* Bit Mask Register */
-    outb(0x3CF, 0xFF);  /* Enable all bits */
+    vga12_end();
 }
 
 /* Simple abs implementation for freestanding environment */
@@ -706,11 +1029,6 @@ void draw_circle(int cx, int cy, int radius, unsigned char color) {
     }
 }
 
-/* Check if character is a box-drawing character */
-static int is_box_drawing(unsigned char c) {
-    return (c >= 0xB0 && c <= 0xDF);  /* Box drawing range in CP437 */
-}
-
 /* Draw character with proper spacing and optional background */
 void draw_char_extended(int x, int y, unsigned char c, 
                         unsigned char fg, unsigned char bg,
@@ -724,6 +1042,13 @@ void draw_char_extended(int x, int y, unsigned char c,
         return;  /* No font available */
     }
     
+    if (planar_text_enabled) {
+        vga12_begin();
+        vga12_char_extended(x, y, c, fg, bg, char_spacing);
+        vga12_end();
+        return;
+    }
+    
     /* In VGA, each character is 32 bytes (16 rows, with padding) */
     char_data = saved_font + (c * 32);
     extend_8th = is_box_drawing(c);
@@ -766,6 +1091,13 @@ void draw_char_6x8(int x, int y, unsigned char c,
     int row, col;
     unsigned char byte;
     
+    if (planar_text_enabled) {
+        vga12_begin();
+        vga12_char_6x8(x, y, c, fg, bg);
+        vga12_end();
+        return;
+    }
+    
     /* Get character bitmap from 6x8 font */
     char_data = font_hp100lx_6x8[c];
     
@@ -789,6 +1121,11 @@ void draw_string_6x8(int x, int y, const char *str,
     int orig_x = x;
     const char *p = str;
     
+    /* Registers are set up once for the string, not per character */
+    if (planar_text_enabled) {
+        vga12_begin();
+    }
+    
     while (*p) {
         if (*p == '\n') {
             /* Handle newline */
@@ -801,11 +1138,19 @@ void draw_string_6x8(int x, int y, const char *str,
             x = orig_x + (next_tab * FONT_hp100lx_WIDTH);
         } else {
             /* Draw character */
-            draw_char_6x8(x, y, (unsigned char)*p, fg, bg);
+            if (planar_text_enabled) {
+                vga12_char_6x8(x, y, (unsigned char)*p, fg, bg);
+            } else {
+                draw_char_6x8(x, y, (unsigned char)*p, fg, bg);
+            }
             x += FONT_hp100lx_WIDTH;
         }
         p++;
     }
+    
+    if (planar_text_enabled) {
+        vga12_end();
+    }
 }
 
 /* Legacy function - now calls extended version */
@@ -824,6 +1169,10 @@ void draw_text_spaced(int x, int y, const char *text,
         return;  /* No font available */
     }
     
+    if (planar_text_enabled) {
+        vga12_begin();
+    }
+    
     while (*p) {
         if (*p == '\n') {
             /* Handle newline */
@@ -836,11 +1185,19 @@ void draw_text_spaced(int x, int y, const char *text,
             x = orig_x + (next_tab * char_spacing);
         } else {
             /* Draw the character with proper spacing */
-            draw_char_extended(x, y, (unsigned char)*p, fg, bg, char_spacing);
+            if (planar_text_enabled) {
+                vga12_char_extended(x, y, (unsigned char)*p, fg, bg, char_spacing);
+            } else {
+                draw_char_extended(x, y, (unsigned char)*p, fg, bg, char_spacing);
+            }
             x += char_spacing;
         }
         p++;
     }
+    
+    if (planar_text_enabled) {
+        vga12_end();
+    }
 }
 
 /* Legacy draw_string - now uses proper spacing */
@@ -1081,6 +1438,12 @@ void clear_graphics_screen(unsigned char color) {
     int plane, i;
     unsigned char fill_value;
     
+    if (shadow) {
+        memset(shadow, color & 0x0F, VGA_WIDTH_12H * VGA_HEIGHT_12H);
+        shadow_mark(0, 0, VGA_WIDTH_12H, VGA_HEIGHT_12H);
+        return;
+    }
+    
     for (plane = 0; plane < 4; plane++) {
         outb(0x3C4, 0x02);
         outb(0x3C5, 1 << plane);
@@ -1167,6 +1530,10 @@ void graphics_demo(void) {
     /* Set our custom Aquinas palette */
     set_aquinas_palette();
     
+    /* Draw in system RAM and flush dirty tiles once per loop; without
+     * the memory for it, drawing simply goes straight to VRAM */
+    graphics_shadow_enable();
+    
     /* Clear screen with medium gray background */
     clear_graphics_screen(COLOR_BACKGROUND);
     
@@ -1252,16 +1619,16 @@ void graphics_demo(void) {
     last_frame_time = get_ticks();
     
     while (running) {
-        unsigned char scancode;
+        InputRawEvent key;
         
         /* Poll for mouse movement */
         poll_mouse();
         
         /* Check for keyboard input - only handle ESC to exit */
-        scancode = inb(0x60);
-        
-        if (scancode == 0x01) { /* ESC - exit */
-            running = 0;
+        while (input_keyboard_pop(&key)) {
+            if (key.data == 0x01) { /* ESC - exit */
+                running = 0;
+            }
         }
         
         /* Get current time */
@@ -1313,11 +1680,15 @@ void graphics_demo(void) {
             /* Update last frame time */
             last_frame_time = current_time;
         }
+    
+        /* Show this pass's animation and cursor moves */
+        graphics_flush();
     }
     
     /* Hide cursor before switching modes */
     hide_mouse_cursor();
     graphics_mode_active = 0;  /* Clear flag */
+    graphics_shadow_disable();
     
     set_mode_03h();
     
@@ -35,6 +35,10 @@ void draw_char_6x8(int x, int y, unsigned char c, unsigned char fg, unsigned cha
 void draw_string_6x8(int x, int y, const char *str, unsigned char fg, unsigned char bg);
 void draw_text_centered(int y, const char *text, unsigned char fg, unsigned char bg);
 void draw_text_right_aligned(int right_x, int y, const char *text, unsigned char fg, unsigned char bg);
+
+/* Text is drawn a byte of pixels at a time in write mode 3 unless this
+ * is turned off (for benchmarks); 1 by default */
+void graphics_set_planar_text(int enabled);
 void text_pos_to_pixels(int col, int row, int *x, int *y);
 int get_text_width(const char *str);
 void clear_graphics_screen(unsigned char color);
@@ -43,6 +47,15 @@ void restore_vga_font(void);
 void restore_dac_palette(void);
 void set_aquinas_palette(void);
 
+/* Optional 640x480 byte-per-pixel shadow of the mode 12h screen in
+ * system RAM. While enabled, all drawing and read_pixel use it, and
+ * graphics_flush() converts the tiles drawn since the last flush to
+ * planar form and writes them to VRAM. enable returns 0 if out of
+ * memory; disable flushes first. */
+int graphics_shadow_enable(void);
+void graphics_shadow_disable(void);
+void graphics_flush(void);
+
 /* Mouse cursor functions */
 void init_mouse_cursor(void);
 void show_mouse_cursor(void);
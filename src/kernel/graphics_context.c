@@ -7,7 +7,10 @@
  * - Clipping: All drawing operations are automatically clipped to bounds
  * - Translation: Coordinates are automatically translated by offset
  * - Pattern fills: Support for 8x8 tiled patterns
- * - Integration with DISPI: Uses existing DISPI primitives under the hood
+ * - Text runs: Clipped per glyph column, drawn a scanline at a time
+ * - Surfaces: Any 8bpp Surface can stand in for the display
+ * - Direct pixels: When the driver exposes its page as a surface, spans
+ *   are written straight into it instead of a call per pixel
  */
 
 #include "graphics_context.h"
@@ -15,6 +18,9 @@
 #include "dispi.h"
 #include <stddef.h>
 
+/* Where gc_pixels() found the pixels */
+enum { GC_DRIVER, GC_SURFACE, GC_SCREEN };
+
 /* Create a new graphics context */
 GraphicsContext* gc_create(DisplayDriver *driver) {
     GraphicsContext *gc = (GraphicsContext*)malloc(sizeof(GraphicsContext));
@@ -36,6 +42,7 @@ void gc_init(GraphicsContext *gc, DisplayDriver *driver) {
     if (!gc) return;
     
     gc->driver = driver;
+    gc->surface = NULL;
     
     /* Initialize to full screen bounds */
     gc_clear_clip(gc);
@@ -51,9 +58,63 @@ void gc_init(GraphicsContext *gc, DisplayDriver *driver) {
     gc->current_pattern = NULL;
 }
 
+/* Initialize a context that only ever draws into a surface */
+void gc_init_surface(GraphicsContext *gc, Surface *surface) {
+    if (!gc) return;
+    
+    gc_init(gc, NULL);
+    gc_set_surface(gc, surface);
+}
+
+/* A context needs a surface or a driver before it can draw */
+static int gc_can_draw(GraphicsContext *gc) {
+    return gc && (gc->surface || gc->driver);
+}
+
+/* Size of whatever the context draws into */
+static int gc_target_width(GraphicsContext *gc) {
+    return gc->surface ? gc->surface->width : gc->driver->width;
+}
+
+static int gc_target_height(GraphicsContext *gc) {
+    return gc->surface ? gc->surface->height : gc->driver->height;
+}
+
+/* Find the pixels the context draws into: its own surface, or the
+ * driver's page if the driver exposes one. Returns GC_DRIVER when the
+ * display can only be reached through the driver's function pointers.
+ * Why: set_pixel costs an indirect call per pixel, and pattern fills
+ * and filled circles went through it for every pixel they touched.
+ * With the pixels in hand a span is a memset. */
+static int gc_pixels(GraphicsContext *gc, Surface *out) {
+    if (gc->surface) {
+        *out = *gc->surface;
+        return GC_SURFACE;
+    }
+    if (gc->driver && gc->driver->get_surface && gc->driver->get_surface(out)) {
+        return GC_SCREEN;
+    }
+    return GC_DRIVER;
+}
+
+/* Screen pixels written directly must be marked for the next flip */
+static void gc_mark(int kind, int x, int y, int w, int h) {
+    if (kind == GC_SCREEN) {
+        dispi_mark_dirty(x, y, w, h);
+    }
+}
+
+/* Redirect drawing to a surface, or back to the display */
+void gc_set_surface(GraphicsContext *gc, Surface *surface) {
+    if (!gc) return;
+    
+    gc->surface = surface;
+    gc_clear_clip(gc);
+}
+
 /* Set clipping bounds */
 void gc_set_clip(GraphicsContext *gc, int x, int y, int w, int h) {
-    if (!gc) return;
+    if (!gc_can_draw(gc)) return;
     
     /* Clamp to screen bounds */
     if (x < 0) {
@@ -65,11 +126,11 @@ void gc_set_clip(GraphicsContext *gc, int x, int y, int w, int h) {
         y = 0;
     }
     
-    if (x + w > gc->driver->width) {
-        w = gc->driver->width - x;
+    if (x + w > gc_target_width(gc)) {
+        w = gc_target_width(gc) - x;
     }
-    if (y + h > gc->driver->height) {
-        h = gc->driver->height - y;
+    if (y + h > gc_target_height(gc)) {
+        h = gc_target_height(gc) - y;
     }
     
     /* Ensure valid bounds */
@@ -94,12 +155,12 @@ void gc_get_clip(GraphicsContext *gc, int *x, int *y, int *w, int *h) {
 
 /* Clear clipping (reset to full screen) */
 void gc_clear_clip(GraphicsContext *gc) {
-    if (!gc || !gc->driver) return;
+    if (!gc_can_draw(gc)) return;
     
     gc->clip_x = 0;
     gc->clip_y = 0;
-    gc->clip_w = gc->driver->width;
-    gc->clip_h = gc->driver->height;
+    gc->clip_w = gc_target_width(gc);
+    gc->clip_h = gc_target_height(gc);
 }
 
 /* Set translation offset */
@@ -296,11 +357,33 @@ static int gc_point_visible(GraphicsContext *gc, int x, int y) {
             y >= gc->clip_y && y < gc->clip_y + gc->clip_h);
 }
 
+/* Store a translated pixel in pixels if it is inside the clip */
+static void gc_plot(GraphicsContext *gc, Surface *pixels, int x, int y, unsigned char color) {
+    if (gc_point_visible(gc, x, y)) {
+        pixels->pixels[y * pixels->stride + x] = color;
+    }
+}
+
+/* Fill the translated, already clipped span x1..x2 of row y */
+static void gc_span(GraphicsContext *gc, int kind, Surface *pixels,
+                    int x1, int x2, int y, unsigned char color) {
+    if (x1 > x2) return;
+    
+    if (kind == GC_DRIVER) {
+        gc->driver->fill_rect(x1, y, x2 - x1 + 1, 1, color);
+    } else {
+        memset(pixels->pixels + y * pixels->stride + x1, color, x2 - x1 + 1);
+    }
+}
+
 /* Context-aware drawing functions */
 
 /* Set a pixel with context transformation and clipping */
 void gc_set_pixel(GraphicsContext *gc, int x, int y, unsigned char color) {
-    if (!gc || !gc->driver) return;
+    Surface pixels;
+    int kind;
+    
+    if (!gc_can_draw(gc)) return;
     
     /* Apply translation */
     gc_apply_translation(gc, &x, &y);
@@ -311,12 +394,20 @@ void gc_set_pixel(GraphicsContext *gc, int x, int y, unsigned char color) {
     }
     
     /* Draw the pixel */
-    gc->driver->set_pixel(x, y, color);
+    kind = gc_pixels(gc, &pixels);
+    if (kind == GC_DRIVER) {
+        gc->driver->set_pixel(x, y, color);
+        return;
+    }
+    pixels.pixels[y * pixels.stride + x] = color;
+    gc_mark(kind, x, y, 1, 1);
 }
 
 /* Get a pixel with context transformation and clipping */
 unsigned char gc_get_pixel(GraphicsContext *gc, int x, int y) {
-    if (!gc || !gc->driver) return 0;
+    Surface pixels;
+    
+    if (!gc_can_draw(gc)) return 0;
     
     /* Apply translation */
     gc_apply_translation(gc, &x, &y);
@@ -326,12 +417,18 @@ unsigned char gc_get_pixel(GraphicsContext *gc, int x, int y) {
         return 0;
     }
     
-    return gc->driver->get_pixel(x, y);
+    if (gc_pixels(gc, &pixels) == GC_DRIVER) {
+        return gc->driver->get_pixel(x, y);
+    }
+    return pixels.pixels[y * pixels.stride + x];
 }
 
 /* Draw a line with context transformation and clipping */
 void gc_draw_line(GraphicsContext *gc, int x0, int y0, int x1, int y1, unsigned char color) {
-    if (!gc || !gc->driver) return;
+    Surface pixels;
+    int kind, dx, dy, sx, sy, err, e2;
+    
+    if (!gc_can_draw(gc)) return;
     
     /* Apply translation */
     gc_apply_translation(gc, &x0, &y0);
@@ -342,13 +439,71 @@ void gc_draw_line(GraphicsContext *gc, int x0, int y0, int x1, int y1, unsigned
         return;  /* Line is completely outside clip bounds */
     }
     
-    /* Use DISPI line drawing function */
-    dispi_draw_line(x0, y0, x1, y1, color);
+    kind = gc_pixels(gc, &pixels);
+    if (kind == GC_DRIVER) {
+        /* Use DISPI line drawing function */
+        dispi_draw_line(x0, y0, x1, y1, color);
+        return;
+    }
+    
+    dx = x1 > x0 ? x1 - x0 : x0 - x1;
+    dy = y1 > y0 ? y1 - y0 : y0 - y1;
+    gc_mark(kind, x0 < x1 ? x0 : x1, y0 < y1 ? y0 : y1, dx + 1, dy + 1);
+    
+    if (dy == 0) {
+        /* Horizontal lines (half of every rectangle edge) are one span */
+        gc_span(gc, kind, &pixels, x0 < x1 ? x0 : x1, x0 < x1 ? x1 : x0, y0, color);
+        return;
+    }
+    
+    /* Bresenham; the ends are already clipped */
+    sx = x0 < x1 ? 1 : -1;
+    sy = y0 < y1 ? 1 : -1;
+    err = dx - dy;
+    for (;;) {
+        pixels.pixels[y0 * pixels.stride + x0] = color;
+        if (x0 == x1 && y0 == y1) break;
+        e2 = 2 * err;
+        if (e2 > -dy) {
+            err -= dy;
+            x0 += sx;
+        }
+        if (e2 < dx) {
+            err += dx;
+            y0 += sy;
+        }
+    }
 }
 
-/* Draw a rectangle outline with context transformation and clipping */
+/* Draw a rectangle outline with context transformation and clipping.
+ * Each edge is clipped as a line, so a clip cutting through the
+ * rectangle doesn't draw an edge along the clip boundary. */
 void gc_draw_rect(GraphicsContext *gc, int x, int y, int w, int h, unsigned char color) {
-    if (!gc || !gc->driver) return;
+    if (!gc_can_draw(gc) || w <= 0 || h <= 0) return;
+    
+    /* Top edge */
+    gc_draw_line(gc, x, y, x + w - 1, y, color);
+    /* Bottom edge */
+    if (h > 1) {
+        gc_draw_line(gc, x, y + h - 1, x + w - 1, y + h - 1, color);
+    }
+    /* Left edge */
+    if (h > 2) {
+        gc_draw_line(gc, x, y + 1, x, y + h - 2, color);
+    }
+    /* Right edge */
+    if (w > 1 && h > 2) {
+        gc_draw_line(gc, x + w - 1, y + 1, x + w - 1, y + h - 2, color);
+    }
+}
+
+/* Fill a rectangle with solid color, respecting context transformation and clipping */
+void gc_fill_rect(GraphicsContext *gc, int x, int y, int w, int h, unsigned char color) {
+    Surface pixels;
+    unsigned char *row;
+    int kind, i;
+    
+    if (!gc_can_draw(gc)) return;
     
     /* Apply translation */
     gc_apply_translation(gc, &x, &y);
@@ -358,49 +513,124 @@ void gc_draw_rect(GraphicsContext *gc, int x, int y, int w, int h, unsigned char
         return;  /* Rectangle is completely outside clip bounds */
     }
     
-    /* Draw four lines to form the rectangle outline */
-    if (w > 0 && h > 0) {
-        /* Top edge */
-        dispi_draw_line(x, y, x + w - 1, y, color);
-        /* Bottom edge */
-        if (h > 1) {
-            dispi_draw_line(x, y + h - 1, x + w - 1, y + h - 1, color);
-        }
-        /* Left edge */
-        if (h > 1) {
-            dispi_draw_line(x, y + 1, x, y + h - 2, color);
-        }
-        /* Right edge */
-        if (w > 1 && h > 1) {
-            dispi_draw_line(x + w - 1, y + 1, x + w - 1, y + h - 2, color);
-        }
+    kind = gc_pixels(gc, &pixels);
+    if (kind == GC_DRIVER) {
+        /* Use driver fill rect function */
+        gc->driver->fill_rect(x, y, w, h, color);
+        return;
     }
+    
+    row = pixels.pixels + y * pixels.stride + x;
+    for (i = 0; i < h; i++) {
+        memset(row, color, w);
+        row += pixels.stride;
+    }
+    gc_mark(kind, x, y, w, h);
 }
 
-/* Fill a rectangle with solid color, respecting context transformation and clipping */
-void gc_fill_rect(GraphicsContext *gc, int x, int y, int w, int h, unsigned char color) {
-    if (!gc || !gc->driver) return;
+/* Draw a run of text with context transformation and clipping */
+void gc_draw_text(GraphicsContext *gc, int x, int y, const char *str, int len,
+                  FontSize font, unsigned char fg, unsigned char bg) {
+    Surface *surface;
+    
+    if (!gc_can_draw(gc) || !str) return;
+    
+    if (len < 0) {
+        len = 0;
+        while (str[len]) len++;
+    }
     
     /* Apply translation */
     gc_apply_translation(gc, &x, &y);
     
-    /* Clip the rectangle */
-    if (!gc_clip_rect(gc, &x, &y, &w, &h)) {
-        return;  /* Rectangle is completely outside clip bounds */
+    surface = gc->surface;
+    if (surface) {
+        dispi_draw_text_run_to(surface->pixels, surface->width, surface->height,
+                               surface->stride, x, y, str, len, font == FONT_9X16,
+                               fg, bg, gc->clip_x, gc->clip_y, gc->clip_w, gc->clip_h);
+        return;
     }
     
-    /* Use driver fill rect function */
-    gc->driver->fill_rect(x, y, w, h, color);
+    /* The screen path marks its own dirty tiles */
+    dispi_draw_text_run(x, y, str, len, font == FONT_9X16, fg, bg,
+                        gc->clip_x, gc->clip_y, gc->clip_w, gc->clip_h);
+}
+
+/* Copy a block of pixels, clipped to the context */
+void gc_blit(GraphicsContext *gc, int x, int y, int w, int h,
+             const unsigned char *src, int src_stride) {
+    Surface pixels, from;
+    int kind, cx, cy;
+    
+    if (!gc_can_draw(gc) || !src) return;
+    
+    gc_apply_translation(gc, &x, &y);
+    cx = x;
+    cy = y;
+    if (!gc_clip_rect(gc, &cx, &cy, &w, &h)) return;
+    src += (cy - y) * src_stride + (cx - x);
+    
+    kind = gc_pixels(gc, &pixels);
+    if (kind == GC_DRIVER) {
+        gc->driver->blit(cx, cy, w, h, (unsigned char*)src, src_stride);
+        return;
+    }
+    
+    surface_init(&from, (unsigned char*)src, w, h, src_stride);
+    surface_copy_rect(&pixels, cx, cy, &from, 0, 0, w, h);
+    gc_mark(kind, cx, cy, w, h);
+}
+
+/* Copy a block of pixels, leaving the destination where the source is key */
+void gc_blit_keyed(GraphicsContext *gc, int x, int y, int w, int h,
+                   const unsigned char *src, int src_stride, unsigned char key) {
+    Surface pixels;
+    unsigned char *dst;
+    int kind, cx, cy, row, col, run;
+    
+    if (!gc_can_draw(gc) || !src) return;
+    
+    gc_apply_translation(gc, &x, &y);
+    cx = x;
+    cy = y;
+    if (!gc_clip_rect(gc, &cx, &cy, &w, &h)) return;
+    src += (cy - y) * src_stride + (cx - x);
+    
+    kind = gc_pixels(gc, &pixels);
+    if (kind == GC_DRIVER) {
+        dispi_blit_transparent(cx, cy, w, h, (unsigned char*)src, src_stride, key);
+        return;
+    }
+    
+    /* Copy each row's runs of non-key pixels whole */
+    dst = pixels.pixels + cy * pixels.stride + cx;
+    for (row = 0; row < h; row++) {
+        col = 0;
+        while (col < w) {
+            if (src[col] == key) {
+                col++;
+                continue;
+            }
+            run = col;
+            while (run < w && src[run] != key) run++;
+            memcpy(dst + col, src + col, run - col);
+            col = run;
+        }
+        src += src_stride;
+        dst += pixels.stride;
+    }
+    gc_mark(kind, cx, cy, w, h);
 }
 
 /* Fill a rectangle with a pattern */
 void gc_fill_rect_pattern(GraphicsContext *gc, int x, int y, int w, int h, Pattern8x8 *pattern) {
+    Surface pixels;
+    unsigned char *dst;
+    unsigned char bits, color;
     int orig_x, orig_y;
-    int dy, dx;
-    if (!gc || !gc->driver || !pattern) return;
+    int kind, dy, dx;
     
-    orig_x = x;
-    orig_y = y;
+    if (!gc_can_draw(gc) || !pattern) return;
     
     /* Apply translation */
     gc_apply_translation(gc, &x, &y);
@@ -410,24 +640,27 @@ void gc_fill_rect_pattern(GraphicsContext *gc, int x, int y, int w, int h, Patte
         return;  /* Rectangle is completely outside clip bounds */
     }
     
-    /* Draw pattern pixel by pixel */
+    /* The pattern is anchored to untranslated coordinates, so it lines
+     * up across separate fills no matter where the clip cuts them */
+    orig_x = x - gc->translate_x;
+    orig_y = y - gc->translate_y;
+    
+    kind = gc_pixels(gc, &pixels);
     for (dy = 0; dy < h; dy++) {
+        bits = pattern->rows[(orig_y + dy) & 7];
+        dst = kind == GC_DRIVER ? NULL : pixels.pixels + (y + dy) * pixels.stride + x;
+    
         for (dx = 0; dx < w; dx++) {
-            int px = x + dx;
-            int py = y + dy;
-            
-            /* Calculate pattern coordinates (relative to original position) */
-            int pattern_x = (orig_x + dx) & 7;  /* mod 8 */
-            int pattern_y = (orig_y + dy) & 7;  /* mod 8 */
-            
-            /* Check if this pixel should be foreground or background */
-            unsigned char row = pattern->rows[pattern_y];
-            int bit = (row >> (7 - pattern_x)) & 1;
-            
-            unsigned char color = bit ? gc->fg_color : gc->bg_color;
-            gc->driver->set_pixel(px, py, color);
+            /* Bit 7 is the leftmost pixel of each 8-pixel tile */
+            color = ((bits >> (7 - ((orig_x + dx) & 7))) & 1) ? gc->fg_color : gc->bg_color;
+            if (dst) {
+                dst[dx] = color;
+            } else {
+                gc->driver->set_pixel(x + dx, y + dy, color);
+            }
         }
     }
+    gc_mark(kind, x, y, w, h);
 }
 
 /* Fill a rectangle using the current context pattern */
@@ -443,7 +676,13 @@ void gc_fill_rect_current_pattern(GraphicsContext *gc, int x, int y, int w, int
 
 /* Draw a circle with context transformation and clipping */
 void gc_draw_circle(GraphicsContext *gc, int cx, int cy, int radius, unsigned char color) {
-    if (!gc || !gc->driver) return;
+    Surface pixels;
+    int kind;
+    int x = radius;
+    int y = 0;
+    int err = 0;
+    
+    if (!gc_can_draw(gc)) return;
     
     /* Apply translation */
     gc_apply_translation(gc, &cx, &cy);
@@ -454,19 +693,58 @@ void gc_draw_circle(GraphicsContext *gc, int cx, int cy, int radius, unsigned ch
         return;
     }
     
-    /* Use DISPI circle drawing function (it will handle individual pixel clipping) */
-    dispi_draw_circle(cx, cy, radius, color);
+    kind = gc_pixels(gc, &pixels);
+    if (kind == GC_DRIVER) {
+        /* Use DISPI circle drawing function (it will handle individual pixel clipping) */
+        dispi_draw_circle(cx, cy, radius, color);
+        return;
+    }
+    
+    /* Midpoint circle, one octant mirrored */
+    while (x >= y) {
+        gc_plot(gc, &pixels, cx + x, cy + y, color);
+        gc_plot(gc, &pixels, cx + y, cy + x, color);
+        gc_plot(gc, &pixels, cx - y, cy + x, color);
+        gc_plot(gc, &pixels, cx - x, cy + y, color);
+        gc_plot(gc, &pixels, cx - x, cy - y, color);
+        gc_plot(gc, &pixels, cx - y, cy - x, color);
+        gc_plot(gc, &pixels, cx + y, cy - x, color);
+        gc_plot(gc, &pixels, cx + x, cy - y, color);
+        
+        y++;
+        if (err <= 0) {
+            err += 2 * y + 1;
+        } else {
+            x--;
+            err += 2 * (y - x) + 1;
+        }
+    }
+    gc_mark(kind, cx - radius, cy - radius, 2 * radius + 1, 2 * radius + 1);
+}
+
+/* Fill the clipped span cx - half .. cx + half of row y */
+static void gc_circle_span(GraphicsContext *gc, int kind, Surface *pixels,
+                           int cx, int half, int y, unsigned char color) {
+    int x1 = cx - half;
+    int x2 = cx + half;
+    
+    if (y < gc->clip_y || y >= gc->clip_y + gc->clip_h) return;
+    
+    if (x1 < gc->clip_x) x1 = gc->clip_x;
+    if (x2 >= gc->clip_x + gc->clip_w) x2 = gc->clip_x + gc->clip_w - 1;
+    gc_span(gc, kind, pixels, x1, x2, y, color);
 }
 
 /* Fill a circle with context transformation and clipping */
 void gc_fill_circle(GraphicsContext *gc, int cx, int cy, int radius, unsigned char color) {
     /* Fill circle using midpoint algorithm */
+    Surface pixels;
+    int kind;
     int x = 0;
     int y = radius;
     int d = 1 - radius;
-    int span_y, px, x1, x2;
     
-    if (!gc || !gc->driver || radius < 0) return;
+    if (!gc_can_draw(gc) || radius < 0) return;
     
     /* Apply translation */
     gc_apply_translation(gc, &cx, &cy);
@@ -477,70 +755,20 @@ void gc_fill_circle(GraphicsContext *gc, int cx, int cy, int radius, unsigned ch
         return;
     }
     
+    kind = gc_pixels(gc, &pixels);
+    
     while (x <= y) {
-        /* Draw horizontal lines for each octant */
-        
-        /* Top half */
-        int y1 = cy - y;
-        int y2 = cy - x;
-        
-        /* Bottom half */
-        int y3 = cy + x;
-        int y4 = cy + y;
-        
-        /* Draw horizontal spans, clipped to context bounds */
-        for (span_y = y1; span_y <= y1; span_y++) {
-            if (span_y >= gc->clip_y && span_y < gc->clip_y + gc->clip_h) {
-                x1 = cx - x;
-                x2 = cx + x;
-                if (x1 < gc->clip_x) x1 = gc->clip_x;
-                if (x2 >= gc->clip_x + gc->clip_w) x2 = gc->clip_x + gc->clip_w - 1;
-                for (px = x1; px <= x2; px++) {
-                    gc->driver->set_pixel(px, span_y, color);
-                }
-            }
+        /* One span per row in each of the four octant pairs, skipping
+         * rows an earlier pair already covered */
+        gc_circle_span(gc, kind, &pixels, cx, x, cy - y, color);
+        if (cy - x != cy - y) {
+            gc_circle_span(gc, kind, &pixels, cx, y, cy - x, color);
         }
-        
-        if (y2 != y1) {
-            for (span_y = y2; span_y <= y2; span_y++) {
-                if (span_y >= gc->clip_y && span_y < gc->clip_y + gc->clip_h) {
-                    x1 = cx - y;
-                    x2 = cx + y;
-                    if (x1 < gc->clip_x) x1 = gc->clip_x;
-                    if (x2 >= gc->clip_x + gc->clip_w) x2 = gc->clip_x + gc->clip_w - 1;
-                    for (px = x1; px <= x2; px++) {
-                        gc->driver->set_pixel(px, span_y, color);
-                    }
-                }
-            }
+        if (cy + x != cy - x) {
+            gc_circle_span(gc, kind, &pixels, cx, y, cy + x, color);
         }
-        
-        if (y3 != y2) {
-            for (span_y = y3; span_y <= y3; span_y++) {
-                if (span_y >= gc->clip_y && span_y < gc->clip_y + gc->clip_h) {
-                    x1 = cx - y;
-                    x2 = cx + y;
-                    if (x1 < gc->clip_x) x1 = gc->clip_x;
-                    if (x2 >= gc->clip_x + gc->clip_w) x2 = gc->clip_x + gc->clip_w - 1;
-                    for (px = x1; px <= x2; px++) {
-                        gc->driver->set_pixel(px, span_y, color);
-                    }
-                }
-            }
-        }
-        
-        if (y4 != y3) {
-            for (span_y = y4; span_y <= y4; span_y++) {
-                if (span_y >= gc->clip_y && span_y < gc->clip_y + gc->clip_h) {
-                    x1 = cx - x;
-                    x2 = cx + x;
-                    if (x1 < gc->clip_x) x1 = gc->clip_x;
-                    if (x2 >= gc->clip_x + gc->clip_w) x2 = gc->clip_x + gc->clip_w - 1;
-                    for (px = x1; px <= x2; px++) {
-                        gc->driver->set_pixel(px, span_y, color);
-                    }
-                }
-            }
+        if (cy + y != cy + x) {
+            gc_circle_span(gc, kind, &pixels, cx, x, cy + y, color);
         }
         
         if (d < 0) {
@@ -551,6 +779,7 @@ void gc_fill_circle(GraphicsContext *gc, int cx, int cy, int radius, unsigned ch
         }
         x++;
     }
+    gc_mark(kind, cx - radius, cy - radius, 2 * radius + 1, 2 * radius + 1);
 }
 
 /* Pattern utility functions */
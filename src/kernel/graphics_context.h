@@ -2,6 +2,8 @@
 #define GRAPHICS_CONTEXT_H
 
 #include "display_driver.h"
+#include "ui_theme.h"
+#include "surface.h"
 
 /* 8x8 pattern for fills - each row is represented as a byte where
  * bit 7 = leftmost pixel, bit 0 = rightmost pixel
@@ -28,6 +30,10 @@ typedef struct GraphicsContext {
     
     /* Current pattern for pattern fills */
     Pattern8x8 *current_pattern;
+    
+    /* Offscreen surface, or NULL to draw to the display. Translated
+     * coordinates index it directly. */
+    Surface *surface;
 } GraphicsContext;
 
 /* Context lifecycle functions */
@@ -35,11 +41,18 @@ GraphicsContext* gc_create(DisplayDriver *driver);
 void gc_destroy(GraphicsContext *gc);
 void gc_init(GraphicsContext *gc, DisplayDriver *driver);
 
+/* Initialize a context that draws into surface; it needs no driver */
+void gc_init_surface(GraphicsContext *gc, Surface *surface);
+
 /* Context state management */
 void gc_set_clip(GraphicsContext *gc, int x, int y, int w, int h);
 void gc_get_clip(GraphicsContext *gc, int *x, int *y, int *w, int *h);
 void gc_clear_clip(GraphicsContext *gc);  /* Reset to full screen */
 
+/* Draw into a surface instead of the display (NULL returns to the
+ * display). Resets the clip to the new target. */
+void gc_set_surface(GraphicsContext *gc, Surface *surface);
+
 void gc_set_translation(GraphicsContext *gc, int x, int y);
 void gc_get_translation(GraphicsContext *gc, int *x, int *y);
 void gc_translate(GraphicsContext *gc, int dx, int dy);  /* Add to current translation */
@@ -62,6 +75,20 @@ void gc_fill_rect(GraphicsContext *gc, int x, int y, int w, int h, unsigned char
 void gc_draw_circle(GraphicsContext *gc, int cx, int cy, int radius, unsigned char color);
 void gc_fill_circle(GraphicsContext *gc, int cx, int cy, int radius, unsigned char color);
 
+/* Draw len characters of str (len < 0: up to the terminating NUL) in
+ * the given font, with bg 255 meaning a transparent background.
+ * Glyphs are clipped to the clip rectangle, including partial columns,
+ * and the visible part of the run is marked dirty once. */
+void gc_draw_text(GraphicsContext *gc, int x, int y, const char *str, int len,
+                  FontSize font, unsigned char fg, unsigned char bg);
+
+/* Copy a w x h block of pixels to (x, y), clipped; the keyed variant
+ * skips source pixels equal to key */
+void gc_blit(GraphicsContext *gc, int x, int y, int w, int h,
+             const unsigned char *src, int src_stride);
+void gc_blit_keyed(GraphicsContext *gc, int x, int y, int w, int h,
+                   const unsigned char *src, int src_stride, unsigned char key);
+
 /* Pattern fill functions */
 void gc_fill_rect_pattern(GraphicsContext *gc, int x, int y, int w, int h, Pattern8x8 *pattern);
 void gc_fill_rect_current_pattern(GraphicsContext *gc, int x, int y, int w, int h);
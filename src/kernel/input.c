@@ -5,6 +5,7 @@
 #include "page.h"
 #include "display.h"
 #include "commands.h"
+#include "input_irq.h"
 
 /* Shift key state - must persist between calls */
 int shift_pressed = 0;
@@ -12,7 +13,7 @@ int ctrl_pressed = 0;
 
 /* Get keyboard event with both scancode and ASCII */
 int keyboard_get_key_event(unsigned char *scancode, char *ascii) {
-    unsigned char status;
+    InputRawEvent event;
     unsigned char keycode;
     static int extended_key = 0;  /* Track if we're in an extended key sequence */
     
@@ -42,14 +43,11 @@ int keyboard_get_key_event(unsigned char *scancode, char *ascii) {
         0, 0, 0, 0, 0, 0, 0, 0, 0
     };
     
-    /* Check if keyboard data is available */
-    status = inb(0x64);
-    if (!(status & 1) || (status & 0x20)) {
+    /* Take the next scancode the IRQ1 handler queued */
+    if (!input_keyboard_pop(&event)) {
         return 0;  /* No keyboard data available */
     }
-    
-    /* Read the keycode */
-    keycode = inb(0x60);
+    keycode = event.data;
     
     /* Check for extended key prefix (0xE0) */
     if (keycode == 0xE0) {
@@ -166,6 +164,7 @@ void init_mouse(void) {
     }
     
     mouse_visible = 1;
+    update_mouse();
 }
 
 /* Poll for serial mouse data (non-blocking)
@@ -206,6 +205,7 @@ void poll_mouse(void) {
     static int accumulated_dx = 0;  /* Accumulate fractional X movements */
     static int accumulated_dy = 0;  /* Accumulate fractional Y movements */
     static int prev_left_button = 0;  /* Track previous button state */
+    InputRawEvent event;
     unsigned char data;
     int packets_processed = 0;
     int left_button, right_button;
@@ -214,12 +214,12 @@ void poll_mouse(void) {
     int click_x, click_y;
     int nav_text_len, nav_start;
     
-    /* Read all available bytes from serial port.
+    /* Read all bytes the IRQ4 handler queued.
      * Why limit to 10 packets: We process at most 10 packets per poll to
      * prevent the mouse from monopolizing CPU time. Since we poll frequently,
      * this doesn't cause noticeable lag but ensures keyboard remains responsive. */
-    while ((inb(COM1_LSR) & 0x01) && packets_processed < 10) {
-        data = inb(COM1_DATA);
+    while (packets_processed < 10 && input_mouse_pop(&event)) {
+        data = event.data;
         
         /* Microsoft protocol: First byte has bit 6 set, bit 7 clear.
          * Why: This bit pattern allows re-synchronization if we start
@@ -318,14 +318,14 @@ void poll_mouse(void) {
                         }
                         
                         /* Handle newlines */
-                        if (page->buffer[buf_pos] == '\n') {
+                        if (page_char_at(page, buf_pos) == '\n') {
                             /* If we're on the target line but past the click column, we clicked past line end */
                             if (line == click_y) {
                                 break;
                             }
                             line++;
                             col = 0;
-                        } else if (page->buffer[buf_pos] == '\t') {
+                        } else if (page_char_at(page, buf_pos) == '\t') {
                             /* Tabs take up 2 visual spaces */
                             col += 2;
                             /* Handle line wrap */
@@ -352,7 +352,7 @@ void poll_mouse(void) {
                     /* Check if click is within text */
                     if (buf_pos >= 0 && buf_pos < page->length) {
                         /* Check if clicked on a word or whitespace */
-                        char clicked_char = page->buffer[buf_pos];
+                        char clicked_char = page_char_at(page, buf_pos);
                         if (clicked_char == ' ' || clicked_char == '\n' || clicked_char == '\t') {
                             /* Clear any existing highlight */
                             page->highlight_start = 0;
@@ -364,27 +364,27 @@ void poll_mouse(void) {
                             
                             /* Find start of word */
                             while (page->highlight_start > 0 && 
-                                   page->buffer[page->highlight_start - 1] != ' ' &&
-                                   page->buffer[page->highlight_start - 1] != '\n' &&
-                                   page->buffer[page->highlight_start - 1] != '\t') {
+                                   page_char_at(page, page->highlight_start - 1) != ' ' &&
+                                   page_char_at(page, page->highlight_start - 1) != '\n' &&
+                                   page_char_at(page, page->highlight_start - 1) != '\t') {
                                 page->highlight_start--;
                             }
                             
                             /* Find end of word */
                             while (page->highlight_end < page->length &&
-                                   page->buffer[page->highlight_end] != ' ' &&
-                                   page->buffer[page->highlight_end] != '\n' &&
-                                   page->buffer[page->highlight_end] != '\t') {
+                                   page_char_at(page, page->highlight_end) != ' ' &&
+                                   page_char_at(page, page->highlight_end) != '\n' &&
+                                   page_char_at(page, page->highlight_end) != '\t') {
                                 page->highlight_end++;
                             }
                             
                             /* Check if this is a command (starts with $) */
-                            if (page->buffer[page->highlight_start] == '$') {
+                            if (page_char_at(page, page->highlight_start) == '$') {
                                 /* Execute the command */
                                 execute_command(page, page->highlight_start, page->highlight_end);
                             }
                             /* Check if this is a link (starts with #) */
-                            else if (page->buffer[page->highlight_start] == '#') {
+                            else if (page_char_at(page, page->highlight_start) == '#') {
                                 /* Execute the link */
                                 execute_link(page, page->highlight_start, page->highlight_end);
                             }
@@ -482,13 +482,13 @@ void poll_mouse(void) {
             accumulated_dy = 0;
         }
         
-        /* Refresh if mouse moved */
+        /* Move the cursor overlay if mouse moved (two cell writes) */
         if (mouse_x != old_x || mouse_y != old_y) {
             /* If in graphics mode, update graphics cursor instead */
             if (graphics_mode_active) {
                 handle_graphics_mouse_move(mouse_x, mouse_y);
             } else {
-                refresh_screen();
+                update_mouse();
             }
         }
         
@@ -526,17 +526,14 @@ int keyboard_check(void) {
         0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,                           /* 103-118 */
         0, 0, 0, 0, 0, 0, 0, 0, 0                                                  /* 119-127 */
     };
-    unsigned char status;
+    InputRawEvent event;
     unsigned char keycode;
     
-    /* Check if keyboard data available (not mouse data) */
-    status = inb(0x64);
-    if (!(status & 1) || (status & 0x20)) {
+    /* Take the next scancode the IRQ1 handler queued, without blocking */
+    if (!input_keyboard_pop(&event)) {
         return 0;  /* No keyboard data available */
     }
-    
-    /* Read the keycode directly without blocking */
-    keycode = inb(0x60);
+    keycode = event.data;
     
     /* Check for shift press/release (left shift = 0x2A, right shift = 0x36) */
     if (keycode == 0x2A || keycode == 0x36) {
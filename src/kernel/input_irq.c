@@ -0,0 +1,173 @@
+/* Interrupt-Driven Input Implementation */
+
+#include "input_irq.h"
+#include "io.h"
+#include "serial.h"
+#include "timer.h"
+
+/* 8042 keyboard controller */
+#define KBD_DATA            0x60
+#define KBD_STATUS          0x64
+#define KBD_STATUS_FULL     0x01    /* Output buffer has a byte */
+#define KBD_STATUS_AUX      0x20    /* ...and it came from the mouse port */
+#define KBD_OVERRUN         0xFF    /* Scancode set 1 overrun / error */
+#define KBD_OVERRUN_SET2    0x00
+
+/* 16550 UART bits */
+#define UART_LSR_DATA       0x01
+#define UART_LSR_OVERRUN    0x02
+#define UART_IER_RX         0x01    /* Interrupt on received data */
+#define UART_MCR_DTR_RTS    0x03
+#define UART_MCR_OUT2       0x08    /* Connects the UART's IRQ line */
+#define UART_FIFO_TRIGGER_1 0x07    /* Enable and clear FIFOs, 1-byte trigger */
+#define UART_FIFO_SIZE      16
+
+/* PIC */
+#define PIC_MASTER_CMD      0x20
+#define PIC_MASTER_DATA     0x21
+#define PIC_EOI             0x20
+#define IRQ_COM1            4
+
+static InputRing keyboard_ring;
+static InputRing mouse_ring;
+
+/* Why a compiler barrier is enough: the producer is an interrupt on the
+ * same CPU, so only the compiler could reorder the slot write and the
+ * counter update. */
+#define RING_BARRIER() __asm__ __volatile__("" : : : "memory")
+
+/* Queue a byte (interrupt context) */
+static void ring_push(InputRing *ring, unsigned char data) {
+    InputRawEvent *event;
+    unsigned int depth = ring->head - ring->tail;
+    
+    if (depth >= INPUT_RING_SIZE) {
+        ring->dropped++;
+        return;
+    }
+    
+    event = &ring->events[ring->head & (INPUT_RING_SIZE - 1)];
+    event->ticks = get_ticks();
+    event->cycles = get_cycles();
+    event->data = data;
+    RING_BARRIER();
+    ring->head++;
+    
+    if (depth + 1 > ring->max_depth) {
+        ring->max_depth = depth + 1;
+    }
+}
+
+/* Take the oldest byte (main loop) */
+static int ring_pop(InputRing *ring, InputRawEvent *event) {
+    unsigned int wait;
+    
+    if (ring->tail == ring->head) {
+        return 0;
+    }
+    RING_BARRIER();
+    
+    *event = ring->events[ring->tail & (INPUT_RING_SIZE - 1)];
+    RING_BARRIER();
+    ring->tail++;
+    
+    wait = get_cycles() - event->cycles;
+    if (wait > ring->max_wait_cycles) {
+        ring->max_wait_cycles = wait;
+    }
+    return 1;
+}
+
+/* IRQ1: one byte per interrupt from the keyboard controller */
+void keyboard_irq_handler(void) {
+    unsigned char status;
+    unsigned char data;
+    
+    status = inb(KBD_STATUS);
+    if (status & KBD_STATUS_FULL) {
+        data = inb(KBD_DATA);
+        if (status & KBD_STATUS_AUX) {
+            /* PS/2 mouse byte; that port is not used */
+        } else if (data == KBD_OVERRUN || data == KBD_OVERRUN_SET2) {
+            keyboard_ring.overruns++;
+        } else {
+            ring_push(&keyboard_ring, data);
+        }
+    }
+    
+    outb(PIC_MASTER_CMD, PIC_EOI);
+}
+
+/* IRQ4: empty COM1's receive FIFO */
+void mouse_irq_handler(void) {
+    unsigned char lsr;
+    int count = 0;
+    
+    lsr = inb(COM1_LSR);
+    while ((lsr & UART_LSR_DATA) && count < UART_FIFO_SIZE) {
+        if (lsr & UART_LSR_OVERRUN) {
+            mouse_ring.overruns++;
+        }
+        ring_push(&mouse_ring, inb(COM1_DATA));
+        count++;
+        lsr = inb(COM1_LSR);
+    }
+    
+    outb(PIC_MASTER_CMD, PIC_EOI);
+}
+
+/* Enable COM1's receive interrupt and unmask IRQ4 */
+void input_irq_init(void) {
+    unsigned int flags;
+    
+    __asm__ __volatile__("pushfl; popl %0; cli" : "=r"(flags) : : "memory");
+    
+    /* Why a 1-byte trigger: at 1200 baud the default 14-byte level would
+     * hold a 3-byte packet until the FIFO timeout, several bytes later */
+    outb(COM1_FCR, UART_FIFO_TRIGGER_1);
+    outb(COM1_MCR, UART_MCR_DTR_RTS | UART_MCR_OUT2);
+    outb(COM1_IER, UART_IER_RX);
+    
+    /* Bytes that arrived before the interrupt was on */
+    while (inb(COM1_LSR) & UART_LSR_DATA) {
+        ring_push(&mouse_ring, inb(COM1_DATA));
+    }
+    
+    outb(PIC_MASTER_DATA, inb(PIC_MASTER_DATA) & ~(1 << IRQ_COM1));
+    
+    if (flags & 0x200) {
+        __asm__ __volatile__("sti");
+    }
+    
+    serial_write_string("Input interrupts enabled: keyboard IRQ1, mouse IRQ4\n");
+}
+
+int input_keyboard_pop(InputRawEvent *event) {
+    return ring_pop(&keyboard_ring, event);
+}
+
+int input_mouse_pop(InputRawEvent *event) {
+    return ring_pop(&mouse_ring, event);
+}
+
+static void report_ring(const char *name, InputRing *ring) {
+    serial_write_string(name);
+    serial_write_string(": queued ");
+    serial_write_int((int)ring->head);
+    serial_write_string(", waiting ");
+    serial_write_int((int)(ring->head - ring->tail));
+    serial_write_string(", max depth ");
+    serial_write_int((int)ring->max_depth);
+    serial_write_string(", dropped ");
+    serial_write_int((int)ring->dropped);
+    serial_write_string(", overruns ");
+    serial_write_int((int)ring->overruns);
+    serial_write_string(", max wait ");
+    serial_write_int((int)ring->max_wait_cycles);
+    serial_write_string(" cycles\n");
+}
+
+void input_irq_report_stats(void) {
+    report_ring("Keyboard ring", &keyboard_ring);
+    report_ring("Mouse ring", &mouse_ring);
+}
@@ -0,0 +1,62 @@
+/* Interrupt-Driven Input
+ *
+ * DESIGN
+ * ------
+ * The keyboard (IRQ1) and the serial mouse on COM1 (IRQ4) are read by
+ * their interrupt handlers. Each handler stamps the raw byte with the
+ * tick count and the timestamp counter and queues it in a ring buffer.
+ * The editor and demo loops drain the rings through keyboard_check(),
+ * keyboard_get_key_event(), poll_mouse() and mouse_poll(), which decode
+ * the bytes exactly as they did when they polled the ports.
+ *
+ * Why interrupts: polling had to find data in the controller's status
+ * register on every loop pass. Input latency then depended on how long a
+ * frame took, and in a virtual machine every status read is a VM exit.
+ * Now a byte is taken when it arrives, and draining an empty ring costs
+ * two memory reads.
+ *
+ * Each ring has one producer (its handler) and one consumer (the main
+ * loop), so it needs no lock. head and tail are free-running counters:
+ * only the handler advances head and only the consumer advances tail.
+ * Each side writes its slot before moving its own counter.
+ *
+ * Lost input is counted, not hidden. A byte that arrives with its ring
+ * full is dropped. A byte the hardware lost before the handler ran is an
+ * overrun: the UART's overrun flag, or the keyboard controller's
+ * overrun scancode. $input logs both with the ring statistics.
+ */
+
+#ifndef INPUT_IRQ_H
+#define INPUT_IRQ_H
+
+/* Events per ring (a power of two) */
+#define INPUT_RING_SIZE 256
+
+typedef struct InputRawEvent {
+    unsigned int ticks;         /* get_ticks() when the handler ran */
+    unsigned int cycles;        /* get_cycles() when the handler ran */
+    unsigned char data;         /* Scancode or mouse protocol byte */
+} InputRawEvent;
+
+typedef struct InputRing {
+    InputRawEvent events[INPUT_RING_SIZE];
+    volatile unsigned int head;         /* Events queued (handler only) */
+    volatile unsigned int tail;         /* Events taken (consumer only) */
+    volatile unsigned int dropped;      /* Lost because the ring was full */
+    volatile unsigned int overruns;     /* Lost by the hardware */
+    volatile unsigned int max_depth;    /* Most events waiting at once */
+    unsigned int max_wait_cycles;       /* Longest wait before being taken */
+} InputRing;
+
+/* Route COM1's receive interrupt to IRQ4 and unmask it. Call after
+ * init_timer (which installs the IRQ1 and IRQ4 stubs) and init_mouse. */
+void input_irq_init(void);
+
+/* Take the oldest queued event. Returns 0 if the ring is empty. */
+int input_keyboard_pop(InputRawEvent *event);
+int input_mouse_pop(InputRawEvent *event);
+
+/* Log queued, dropped and overrun counts and queueing delay per ring */
+void input_irq_report_stats(void);
+
+#endif /* INPUT_IRQ_H */
@@ -13,7 +13,8 @@
  * - Navigation is done through a clickable navigation bar or keyboard shortcuts
  * 
  * Input handling:
- * - Non-blocking keyboard and mouse polling (no interrupts)
+ * - Keyboard (IRQ1) and mouse (IRQ4) bytes are queued by interrupt
+ *   handlers and drained without blocking by the main loop
  * - Microsoft Serial Mouse protocol via COM1 (3-byte packets)
  * - Simultaneous mouse and keyboard input processing
  * 
@@ -34,6 +35,8 @@
 #include "timer.h"
 #include "rtc.h"
 #include "memory.h"
+#include "simd.h"
+#include "paging.h"
 #include "graphics.h"
 #include "dispi.h"
 #include "display_driver.h"
@@ -44,6 +47,7 @@
 #include "commands.h"
 #include "editor.h"
 #include "input.h"
+#include "input_irq.h"
 
 /* Editor modes moved to modes.c */
 
@@ -138,6 +142,12 @@ void kernel_main(void) {
     serial_write_int(PAGE_SIZE);
     serial_write_string(" byte buffer)\n");
     
+    /* Identity-map memory so the framebuffer can be write-combining */
+    paging_init();
+    
+    /* Pick scalar or SSE2 pixel kernels */
+    simd_init();
+    
     /* Initialize timer system */
     init_timer();
     
@@ -147,6 +157,9 @@ void kernel_main(void) {
     /* Initialize mouse (uses COM1) */
     init_mouse();
     serial_write_string("Mouse initialized on COM1.\n");
+    
+    /* Take keyboard and mouse bytes in their IRQ handlers from now on */
+    input_irq_init();
     serial_write_string("Text editor ready.\n");
     
 
@@ -196,6 +209,9 @@ void kernel_main(void) {
             serial_write_hex(get_esp());
             serial_write_string("\n");
             
+            /* Report how many text cells the differential renderer wrote */
+            vga_report_stats();
+            
             last_stack_report = current_time;
         }
         
@@ -205,7 +221,7 @@ void kernel_main(void) {
             last_clock_update = current_time;
         }
         
-        /* Poll for mouse data (will refresh screen if mouse moves) */
+        /* Poll for mouse data (moves the cursor overlay if mouse moves) */
         poll_mouse();
         
         /* Check for keyboard input (non-blocking) */
@@ -216,23 +232,23 @@ void kernel_main(void) {
             continue;
         }
         
+        /* Everything a key does - including compound commands like dd,
+         * d$ and dt<char> - is one edit transaction, drawn once at the
+         * end of this loop iteration */
+        edit_begin();
+        
         /* Handle 'fd' escape sequence - insert 'f' immediately, delete if 'd' follows */
         if (editor_mode == MODE_INSERT) {
             /* Check if 'd' was typed shortly after 'f' */
             if (key == 'd' && last_key == 'f' && get_elapsed_ms(last_key_time) < FD_ESCAPE_TIMEOUT_MS) {
                 /* 'fd' sequence detected - delete the 'f' we just inserted and exit */
                 Page *page = pages[current_page];
-                if (page->cursor_pos > 0 && page->buffer[page->cursor_pos - 1] == 'f') {
-                    int i;
+                if (page->cursor_pos > 0 && page_char_at(page, page->cursor_pos - 1) == 'f') {
                     /* Delete the 'f' we just typed */
+                    page_delete(page, page->cursor_pos - 1, 1);
                     page->cursor_pos--;
-                    page->length--;
-                    /* Shift remaining text left */
-                    for (i = page->cursor_pos; i < page->length; i++) {
-                        page->buffer[i] = page->buffer[i + 1];
-                    }
-                    /* Refresh screen to show the 'f' was deleted */
-                    refresh_screen();
+                    /* Redraw from the 'f' that was deleted */
+                    edit_mark_dirty(page->cursor_pos);
                 }
                 /* Exit to normal mode */
                 set_mode(MODE_NORMAL);
@@ -396,24 +412,26 @@ void kernel_main(void) {
                 page->highlight_start = 0;
                 page->highlight_end = 0;
                 set_mode(MODE_NORMAL);
-                refresh_screen();
+                edit_mark_all();
             } else if (key == 'h' || key == -3) {  /* h or Left arrow */
                 move_cursor_left();
                 page->highlight_end = page->cursor_pos;
-                refresh_screen();
+                edit_mark_all();
             } else if (key == 'j' || key == -2) {  /* j or Down arrow */
                 move_cursor_down();
                 page->highlight_end = page->cursor_pos;
-                refresh_screen();
+                edit_mark_all();
             } else if (key == 'k' || key == -1) {  /* k or Up arrow */
                 move_cursor_up();
                 page->highlight_end = page->cursor_pos;
-                refresh_screen();
+                edit_mark_all();
             } else if (key == 'l' || key == -4) {  /* l or Right arrow */
                 move_cursor_right();
                 page->highlight_end = page->cursor_pos;
-                refresh_screen();
+                edit_mark_all();
             }
         }
+        
+        edit_commit();
     }
 }
@@ -3,6 +3,7 @@
 [SECTION .text]
 
 global _start
+global kernel_sse_enabled
 extern kernel_main
 extern __bss_start
 extern __bss_end
@@ -19,6 +20,27 @@ _start:
     cld                     ; Clear direction flag (forward)
     rep stosb               ; Fill ECX bytes at [EDI] with AL (zero)
     
+%ifdef AQUINAS_SSE2
+    ; Opt-in SSE2 build: enable SSE if the CPU has FXSR and SSE2
+    ; (CPUID.1:EDX bits 24 and 26). Until CR4.OSFXSR is set, every SSE
+    ; instruction faults with #UD.
+    mov eax, 1
+    cpuid
+    test edx, 1 << 24
+    jz .no_sse
+    test edx, 1 << 26
+    jz .no_sse
+    mov eax, cr0
+    and eax, ~(1 << 2)      ; Clear EM: no x87 emulation
+    or eax, 1 << 1          ; Set MP
+    mov cr0, eax
+    mov eax, cr4
+    or eax, (1 << 9) | (1 << 10)    ; OSFXSR | OSXMMEXCPT
+    mov cr4, eax
+    mov dword [kernel_sse_enabled], 1
+.no_sse:
+%endif
+    
     ; Now call the C kernel with properly initialized BSS
     call kernel_main
     
@@ -26,4 +48,9 @@ _start:
     cli
 .hang:
     hlt
-    jmp .hang
\ No newline at end of file
+    jmp .hang
+
+[SECTION .data]
+; 1 once SSE is enabled; the interrupt stubs save vector state and
+; simd_init() picks the SSE2 kernels only then
+kernel_sse_enabled: dd 0
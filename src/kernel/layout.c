@@ -61,6 +61,12 @@ void layout_init(Layout *layout) {
     layout->needs_redraw = 1;
     layout->background_color = 0;  /* Black */
     
+    /* No frames drawn yet */
+    memset(&layout->last_frame, 0, sizeof(layout->last_frame));
+    layout->frames_drawn = 0;
+    layout->total_views_visited = 0;
+    layout->total_pixels_painted = 0;
+    
     /* Create event bus */
     layout->event_bus = event_bus_create();
     if (!layout->event_bus) {
@@ -74,21 +80,23 @@ void layout_destroy(Layout *layout) {
     
     if (!layout) return;
     
-    /* Destroy all region content views */
+    /* Region and bar content normally hangs off the root view and is
+     * destroyed with it. Only content that was detached (a hidden bar's
+     * view, say) has to be destroyed on its own. */
     for (row = 0; row < 6; row++) {
         for (col = 0; col < 7; col++) {
-            if (layout->regions[row][col].content) {
+            if (layout->regions[row][col].content &&
+                !layout->regions[row][col].content->parent) {
                 view_destroy(layout->regions[row][col].content);
             }
         }
     }
     
-    /* Destroy bar content if any */
-    if (layout->bar.content) {
+    if (layout->bar.content && !layout->bar.content->parent) {
         view_destroy(layout->bar.content);
     }
     
-    /* Destroy root view */
+    /* Destroy root view and everything attached to it */
     if (layout->root_view) {
         view_destroy(layout->root_view);
     }
@@ -98,7 +106,7 @@ void layout_destroy(Layout *layout) {
         event_bus_destroy(layout->event_bus);
     }
     
-    /* Note: Memory not actually freed due to allocator limitations */
+    free(layout);
 }
 
 /* Reset layout to initial state */
@@ -383,6 +391,14 @@ int layout_get_bar_column(Layout *layout) {
     return layout->bar.position;
 }
 
+/* Damage a region's area, which holds its active border */
+static void layout_damage_region(Region *region) {
+    int x = 0, y = 0, w = 0, h = 0;  /* Left alone for a NULL region */
+    
+    layout_region_to_pixels(region, &x, &y, &w, &h);
+    view_add_damage(x, y, w, h);
+}
+
 /* Set active region */
 void layout_set_active_region(Layout *layout, Region *region) {
     if (!layout || !region) return;
@@ -390,6 +406,7 @@ void layout_set_active_region(Layout *layout, Region *region) {
     /* Deactivate previous */
     if (layout->active_region) {
         layout->active_region->active = 0;
+        layout_damage_region(layout->active_region);
     }
     
     /* Activate new */
@@ -401,7 +418,9 @@ void layout_set_active_region(Layout *layout, Region *region) {
         layout->focus_view = region->content;
     }
     
-    layout_invalidate(layout);
+    /* Only the two borders changed, so don't repaint the whole screen */
+    layout_damage_region(region);
+    layout->needs_redraw = 1;
 }
 
 /* Focus a specific view */
@@ -476,45 +495,98 @@ View* layout_get_focus_view(Layout *layout) {
     return layout->focus_view;
 }
 
+/* Draw the view tree and active border inside one damage rectangle */
+static void layout_draw_regions_clipped(Layout *layout, GraphicsContext *gc,
+                                        const DamageRect *area, ViewDrawStats *stats) {
+    Region *region;
+    int x, y, w, h;
+    
+    /* Draw root view tree (includes all content) */
+    if (layout->root_view) {
+        view_draw_tree_damaged(layout->root_view, gc, area, stats);
+    }
+    
+    /* Draw region borders for active region */
+    if (layout->active_region && layout->active_region->active) {
+        region = layout->active_region;
+        layout_region_to_pixels(region, &x, &y, &w, &h);
+        
+        /* Draw highlighted border */
+        gc_set_clip(gc, area->x, area->y, area->width, area->height);
+        gc_draw_rect(gc, x, y, w - 1, h - 1, 11);  /* Gold border for active */
+    }
+}
+
 /* Draw the layout */
 void layout_draw(Layout *layout, GraphicsContext *gc) {
+    DamageRect rects[VIEW_MAX_DAMAGE];
+    ViewDrawStats stats;
+    int count, i;
+    
     if (!layout || !gc) return;
     
-    /* Clear background */
-    gc_fill_rect(gc, 0, 0, 640, 480, layout->background_color);
+    /* The first frame paints everything; later ones only the damage */
+    if (layout->frames_drawn == 0 || (layout->needs_redraw && !layout->root_view)) {
+        view_add_damage(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
+    }
+    
+    count = view_get_damage(rects, VIEW_MAX_DAMAGE);
+    view_clear_damage();
+    
+    if (count == 0) {
+        /* Nothing on screen changed; still settle the redraw flags */
+        rects[0].x = rects[0].y = rects[0].width = rects[0].height = 0;
+        view_draw_tree_damaged(layout->root_view, gc, &rects[0], NULL);
+        layout->needs_redraw = 0;
+        return;
+    }
     
-    /* Draw regions and their content */
-    layout_draw_regions(layout, gc);
+    memset(&stats, 0, sizeof(stats));
     
-    /* Draw bar if visible */
-    if (layout->bar.visible && layout->bar.position >= 0) {
-        layout_draw_bar(layout, gc);
+    /* Why repaint each rectangle separately: a blinking cursor in one
+     * corner and a hover in another would otherwise grow into one
+     * rectangle covering most of the screen. */
+    for (i = 0; i < count; i++) {
+        gc_set_clip(gc, rects[i].x, rects[i].y, rects[i].width, rects[i].height);
+        
+        /* Clear background */
+        gc_fill_rect(gc, rects[i].x, rects[i].y, rects[i].width, rects[i].height,
+                     layout->background_color);
+        stats.damage_pixels += (unsigned int)(rects[i].width * rects[i].height);
+        
+        /* Draw views and the active border */
+        layout_draw_regions_clipped(layout, gc, &rects[i], &stats);
+        
+        /* Draw bar if visible */
+        if (layout->bar.visible && layout->bar.position >= 0) {
+            gc_set_clip(gc, rects[i].x, rects[i].y, rects[i].width, rects[i].height);
+            layout_draw_bar(layout, gc);
+        }
     }
     
+    gc_clear_clip(gc);
+    
+    stats.damage_rects = count;
+    stats.pixels_painted += stats.damage_pixels;
+    layout->last_frame = stats;
+    layout->frames_drawn++;
+    layout->total_views_visited += stats.views_visited;
+    layout->total_pixels_painted += stats.pixels_painted;
+    
     layout->needs_redraw = 0;
 }
 
 /* Draw all regions */
 void layout_draw_regions(Layout *layout, GraphicsContext *gc) {
-    int row, col;
-    Region *region;
-    int x, y, w, h;
+    DamageRect screen;
     
     if (!layout || !gc) return;
     
-    /* Draw root view tree (includes all content) */
-    if (layout->root_view) {
-        view_draw_tree(layout->root_view, gc);
-    }
-    
-    /* Draw region borders for active region */
-    if (layout->active_region && layout->active_region->active) {
-        region = layout->active_region;
-        layout_region_to_pixels(region, &x, &y, &w, &h);
-        
-        /* Draw highlighted border */
-        gc_draw_rect(gc, x, y, w - 1, h - 1, 11);  /* Gold border for active */
-    }
+    screen.x = 0;
+    screen.y = 0;
+    screen.width = SCREEN_WIDTH;
+    screen.height = SCREEN_HEIGHT;
+    layout_draw_regions_clipped(layout, gc, &screen, NULL);
 }
 
 /* Draw the vertical bar */
@@ -552,6 +624,43 @@ void layout_invalidate(Layout *layout) {
     }
 }
 
+/* Get the last frame's drawing statistics */
+void layout_get_draw_stats(Layout *layout, ViewDrawStats *stats) {
+    if (!layout || !stats) return;
+    
+    *stats = layout->last_frame;
+}
+
+/* Log the last frame and the averages over every frame drawn */
+void layout_report_draw_stats(Layout *layout) {
+    if (!layout) return;
+    
+    serial_write_string("Layout frames drawn: ");
+    serial_write_int(layout->frames_drawn);
+    serial_write_string("\n");
+    if (layout->frames_drawn == 0) return;
+    
+    serial_write_string("  last frame: ");
+    serial_write_int(layout->last_frame.damage_rects);
+    serial_write_string(" rects, ");
+    serial_write_int(layout->last_frame.damage_pixels);
+    serial_write_string(" damaged px, ");
+    serial_write_int(layout->last_frame.pixels_painted);
+    serial_write_string(" painted px, ");
+    serial_write_int(layout->last_frame.views_drawn);
+    serial_write_string(" of ");
+    serial_write_int(layout->last_frame.views_visited);
+    serial_write_string(" views drawn\n");
+    
+    serial_write_string("  average per frame: ");
+    serial_write_int(layout->total_pixels_painted / layout->frames_drawn);
+    serial_write_string(" px painted (full screen is ");
+    serial_write_int(SCREEN_WIDTH * SCREEN_HEIGHT);
+    serial_write_string("), ");
+    serial_write_int(layout->total_views_visited / layout->frames_drawn);
+    serial_write_string(" views visited\n");
+}
+
 /* Handle input event */
 int layout_handle_event(Layout *layout, InputEvent *event) {
     View *target_view = NULL;
@@ -73,6 +73,12 @@ typedef struct Layout {
     
     /* Event bus for decoupled event handling */
     EventBus *event_bus;
+    
+    /* Drawing cost of the last frame, and totals since creation */
+    ViewDrawStats last_frame;
+    unsigned int frames_drawn;
+    unsigned int total_views_visited;
+    unsigned int total_pixels_painted;
 } Layout;
 #endif
 
@@ -110,12 +116,20 @@ void layout_move_focus(Layout *layout, int direction);  /* 0=up, 1=right, 2=down
 Region* layout_get_active_region(Layout *layout);
 View* layout_get_focus_view(Layout *layout);
 
-/* Drawing */
+/* Drawing.
+ * layout_draw repaints only the damage accumulated through
+ * view_invalidate() (all of it after layout_invalidate()), leaving the
+ * rest of the backbuffer as it was, so only the damage is flipped. */
 void layout_draw(Layout *layout, GraphicsContext *gc);
 void layout_draw_regions(Layout *layout, GraphicsContext *gc);
 void layout_draw_bar(Layout *layout, GraphicsContext *gc);
 void layout_invalidate(Layout *layout);
 
+/* Per-frame drawing statistics: the last frame's, and a COM2 summary of
+ * every frame drawn so far */
+void layout_get_draw_stats(Layout *layout, ViewDrawStats *stats);
+void layout_report_draw_stats(Layout *layout);
+
 /* Event handling */
 int layout_handle_event(Layout *layout, InputEvent *event);
 Region* layout_hit_test_region(Layout *layout, int pixel_x, int pixel_y);
@@ -15,10 +15,12 @@
 #include "grid.h"
 #include "serial.h"
 #include "timer.h"
+#include "frame_pacer.h"
 #include "input.h"
 #include "vga.h"
 #include "graphics.h"
 #include "memory.h"
+#include "arena.h"
 #include "mouse.h"
 
 /* Demo view types */
@@ -43,6 +45,13 @@ typedef struct {
     unsigned int last_blink;
 } TextView;
 
+/* Session arena for the demo's own views.
+ * Why an arena: the '1'/'2' keys detach views from the layout, and they
+ * all go back to the heap together when the session ends, however they
+ * were shuffled. view_destroy leaves arena views alone. */
+#define LAYOUT_DEMO_ARENA_CHUNK 1024
+static Arena *g_layout_demo_arena = NULL;
+
 /* Custom draw functions for demo views */
 static void colored_view_draw(View *self, GraphicsContext *gc) {
     ColoredView *cv = (ColoredView*)self;
@@ -64,7 +73,7 @@ static void colored_view_draw(View *self, GraphicsContext *gc) {
     /* Draw label if present */
     if (cv->label) {
         /* Use white text on the view's background color */
-        dispi_draw_string_bios(x + 10, y + 10, cv->label, 15, cv->color);
+        gc_draw_text(gc, x + 10, y + 10, cv->label, -1, FONT_9X16, 15, cv->color);
     }
     
     /* Always draw counter (even if 0) to show it's clickable */
@@ -99,7 +108,7 @@ static void colored_view_draw(View *self, GraphicsContext *gc) {
         buf[i] = '\0';
         
         /* Use white text on the view's background color */
-        dispi_draw_string_bios(x + 10, y + 30, buf, 15, cv->color);
+        gc_draw_text(gc, x + 10, y + 30, buf, -1, FONT_9X16, 15, cv->color);
     }
 }
 
@@ -144,7 +153,7 @@ static void list_view_draw(View *self, GraphicsContext *gc) {
     gc_draw_rect(gc, x, y, w-1, h-1, 5);  /* White border */
     
     /* Draw title */
-    dispi_draw_string_bios(x + 5, y + 5, "Navigator", 15, 1);
+    gc_draw_text(gc, x + 5, y + 5, "Navigator", -1, FONT_9X16, 15, 1);
     
     /* Draw items */
     item_y = y + 25;
@@ -158,7 +167,7 @@ static void list_view_draw(View *self, GraphicsContext *gc) {
         }
         
         /* Draw item text */
-        dispi_draw_string_bios(x + 10, item_y, lv->items[i], fg_color, bg_color);
+        gc_draw_text(gc, x + 10, item_y, lv->items[i], -1, FONT_9X16, fg_color, bg_color);
         item_y += 20;
     }
 }
@@ -227,7 +236,7 @@ static void text_view_draw(View *self, GraphicsContext *gc) {
     
     /* Draw text content */
     if (tv->text) {
-        dispi_draw_string(x + 10, y + 10, tv->text, 14, 0);
+        gc_draw_text(gc, x + 10, y + 10, tv->text, -1, FONT_6X8, 14, 0);
     }
     
     /* Draw blinking cursor */
@@ -250,7 +259,7 @@ static void text_view_update(View *self, int delta_ms) {
 
 /* Helper to create a colored view */
 static ColoredView* create_colored_view(int x, int y, int w, int h, unsigned char color, const char *label) {
-    ColoredView *cv = (ColoredView*)malloc(sizeof(ColoredView));
+    ColoredView *cv = (ColoredView*)arena_alloc(g_layout_demo_arena, sizeof(ColoredView));
     if (!cv) return NULL;
     
     /* Initialize base view */
@@ -270,6 +279,9 @@ static ColoredView* create_colored_view(int x, int y, int w, int h, unsigned cha
     cv->base.handle_event = colored_view_handle_event;
     cv->base.destroy = NULL;
     cv->base.type_name = "ColoredView";
+    cv->base.interface = NULL;  /* Plain view, no ViewInterface */
+    cv->base.cache = NULL;
+    cv->base.arena = g_layout_demo_arena;
     
     /* Initialize colored view specific */
     cv->color = color;
@@ -281,7 +293,7 @@ static ColoredView* create_colored_view(int x, int y, int w, int h, unsigned cha
 
 /* Helper to create a list view */
 static ListView* create_list_view(int x, int y, int w, int h) {
-    ListView *lv = (ListView*)malloc(sizeof(ListView));
+    ListView *lv = (ListView*)arena_alloc(g_layout_demo_arena, sizeof(ListView));
     if (!lv) return NULL;
     
     /* Initialize base view */
@@ -301,6 +313,9 @@ static ListView* create_list_view(int x, int y, int w, int h) {
     lv->base.handle_event = list_view_handle_event;
     lv->base.destroy = NULL;
     lv->base.type_name = "ListView";
+    lv->base.interface = NULL;  /* Plain view, no ViewInterface */
+    lv->base.cache = NULL;
+    lv->base.arena = g_layout_demo_arena;
     
     /* Initialize list view specific */
     lv->selected_item = 0;
@@ -316,7 +331,7 @@ static ListView* create_list_view(int x, int y, int w, int h) {
 
 /* Helper to create a text view */
 static TextView* create_text_view(int x, int y, int w, int h, const char *text) {
-    TextView *tv = (TextView*)malloc(sizeof(TextView));
+    TextView *tv = (TextView*)arena_alloc(g_layout_demo_arena, sizeof(TextView));
     if (!tv) return NULL;
     
     /* Initialize base view */
@@ -336,6 +351,9 @@ static TextView* create_text_view(int x, int y, int w, int h, const char *text)
     tv->base.handle_event = NULL;
     tv->base.destroy = NULL;
     tv->base.type_name = "TextView";
+    tv->base.interface = NULL;  /* Plain view, no ViewInterface */
+    tv->base.cache = NULL;
+    tv->base.arena = g_layout_demo_arena;
     
     /* Initialize text view specific */
     tv->text = text;
@@ -353,18 +371,88 @@ static int g_layout_demo_needs_redraw = 0;
 static void layout_demo_mouse_handler(InputEvent *event) {
     if (!event || !g_layout_demo_layout) return;
     
-    /* Update cursor position on any mouse event */
+    /* Update cursor position on any mouse event. The cursor is an
+     * overlay, so moving it needs no redraw. */
     if (event->type == EVENT_MOUSE_MOVE || 
         event->type == EVENT_MOUSE_DOWN || 
         event->type == EVENT_MOUSE_UP) {
         dispi_cursor_move(event->data.mouse.x, event->data.mouse.y);
-        g_layout_demo_needs_redraw = 1;  /* Force redraw to show cursor movement */
     }
     
-    /* Pass event to layout for handling */
-    if (layout_handle_event(g_layout_demo_layout, event)) {
-        g_layout_demo_needs_redraw = 1;
+    /* Pass event to layout for handling. Why not redraw when it is
+     * handled: buttons handle every move over them, but only a change
+     * (hover, press, focus) invalidates a view or the layout, and the
+     * main loop already redraws on those flags. */
+    layout_handle_event(g_layout_demo_layout, event);
+}
+
+/* Build the split layout used by the demo.
+ * The views are returned so the demo can swap them around; while they are
+ * attached to the layout, layout_destroy() frees them. */
+static Layout* layout_demo_build(ListView **navigator, ColoredView **view1,
+                                 ColoredView **view2, ColoredView **view3) {
+    Layout *layout;
+    View *child1, *child2;
+    
+    /* Create layout */
+    layout = layout_create();
+    if (!layout) {
+        serial_write_string("ERROR: Failed to create layout\n");
+        return NULL;
+    }
+    
+    /* Demo 1: Split layout with navigator and content */
+    serial_write_string("Demo 1: Split layout\n");
+    
+    /* Create navigator list view */
+    *navigator = create_list_view(0, 0, 2, 6);
+    
+    /* Create content area with colored views */
+    *view1 = create_colored_view(2, 0, 5, 2, 6, "Red Region");
+    *view2 = create_colored_view(2, 2, 5, 2, 9, "Gold Region");  
+    *view3 = create_colored_view(2, 4, 5, 2, 12, "Cyan Region");
+    
+    /* Add child views to demonstrate hierarchy */
+    /* Children should be positioned relative to parent, not absolute */
+    /* view1 is at (2,0), so child positions are offsets from that */
+    child1 = (View*)create_colored_view(0, 0, 2, 1, 11, "Child 1");  /* Top-left of parent */
+    child2 = (View*)create_colored_view(2, 1, 1, 1, 14, "Child 2");  /* Bottom-right area */
+    view_add_child((View*)*view1, child1);
+    view_add_child((View*)*view1, child2);
+    
+    /* Set up the layout */
+    layout_set_region_content(layout, 0, 0, 2, 6, (View*)*navigator);
+    layout_set_region_content(layout, 2, 0, 5, 2, (View*)*view1);
+    layout_set_region_content(layout, 2, 2, 5, 2, (View*)*view2);
+    layout_set_region_content(layout, 2, 4, 5, 2, (View*)*view3);
+    
+    /* Show bar at position 2 */
+    layout_set_bar_position(layout, 2);
+    layout_show_bar(layout, 1);
+    
+    /* Set active region */
+    layout_set_active_region(layout, layout_get_region(layout, 0, 0));
+    
+    return layout;
+}
+
+/* Build and destroy the demo layout without entering graphics mode, for
+ * allocator stress tests */
+void layout_demo_alloc_cycle(void) {
+    ListView *navigator;
+    ColoredView *view1, *view2, *view3;
+    Layout *layout;
+    
+    g_layout_demo_arena = arena_create("layout-demo", LAYOUT_DEMO_ARENA_CHUNK);
+    if (!g_layout_demo_arena) return;
+    
+    layout = layout_demo_build(&navigator, &view1, &view2, &view3);
+    if (layout) {
+        layout_destroy(layout);
     }
+    
+    arena_destroy(g_layout_demo_arena);
+    g_layout_demo_arena = NULL;
 }
 
 /* Main layout demo function */
@@ -374,8 +462,7 @@ void test_layout_demo(void) {
     DisplayDriver *driver;
     ColoredView *view1, *view2, *view3;
     ListView *navigator;
-    TextView *content;
-    View *child1, *child2;
+    TextView *content = NULL;
     int running = 1;
     int key;
     unsigned int last_update = 0;
@@ -399,60 +486,27 @@ void test_layout_demo(void) {
         return;
     }
     
-    /* Create layout */
-    layout = layout_create();
+    /* Create layout and views */
+    g_layout_demo_arena = arena_create("layout-demo", LAYOUT_DEMO_ARENA_CHUNK);
+    layout = g_layout_demo_arena ? layout_demo_build(&navigator, &view1, &view2, &view3) : NULL;
     if (!layout) {
-        serial_write_string("ERROR: Failed to create layout\n");
+        arena_destroy(g_layout_demo_arena);
+        g_layout_demo_arena = NULL;
         gc_destroy(gc);
         return;
     }
     
-    /* Demo 1: Split layout with navigator and content */
-    serial_write_string("Demo 1: Split layout\n");
-    
-    /* Create navigator list view */
-    navigator = create_list_view(0, 0, 2, 6);
-    
-    /* Create content area with colored views */
-    view1 = create_colored_view(2, 0, 5, 2, 6, "Red Region");
-    view2 = create_colored_view(2, 2, 5, 2, 9, "Gold Region");  
-    view3 = create_colored_view(2, 4, 5, 2, 12, "Cyan Region");
-    
-    /* Add child views to demonstrate hierarchy */
-    /* Children should be positioned relative to parent, not absolute */
-    /* view1 is at (2,0), so child positions are offsets from that */
-    child1 = (View*)create_colored_view(0, 0, 2, 1, 11, "Child 1");  /* Top-left of parent */
-    child2 = (View*)create_colored_view(2, 1, 1, 1, 14, "Child 2");  /* Bottom-right area */
-    view_add_child((View*)view1, child1);
-    view_add_child((View*)view1, child2);
-    
-    /* Set up the layout */
-    layout_set_region_content(layout, 0, 0, 2, 6, (View*)navigator);
-    layout_set_region_content(layout, 2, 0, 5, 2, (View*)view1);
-    layout_set_region_content(layout, 2, 2, 5, 2, (View*)view2);
-    layout_set_region_content(layout, 2, 4, 5, 2, (View*)view3);
-    
-    /* Show bar at position 2 */
-    layout_set_bar_position(layout, 2);
-    layout_show_bar(layout, 1);
-    
-    /* Set active region */
-    layout_set_active_region(layout, layout_get_region(layout, 0, 0));
-    
     /* Store layout for mouse handler */
     g_layout_demo_layout = layout;
     g_layout_demo_needs_redraw = 0;
     
     /* Initial draw */
+    frame_pacer_reset();
     layout_draw(layout, gc);
     if (dispi_is_double_buffered()) {
-        /* Draw cursor on backbuffer before flipping */
-        dispi_cursor_show();
         dispi_flip_buffers();
-    } else {
-        /* Single buffered - just show cursor */
-        dispi_cursor_show();
     }
+    dispi_cursor_show();
     
     serial_write_string("Layout demo displayed. Use arrows to navigate, click views, ESC to exit\n");
     
@@ -483,6 +537,10 @@ void test_layout_demo(void) {
         } else if (key == '1') {
             /* Demo: Switch to single layout */
             serial_write_string("Switching to single layout\n");
+            /* A text view swapped out by '2' is no longer in the layout */
+            if (content && !content->base.parent) {
+                view_destroy((View*)content);
+            }
             content = create_text_view(0, 0, 7, 6, "Full screen text view");
             layout_set_single(layout, (View*)content);
             g_layout_demo_needs_redraw = 1;
@@ -511,16 +569,12 @@ void test_layout_demo(void) {
         if (g_layout_demo_needs_redraw || (layout && layout->needs_redraw) || 
             (layout->root_view && layout->root_view->needs_redraw)) {
             /* Draw the layout */
+            frame_begin();
             layout_draw(layout, gc);
             
-            /* Ensure cursor is redrawn on top by hiding and showing it */
-            /* This forces it to be drawn on the current backbuffer */
-            dispi_cursor_hide();
-            dispi_cursor_show();
-            
-            /* Now flip buffers to show everything */
+            /* Now flip buffers to show everything, at the next retrace */
             /* Even if double buffering failed, still try to flip */
-            dispi_flip_buffers();
+            frame_present();
             
             g_layout_demo_needs_redraw = 0;  /* Clear the flag */
         }
@@ -529,8 +583,26 @@ void test_layout_demo(void) {
     /* Cleanup */
     serial_write_string("Cleaning up layout demo\n");
     
+    /* Views swapped out by the '1'/'2' keys are no longer attached to
+     * the layout, so they are not freed with it */
+    g_layout_demo_layout = NULL;
+    if (content && !content->base.parent) {
+        view_destroy((View*)content);
+    }
+    if (view2 && !view2->base.parent) {
+        view_destroy((View*)view2);
+    }
+    if (view3 && !view3->base.parent) {
+        view_destroy((View*)view3);
+    }
+    layout_report_draw_stats(layout);
+    frame_pacer_report();
     layout_destroy(layout);
     
+    /* Every demo view is gone from the tree; release their memory */
+    arena_destroy(g_layout_demo_arena);
+    g_layout_demo_arena = NULL;
+    
     /* Cleanup DISPI graphics mode using common cleanup */
     dispi_graphics_cleanup(gc);
     
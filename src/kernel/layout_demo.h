@@ -14,4 +14,8 @@
 /* Main demo function */
 void test_layout_demo(void);
 
+/* Build and destroy the demo layout without entering graphics mode, for
+ * allocator stress tests */
+void layout_demo_alloc_cycle(void);
+
 #endif /* LAYOUT_DEMO_H */
\ No newline at end of file
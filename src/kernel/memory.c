@@ -2,94 +2,558 @@
  *
  * DESIGN
  * ------
- * This is a bump allocator (linear allocator) - the simplest form of
- * memory allocation. It maintains a single pointer that "bumps" forward
- * with each allocation. 
- * 
- * Advantages:
- * - Extremely fast allocation (just increment a pointer)
- * - No fragmentation within allocated region
- * - Minimal memory overhead (just one pointer)
- * - Perfect for phase-based allocation patterns
- * 
- * Limitations:
- * - Cannot free individual allocations
- * - Memory can only be reclaimed all at once
- * - No reuse of freed memory until full reset
- * 
+ * A segregated-fit allocator with two halves that grow toward each other
+ * from opposite ends of the heap:
+ *
+ *   heap_start                                              heap_end
+ *   | large blocks -->  |      wilderness      |  <-- slabs        |
+ *                    large_top             slab_low
+ *
+ * Small requests (up to 1KB) are served from slabs. A slab is a 4KB,
+ * 4KB-aligned page carved from the top of the heap and cut into equal
+ * objects of one size class (16, 32, ... 1024 bytes). Free objects are
+ * chained through their first word, so malloc and free are a few pointer
+ * moves, and the owning slab is found by masking the object address.
+ * A slab whose objects are all free goes to a pool shared by every class.
+ *
+ * Larger requests are served from the bottom by a best-fit free list of
+ * variable-size blocks. Each block carries its size in a header and a
+ * footer (boundary tags), so free() can merge a block with both
+ * neighbours in constant time. A free block that touches the wilderness
+ * is handed back to it, which lets the heap shrink again after a big
+ * buffer (like the 300KB DISPI backbuffer) is released.
+ *
+ * Why two halves: the UI creates many small objects (views, buttons,
+ * labels) alongside a few large ones (backbuffers, TextAreas). Mixing
+ * them in one free list fragments it quickly; slabs keep small objects
+ * packed, and the large list stays short enough to search in full.
+ *
+ * All returned pointers are 16-byte aligned.
+ *
  * Memory Layout:
- * The heap starts at 3MB (0x300000) and extends to 4MB (0x400000),
- * giving us 1MB of heap space. This is well above our kernel and stack.
+ * The heap starts at 3MB (0x300000), well above our kernel and stack,
+ * and extends to the end of that usable RAM region as reported by the
+ * BIOS E820 map that boot.asm collects (about 125MB under QEMU -m 128M).
+ * Without a map it falls back to a fixed 1MB heap ending at 4MB.
  */
 
 #include "memory.h"
 #include "serial.h"
 
 /* Heap configuration.
- * We place the heap at 3MB, well clear of our kernel (loaded at 1MB)
- * and stack (at 2MB growing down). This gives us a clean 1MB heap. */
+ * We place the heap at 3MB, well clear of our kernel (loaded at 32KB)
+ * and stack (at 2MB growing down). HEAP_END is only used when the BIOS
+ * gave us no memory map. */
 #define HEAP_START 0x300000  /* 3MB mark */
-#define HEAP_END   0x400000  /* 4MB mark */
-#define HEAP_SIZE  (HEAP_END - HEAP_START)  /* 1MB heap */
+#define HEAP_END   0x400000  /* 4MB mark, fallback end */
 
-/* Alignment requirement for allocations.
- * Aligning to 4 bytes ensures proper access for 32-bit values. */
-#define ALIGN_SIZE 4
+/* E820 memory map left by boot.asm (see MEMMAP_* there) */
+#define MEMMAP_COUNT   ((unsigned int*)0x5000)
+#define MEMMAP_ENTRIES ((MemoryMapEntry*)0x5010)
+#define MEMMAP_MAX     32
+#define E820_USABLE    1
+
+/* One E820 entry. Addresses are 64-bit; we only use the low 4GB. */
+typedef struct MemoryMapEntry {
+    unsigned int base_low;
+    unsigned int base_high;
+    unsigned int length_low;
+    unsigned int length_high;
+    unsigned int type;              /* 1 usable, 2 reserved, 3 ACPI, ... */
+    unsigned int acpi;              /* ACPI 3.0 attributes */
+} MemoryMapEntry;
+
+/* Alignment of every returned pointer */
+#define ALIGN_SIZE 16
 #define ALIGN_MASK (ALIGN_SIZE - 1)
 
 /* Align a size up to the nearest multiple of ALIGN_SIZE */
 #define ALIGN_UP(size) (((size) + ALIGN_MASK) & ~ALIGN_MASK)
 
-/* Current position of the bump allocator */
-static unsigned char* heap_current = (unsigned char*)HEAP_START;
+/* Slab configuration */
+#define SLAB_SIZE 4096
+#define SLAB_MASK (~(size_t)(SLAB_SIZE - 1))
+#define SLAB_CLASSES 7              /* 16, 32, 64, 128, 256, 512, 1024 */
+#define SLAB_MIN_SHIFT 4
+#define SLAB_MAX_OBJECT 1024
+#define SLAB_MAGIC 0x51AB
+
+/* Large block configuration */
+#define LARGE_MAGIC_USED 0xB10C0BE1
+#define LARGE_MAGIC_FREE 0xF4EEB10C
+#define LARGE_HEADER_SIZE 16
+#define LARGE_FOOTER_SIZE 4
+#define LARGE_MIN_BLOCK 64          /* Smallest remainder worth splitting off */
+
+/* Header at the start of every slab. Objects follow it, starting at the
+ * first ALIGN_SIZE boundary. */
+typedef struct Slab {
+    struct Slab *next;              /* Next slab in class list or pool */
+    struct Slab *prev;
+    void *free_list;                /* First free object */
+    unsigned short magic;
+    unsigned short class_index;
+    unsigned short free_count;
+    unsigned short capacity;
+} Slab;
+
+#define SLAB_HEADER_SIZE ALIGN_UP(sizeof(Slab))
+
+/* Header of a large block. The payload starts right after it; while the
+ * block is free, the payload holds the free list links. The last word of
+ * every block repeats its size (the footer). */
+typedef struct LargeBlock {
+    size_t size;                    /* Whole block, header and footer included */
+    size_t magic;                   /* LARGE_MAGIC_USED or LARGE_MAGIC_FREE */
+    size_t reserved[2];             /* Pads the header to 16 bytes */
+    struct LargeBlock *prev_free;   /* Only valid while free */
+    struct LargeBlock *next_free;
+} LargeBlock;
+
+/* Heap bounds and the two growth edges */
+static unsigned char* heap_start = (unsigned char*)HEAP_START;
+static unsigned char* heap_end = (unsigned char*)HEAP_END;
+static unsigned char* large_top = (unsigned char*)HEAP_START;
+static unsigned char* slab_low = (unsigned char*)HEAP_END;
+
+/* Heap bounds chosen from the memory map, once per boot */
+static unsigned char* heap_limit = NULL;
+
+/* Slabs with at least one free object, per class, and fully free slabs */
+static Slab* slab_partial[SLAB_CLASSES];
+static Slab* slab_pool = NULL;
+
+/* Free large blocks (unordered) */
+static LargeBlock* large_free = NULL;
 
 /* Statistics tracking */
-static size_t total_allocated = 0;
-static size_t allocation_count = 0;
+static size_t bytes_in_use = 0;         /* Bytes handed out (block sizes) */
+static size_t peak_in_use = 0;
+static size_t peak_footprint = 0;       /* Largest span taken from the heap */
+static size_t allocation_count = 0;     /* Live allocations */
+static size_t total_allocations = 0;    /* Since init */
+static size_t failed_allocations = 0;
+static size_t class_in_use[SLAB_CLASSES];
+
+/* Bytes of the heap claimed by either half */
+static size_t heap_footprint(void) {
+    return (size_t)(large_top - heap_start) + (size_t)(heap_end - slab_low);
+}
+
+/* Update usage counters after an allocation of the given block size */
+static void note_alloc(size_t size) {
+    size_t footprint;
+    
+    bytes_in_use += size;
+    allocation_count++;
+    total_allocations++;
+    if (bytes_in_use > peak_in_use) {
+        peak_in_use = bytes_in_use;
+    }
+    footprint = heap_footprint();
+    if (footprint > peak_footprint) {
+        peak_footprint = footprint;
+    }
+}
+
+static const char* memory_map_type_name(unsigned int type) {
+    switch (type) {
+        case 1: return "usable";
+        case 2: return "reserved";
+        case 3: return "ACPI reclaimable";
+        case 4: return "ACPI NVS";
+        case 5: return "bad";
+        default: return "unknown";
+    }
+}
+
+/* Log the E820 map and pick the end of the heap: the end of the usable
+ * region that contains HEAP_START. Regions above 4GB are ignored, and a
+ * region reaching past 4GB is cut off there.
+ * Why only that region: the heap must be contiguous, and on PCs the RAM
+ * from 1MB up is one region until the PCI hole, so nothing is lost. */
+static unsigned char* memory_map_heap_end(void) {
+    MemoryMapEntry *entry;
+    unsigned int count = *MEMMAP_COUNT;
+    unsigned int i;
+    unsigned int end;
+    unsigned int heap_end_found = 0;
+    
+    if (count == 0 || count > MEMMAP_MAX) {
+        serial_write_string("Memory map: none from BIOS, using fixed heap\n");
+        return (unsigned char*)HEAP_END;
+    }
+    
+    serial_write_string("Memory map (E820):\n");
+    for (i = 0; i < count; i++) {
+        entry = &MEMMAP_ENTRIES[i];
+        
+        serial_write_string("  ");
+        serial_write_hex(entry->base_high);
+        serial_write_string(":");
+        serial_write_hex(entry->base_low);
+        serial_write_string(" length ");
+        serial_write_hex(entry->length_high);
+        serial_write_string(":");
+        serial_write_hex(entry->length_low);
+        serial_write_string(" ");
+        serial_write_string(memory_map_type_name(entry->type));
+        serial_write_string("\n");
+        
+        /* ACPI 3.0 bit 0 clear means "ignore this entry" */
+        if (entry->type != E820_USABLE || !(entry->acpi & 1) ||
+            entry->base_high != 0) {
+            continue;
+        }
+        
+        /* Clip at 4GB so the end fits in 32 bits */
+        if (entry->length_high != 0 ||
+            entry->length_low > 0xFFFFF000 - entry->base_low) {
+            end = 0xFFFFF000;
+        } else {
+            end = entry->base_low + entry->length_low;
+        }
+        
+        if (entry->base_low <= HEAP_START && end > HEAP_START) {
+            heap_end_found = end;
+        }
+    }
+    
+    if (heap_end_found < HEAP_START + SLAB_SIZE) {
+        serial_write_string("Memory map: no usable RAM at heap start, using fixed heap\n");
+        return (unsigned char*)HEAP_END;
+    }
+    return (unsigned char*)heap_end_found;
+}
 
 /* Initialize the memory allocator */
 void init_memory(void) {
-    heap_current = (unsigned char*)HEAP_START;
-    total_allocated = 0;
+    int i;
+    
+    if (!heap_limit) {
+        heap_limit = memory_map_heap_end();
+    }
+    
+    heap_start = (unsigned char*)HEAP_START;
+    heap_end = (unsigned char*)((size_t)heap_limit & SLAB_MASK);
+    large_top = heap_start;
+    slab_low = heap_end;
+    
+    for (i = 0; i < SLAB_CLASSES; i++) {
+        slab_partial[i] = NULL;
+        class_in_use[i] = 0;
+    }
+    slab_pool = NULL;
+    large_free = NULL;
+    
+    bytes_in_use = 0;
+    peak_in_use = 0;
+    peak_footprint = 0;
     allocation_count = 0;
+    total_allocations = 0;
+    failed_allocations = 0;
     
     serial_write_string("Memory allocator initialized: ");
-    serial_write_int(HEAP_SIZE / 1024);
-    serial_write_string("KB heap at 0x");
-    serial_write_hex(HEAP_START);
+    serial_write_int((size_t)(heap_end - heap_start) / 1024);
+    serial_write_string("KB heap at ");
+    serial_write_hex((size_t)heap_start);
+    serial_write_string("-");
+    serial_write_hex((size_t)heap_end);
     serial_write_string("\n");
 }
 
-/* Allocate memory using bump allocation */
+/* Size class index for a small request */
+static int slab_class_of(size_t size) {
+    int index = 0;
+    size_t object = 1 << SLAB_MIN_SHIFT;
+    
+    while (object < size) {
+        object <<= 1;
+        index++;
+    }
+    return index;
+}
+
+/* Unlink a slab from the partial list of its class */
+static void slab_unlink(Slab *slab) {
+    if (slab->prev) {
+        slab->prev->next = slab->next;
+    } else {
+        slab_partial[slab->class_index] = slab->next;
+    }
+    if (slab->next) {
+        slab->next->prev = slab->prev;
+    }
+    slab->next = NULL;
+    slab->prev = NULL;
+}
+
+/* Push a slab onto the partial list of its class */
+static void slab_link(Slab *slab) {
+    slab->prev = NULL;
+    slab->next = slab_partial[slab->class_index];
+    if (slab->next) {
+        slab->next->prev = slab;
+    }
+    slab_partial[slab->class_index] = slab;
+}
+
+/* Get an empty slab for a class, from the pool or the wilderness */
+static Slab* slab_new(int class_index) {
+    Slab *slab;
+    size_t object = (size_t)1 << (class_index + SLAB_MIN_SHIFT);
+    unsigned char *p;
+    int i;
+    
+    if (slab_pool) {
+        slab = slab_pool;
+        slab_pool = slab->next;
+    } else {
+        if (slab_low - SLAB_SIZE < large_top) {
+            return NULL;
+        }
+        slab_low -= SLAB_SIZE;
+        slab = (Slab*)slab_low;
+    }
+    
+    slab->magic = SLAB_MAGIC;
+    slab->class_index = class_index;
+    slab->capacity = (SLAB_SIZE - SLAB_HEADER_SIZE) / object;
+    slab->free_count = slab->capacity;
+    
+    /* Thread the free list through the objects in address order */
+    p = (unsigned char*)slab + SLAB_HEADER_SIZE;
+    slab->free_list = p;
+    for (i = 0; i < slab->capacity - 1; i++) {
+        *(void**)p = p + object;
+        p += object;
+    }
+    *(void**)p = NULL;
+    
+    slab_link(slab);
+    return slab;
+}
+
+/* Return pooled slabs at the low edge to the wilderness, so large
+ * blocks can use the space again */
+static void slab_trim(void) {
+    Slab **link;
+    int found = 1;
+    
+    while (found) {
+        found = 0;
+        for (link = &slab_pool; *link; link = &(*link)->next) {
+            if ((unsigned char*)*link == slab_low) {
+                *link = (*link)->next;
+                slab_low += SLAB_SIZE;
+                found = 1;
+                break;
+            }
+        }
+    }
+}
+
+/* Allocate a small object */
+static void* slab_alloc(size_t size) {
+    int class_index = slab_class_of(size);
+    Slab *slab = slab_partial[class_index];
+    void *object;
+    
+    if (!slab) {
+        slab = slab_new(class_index);
+        if (!slab) return NULL;
+    }
+    
+    object = slab->free_list;
+    slab->free_list = *(void**)object;
+    slab->free_count--;
+    
+    /* A full slab leaves the list until something in it is freed */
+    if (slab->free_count == 0) {
+        slab_unlink(slab);
+    }
+    
+    class_in_use[class_index]++;
+    note_alloc((size_t)1 << (class_index + SLAB_MIN_SHIFT));
+    return object;
+}
+
+/* Free a small object */
+static void slab_free(void *ptr) {
+    Slab *slab = (Slab*)((size_t)ptr & SLAB_MASK);
+    
+    if (slab->magic != SLAB_MAGIC) {
+        serial_write_string("ERROR: free() of invalid pointer 0x");
+        serial_write_hex((size_t)ptr);
+        serial_write_string("\n");
+        return;
+    }
+    
+    *(void**)ptr = slab->free_list;
+    slab->free_list = ptr;
+    slab->free_count++;
+    
+    class_in_use[slab->class_index]--;
+    bytes_in_use -= (size_t)1 << (slab->class_index + SLAB_MIN_SHIFT);
+    allocation_count--;
+    
+    if (slab->free_count == 1) {
+        /* Was full, so it is not on the partial list yet */
+        slab_link(slab);
+    }
+    
+    if (slab->free_count == slab->capacity) {
+        /* Entirely free: give the page to the shared pool */
+        slab_unlink(slab);
+        slab->magic = 0;
+        slab->next = slab_pool;
+        slab_pool = slab;
+        slab_trim();
+    }
+}
+
+/* Write a large block's header and footer */
+static void large_set(LargeBlock *block, size_t size, size_t magic) {
+    block->size = size;
+    block->magic = magic;
+    *(size_t*)((unsigned char*)block + size - LARGE_FOOTER_SIZE) = size;
+}
+
+/* Remove a block from the large free list */
+static void large_unlink(LargeBlock *block) {
+    if (block->prev_free) {
+        block->prev_free->next_free = block->next_free;
+    } else {
+        large_free = block->next_free;
+    }
+    if (block->next_free) {
+        block->next_free->prev_free = block->prev_free;
+    }
+}
+
+/* Add a block to the large free list */
+static void large_link(LargeBlock *block) {
+    block->prev_free = NULL;
+    block->next_free = large_free;
+    if (large_free) {
+        large_free->prev_free = block;
+    }
+    large_free = block;
+}
+
+/* Allocate a large block */
+static void* large_alloc(size_t size) {
+    size_t need = ALIGN_UP(LARGE_HEADER_SIZE + size + LARGE_FOOTER_SIZE);
+    LargeBlock *block;
+    LargeBlock *best = NULL;
+    LargeBlock *rest;
+    
+    /* Best fit keeps big free blocks whole for big requests */
+    for (block = large_free; block; block = block->next_free) {
+        if (block->size >= need && (!best || block->size < best->size)) {
+            best = block;
+            if (block->size == need) break;
+        }
+    }
+    
+    if (best) {
+        large_unlink(best);
+        if (best->size - need >= LARGE_MIN_BLOCK) {
+            rest = (LargeBlock*)((unsigned char*)best + need);
+            large_set(rest, best->size - need, LARGE_MAGIC_FREE);
+            large_link(rest);
+            large_set(best, need, LARGE_MAGIC_USED);
+        } else {
+            best->magic = LARGE_MAGIC_USED;
+        }
+    } else {
+        /* Nothing fits: grow into the wilderness */
+        if ((size_t)(slab_low - large_top) < need) {
+            return NULL;
+        }
+        best = (LargeBlock*)large_top;
+        large_top += need;
+        large_set(best, need, LARGE_MAGIC_USED);
+    }
+    
+    note_alloc(best->size);
+    return (unsigned char*)best + LARGE_HEADER_SIZE;
+}
+
+/* Free a large block, merging it with free neighbours */
+static void large_free_block(void *ptr) {
+    LargeBlock *block = (LargeBlock*)((unsigned char*)ptr - LARGE_HEADER_SIZE);
+    LargeBlock *next;
+    LargeBlock *prev;
+    size_t size;
+    
+    if (block->magic != LARGE_MAGIC_USED) {
+        serial_write_string(block->magic == LARGE_MAGIC_FREE ?
+                            "ERROR: double free of 0x" :
+                            "ERROR: free() of invalid pointer 0x");
+        serial_write_hex((size_t)ptr);
+        serial_write_string("\n");
+        return;
+    }
+    
+    size = block->size;
+    bytes_in_use -= size;
+    allocation_count--;
+    
+    /* Merge with the following block */
+    next = (LargeBlock*)((unsigned char*)block + size);
+    if ((unsigned char*)next < large_top && next->magic == LARGE_MAGIC_FREE) {
+        large_unlink(next);
+        size += next->size;
+    }
+    
+    /* Merge with the preceding block, found through its footer */
+    if ((unsigned char*)block > heap_start) {
+        prev = (LargeBlock*)((unsigned char*)block -
+                             *(size_t*)((unsigned char*)block - LARGE_FOOTER_SIZE));
+        if (prev->magic == LARGE_MAGIC_FREE) {
+            large_unlink(prev);
+            size += prev->size;
+            block = prev;
+        }
+    }
+    
+    /* Give a block at the top edge back to the wilderness */
+    if ((unsigned char*)block + size == large_top) {
+        block->magic = 0;
+        large_top = (unsigned char*)block;
+        return;
+    }
+    
+    large_set(block, size, LARGE_MAGIC_FREE);
+    large_link(block);
+}
+
+/* Allocate memory */
 void* malloc(size_t size) {
     void* result;
-    size_t aligned_size;
     
     /* Handle zero size */
     if (size == 0) {
         return NULL;
     }
     
-    /* Align the size for proper memory alignment */
-    aligned_size = ALIGN_UP(size);
+    if (size <= SLAB_MAX_OBJECT) {
+        result = slab_alloc(size);
+    } else {
+        result = large_alloc(size);
+    }
     
-    /* Check if we have enough space */
-    if ((size_t)(heap_current + aligned_size) > HEAP_END) {
+    if (!result) {
         /* Out of memory */
+        failed_allocations++;
         serial_write_string("ERROR: Out of heap memory! Requested: ");
         serial_write_int(size);
         serial_write_string(" bytes, available: ");
-        serial_write_int(HEAP_END - (size_t)heap_current);
+        serial_write_int(get_heap_free());
         serial_write_string(" bytes\n");
-        return NULL;
     }
     
-    /* Allocate by returning current position and bumping pointer */
-    result = heap_current;
-    heap_current += aligned_size;
-    total_allocated += aligned_size;
-    allocation_count++;
-    
     return result;
 }
 
@@ -115,79 +579,238 @@ void* calloc(size_t count, size_t size) {
     return ptr;
 }
 
-/* Free is a no-op in bump allocator.
- * We provide this function for compatibility but it does nothing.
- * To actually free memory, use reset_heap() to free everything at once. */
+/* Return memory to the heap.
+ * The two halves never interleave, so the address alone says whether
+ * ptr is a slab object or a large block. */
 void free(void* ptr) {
-    /* Bump allocator doesn't support individual frees */
-    /* This is intentionally empty */
-    (void)ptr;  /* Suppress unused parameter warning */
+    unsigned char *p = (unsigned char*)ptr;
+    
+    if (!ptr) return;
+    
+    if (p >= slab_low && p < heap_end) {
+        slab_free(ptr);
+    } else if (p >= heap_start + LARGE_HEADER_SIZE && p < large_top) {
+        large_free_block(ptr);
+    } else {
+        serial_write_string("ERROR: free() of pointer outside heap 0x");
+        serial_write_hex((size_t)ptr);
+        serial_write_string("\n");
+    }
 }
 
 /* Reset the entire heap */
 void reset_heap(void) {
-    heap_current = (unsigned char*)HEAP_START;
-    
     serial_write_string("Heap reset: freed ");
-    serial_write_int(total_allocated);
+    serial_write_int(bytes_in_use);
     serial_write_string(" bytes from ");
     serial_write_int(allocation_count);
     serial_write_string(" allocations\n");
     
-    total_allocated = 0;
-    allocation_count = 0;
+    init_memory();
 }
 
-/* Get current heap usage */
+/* Get bytes currently allocated */
 size_t get_heap_used(void) {
-    return (size_t)(heap_current - HEAP_START);
+    return bytes_in_use;
 }
 
 /* Get total heap size */
 size_t get_heap_size(void) {
-    return HEAP_SIZE;
+    return (size_t)(heap_end - heap_start);
 }
 
-/* Get free heap space */
+/* Get free heap space (free blocks, free slab objects and wilderness) */
 size_t get_heap_free(void) {
-    return HEAP_END - (size_t)heap_current;
+    return get_heap_size() - bytes_in_use;
+}
+
+/* Get the heap span claimed by slabs and large blocks */
+size_t get_heap_footprint(void) {
+    return heap_footprint();
+}
+
+/* Log allocator statistics to the debug port */
+void memory_report_stats(void) {
+    LargeBlock *block;
+    Slab *slab;
+    size_t free_bytes = 0;
+    size_t largest = 0;
+    size_t wilderness = (size_t)(slab_low - large_top);
+    size_t free_blocks = 0;
+    size_t pooled = 0;
+    size_t slab_bytes = 0;
+    size_t slab_used = 0;
+    int i;
+    
+    for (block = large_free; block; block = block->next_free) {
+        free_bytes += block->size;
+        free_blocks++;
+        if (block->size > largest) largest = block->size;
+    }
+    for (slab = slab_pool; slab; slab = slab->next) {
+        pooled++;
+    }
+    for (i = 0; i < SLAB_CLASSES; i++) {
+        slab_used += class_in_use[i] << (i + SLAB_MIN_SHIFT);
+    }
+    slab_bytes = (size_t)(heap_end - slab_low) - pooled * SLAB_SIZE;
+    
+    serial_write_string("Heap: ");
+    serial_write_int(bytes_in_use);
+    serial_write_string(" bytes in ");
+    serial_write_int(allocation_count);
+    serial_write_string(" allocations (peak ");
+    serial_write_int(peak_in_use);
+    serial_write_string("), footprint ");
+    serial_write_int(heap_footprint());
+    serial_write_string(" (peak ");
+    serial_write_int(peak_footprint);
+    serial_write_string(") of ");
+    serial_write_int(get_heap_size());
+    serial_write_string("\n");
+    
+    /* External fragmentation of the large half: how much of the free
+     * space outside the wilderness could not serve one request */
+    serial_write_string("Heap: large free list ");
+    serial_write_int(free_blocks);
+    serial_write_string(" blocks, ");
+    serial_write_int(free_bytes);
+    serial_write_string(" bytes, largest ");
+    serial_write_int(largest);
+    serial_write_string(", fragmentation ");
+    serial_write_int(free_bytes ? 100 - (largest * 100) / free_bytes : 0);
+    serial_write_string("%, wilderness ");
+    serial_write_int(wilderness);
+    serial_write_string("\n");
+    
+    serial_write_string("Heap: slabs ");
+    serial_write_int(slab_used);
+    serial_write_string(" of ");
+    serial_write_int(slab_bytes);
+    serial_write_string(" bytes used, ");
+    serial_write_int(pooled);
+    serial_write_string(" empty slabs pooled; per class");
+    for (i = 0; i < SLAB_CLASSES; i++) {
+        serial_write_string(" ");
+        serial_write_int(16 << i);
+        serial_write_string(":");
+        serial_write_int(class_in_use[i]);
+    }
+    serial_write_string("\n");
+    
+    if (failed_allocations) {
+        serial_write_string("Heap: ");
+        serial_write_int(failed_allocations);
+        serial_write_string(" failed allocations\n");
+    }
+}
+
+/* Copy n bytes upward through memory, lowest address first.
+ * Why rep movsd: the 300KB DISPI flip and per-row dirty copies spend
+ * all their time here, and a string instruction moves 4 bytes per step
+ * with no loop overhead. Leading bytes are copied singly until dest is
+ * dword aligned, so the stores never straddle a dword boundary (which
+ * matters most for framebuffer memory). */
+static void copy_forward(unsigned char* d, const unsigned char* s, size_t n) {
+    size_t head;
+    size_t dwords;
+    size_t tail;
+    
+    if (n >= 16) {
+        head = (0 - (size_t)d) & 3;
+        n -= head;
+        while (head--) {
+            *d++ = *s++;
+        }
+    }
+    
+    dwords = n >> 2;
+    tail = n & 3;
+    __asm__ __volatile__("rep movsl\n\t"
+                         "movl %3, %%ecx\n\t"
+                         "rep movsb"
+                         : "+D"(d), "+S"(s), "+c"(dwords)
+                         : "r"(tail)
+                         : "memory");
+}
+
+/* Copy n bytes downward through memory, highest address first, for an
+ * overlapping move to a higher address. The odd tail bytes go first,
+ * then whole dwords with the direction flag set. */
+static void copy_backward(unsigned char* d, const unsigned char* s, size_t n) {
+    size_t dwords = n >> 2;
+    size_t tail = n & 3;
+    
+    while (tail--) {
+        n--;
+        d[n] = s[n];
+    }
+    
+    if (dwords) {
+        d += n - 4;
+        s += n - 4;
+        __asm__ __volatile__("std\n\t"
+                             "rep movsl\n\t"
+                             "cld"
+                             : "+D"(d), "+S"(s), "+c"(dwords)
+                             :
+                             : "memory");
+    }
 }
 
 /* Memory copy implementation.
  * Copies n bytes from src to dest. Returns dest.
- * Handles overlapping regions correctly. */
+ * The regions must not overlap - use memmove for that. */
 void* memcpy(void* dest, const void* src, size_t n) {
+    copy_forward((unsigned char*)dest, (const unsigned char*)src, n);
+    return dest;
+}
+
+/* Memory move implementation.
+ * Copies n bytes from src to dest, correct even if they overlap.
+ * Returns dest. */
+void* memmove(void* dest, const void* src, size_t n) {
     unsigned char* d = (unsigned char*)dest;
     const unsigned char* s = (const unsigned char*)src;
-    size_t i;
     
-    /* Check for overlap - if dest is after src and regions overlap,
-     * we need to copy backwards to avoid corruption */
+    /* Copying upward is safe unless dest starts inside src */
     if (d > s && d < s + n) {
-        /* Copy backwards */
-        for (i = n; i > 0; i--) {
-            d[i-1] = s[i-1];
-        }
+        copy_backward(d, s, n);
     } else {
-        /* Copy forwards (normal case) */
-        for (i = 0; i < n; i++) {
-            d[i] = s[i];
-        }
+        copy_forward(d, s, n);
     }
     
     return dest;
 }
 
 /* Memory set implementation.
- * Sets n bytes of memory at s to the value c. Returns s. */
+ * Sets n bytes of memory at s to the value c. Returns s.
+ * Aligns the destination, then stores the byte replicated into a dword
+ * with rep stosd. */
 void* memset(void* s, int c, size_t n) {
     unsigned char* p = (unsigned char*)s;
-    size_t i;
+    unsigned int pattern = (unsigned char)c * 0x01010101U;
+    size_t head;
+    size_t dwords;
+    size_t tail;
     
-    for (i = 0; i < n; i++) {
-        p[i] = (unsigned char)c;
+    if (n >= 16) {
+        head = (0 - (size_t)p) & 3;
+        n -= head;
+        while (head--) {
+            *p++ = (unsigned char)c;
+        }
     }
     
+    dwords = n >> 2;
+    tail = n & 3;
+    __asm__ __volatile__("rep stosl\n\t"
+                         "movl %3, %%ecx\n\t"
+                         "rep stosb"
+                         : "+D"(p), "+c"(dwords)
+                         : "a"(pattern), "r"(tail)
+                         : "memory");
+    
     return s;
 }
 
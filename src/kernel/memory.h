@@ -1,9 +1,8 @@
 /* Memory Management for Aquinas OS
  * 
- * Simple bump allocator implementation.
- * The allocator starts at a fixed address after the kernel and bumps
- * a pointer forward for each allocation. Very fast but no individual
- * deallocation - only bulk free.
+ * Segregated-fit allocator: slabs of fixed-size objects for requests up
+ * to 1KB, and a coalescing free list for larger blocks. free() returns
+ * memory for reuse. See memory.c for the layout.
  */
 
 #ifndef MEMORY_H
@@ -21,11 +20,12 @@ typedef unsigned int size_t;
 #endif
 
 /* Initialize the memory allocator.
- * Sets up the heap region starting after the kernel. */
+ * Sets up the heap from 3MB to the end of usable RAM, using the BIOS
+ * memory map left by the bootloader (logged on the first call). */
 void init_memory(void);
 
 /* Allocate memory of given size.
- * Returns pointer to allocated memory or NULL if out of memory.
+ * Returns a 16-byte aligned pointer or NULL if out of memory.
  * Memory is NOT zeroed. */
 void* malloc(size_t size);
 
@@ -33,12 +33,11 @@ void* malloc(size_t size);
  * Returns pointer to zeroed memory or NULL if out of memory. */
 void* calloc(size_t count, size_t size);
 
-/* Free is a no-op in bump allocator.
- * Provided for compatibility but does nothing. */
+/* Return memory from malloc/calloc to the heap. NULL is ignored. */
 void free(void* ptr);
 
 /* Reset the entire heap.
- * Frees all allocations at once by resetting the bump pointer. */
+ * Frees all allocations at once; every outstanding pointer is invalid. */
 void reset_heap(void);
 
 /* Get current heap usage statistics */
@@ -46,8 +45,16 @@ size_t get_heap_used(void);
 size_t get_heap_size(void);
 size_t get_heap_free(void);
 
-/* Memory copy and set functions (since we don't have libc) */
+/* Bytes of the heap claimed by slabs and large blocks, free or not */
+size_t get_heap_footprint(void);
+
+/* Log usage, peak, fragmentation and slab statistics to COM2 */
+void memory_report_stats(void);
+
+/* Memory copy and set functions (since we don't have libc).
+ * memcpy requires that the regions do not overlap; memmove allows it. */
 void* memcpy(void* dest, const void* src, size_t n);
+void* memmove(void* dest, const void* src, size_t n);
 void* memset(void* s, int c, size_t n);
 int memcmp(const void* s1, const void* s2, size_t n);
 
@@ -5,8 +5,8 @@
  */
 
 #include "mouse.h"
-#include "io.h"
 #include "serial.h"
+#include "input_irq.h"
 
 /* Global mouse state */
 static MouseState mouse_state = {
@@ -76,6 +76,7 @@ static void fire_mouse_event(EventType type, int x, int y, int button) {
 
 /* Poll for mouse input and generate events */
 void mouse_poll(void) {
+    InputRawEvent event;
     unsigned char data;
     signed char dx, dy;
     int old_x, old_y;
@@ -83,10 +84,10 @@ void mouse_poll(void) {
     
     if (!mouse_state.initialized) return;
     
-    /* Check for serial data on COM1 */
-    if (!(inb(0x3FD) & 0x01)) return;
+    /* Take the next byte the COM1 interrupt queued */
+    if (!input_mouse_pop(&event)) return;
     
-    data = inb(0x3F8);
+    data = event.data;
     
     /* Microsoft Serial Mouse protocol parsing */
     if (data & 0x40) {
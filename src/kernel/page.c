@@ -27,12 +27,29 @@ Page* allocate_page(void) {
     page->buffer = (char*)calloc(PAGE_SIZE, sizeof(char));
     if (page->buffer == NULL) {
         serial_write_string("ERROR: Failed to allocate page buffer\n");
-        /* Note: We can't free the page in bump allocator, but that's ok */
+        free(page);
         return NULL;
     }
     
-    /* Initialize page fields */
+    /* Allocate the line index */
+    page->lines = (PageLine*)malloc(PAGE_LINES_INITIAL * sizeof(PageLine));
+    if (page->lines == NULL) {
+        serial_write_string("ERROR: Failed to allocate page line index\n");
+        free(page->buffer);
+        free(page);
+        return NULL;
+    }
+    page->line_capacity = PAGE_LINES_INITIAL;
+    
+    /* Initialize page fields - the whole buffer starts out as gap */
+    page->gap_start = 0;
+    page->gap_end = PAGE_SIZE;
     page->length = 0;
+    page->line_count = 1;
+    page->lines[0].start = 0;
+    page->lines[0].width = 0;
+    page->lines[0].row = 0;
+    page->lines[0].tabs = 0;
     page->cursor_pos = 0;
     page->highlight_start = 0;
     page->highlight_end = 0;
@@ -116,4 +133,334 @@ void prev_page(void) {
 /* Switch to next page */
 void next_page(void) {
     navigate_to_page(current_page + 1);
-}
\ No newline at end of file
+}
+
+/* Display width of a character in columns */
+static int page_char_width(char c) {
+    return c == '\t' ? PAGE_TAB_WIDTH : 1;
+}
+
+/* Make sure the line index can hold needed entries.
+ * Returns 0 if the index could not be grown. */
+static int page_lines_reserve(Page* page, int needed) {
+    PageLine* lines;
+    int capacity;
+    int i;
+    
+    if (needed <= page->line_capacity) return 1;
+    
+    capacity = page->line_capacity;
+    while (capacity < needed) {
+        capacity *= 2;
+    }
+    
+    lines = (PageLine*)malloc(capacity * sizeof(PageLine));
+    if (lines == NULL) {
+        serial_write_string("ERROR: Failed to grow page line index\n");
+        return 0;
+    }
+    for (i = 0; i < page->line_count; i++) {
+        lines[i] = page->lines[i];
+    }
+    free(page->lines);
+    page->lines = lines;
+    page->line_capacity = capacity;
+    return 1;
+}
+
+/* Recompute the width and tab count of one line from its text */
+static void page_line_measure(Page* page, int line) {
+    PageLine* entry = &page->lines[line];
+    int end = page_line_end(page, line);
+    int pos;
+    char c;
+    
+    entry->width = 0;
+    entry->tabs = 0;
+    for (pos = entry->start; pos < end; pos++) {
+        c = page_char_at(page, pos);
+        if (c == '\t') entry->tabs++;
+        entry->width += page_char_width(c);
+    }
+}
+
+/* Recompute screen rows for every line after first.
+ * Why rows and not just starts: lines longer than the screen wrap, and
+ * the display wraps them at VGA_WIDTH columns - a line always takes
+ * width / VGA_WIDTH + 1 rows (a line of exactly 80 columns pushes its
+ * newline onto a second row, just as refresh_screen draws it). */
+static void page_lines_reflow(Page* page, int first) {
+    int i;
+    
+    if (first < 1) {
+        page->lines[0].row = 0;
+        first = 1;
+    }
+    for (i = first; i < page->line_count; i++) {
+        page->lines[i].row = page->lines[i - 1].row +
+                             page->lines[i - 1].width / VGA_WIDTH + 1;
+    }
+}
+
+/* Get the character at a logical text position.
+ * Positions at or past the gap are stored gap-size bytes further along. */
+char page_char_at(Page* page, int pos) {
+    if (pos < 0 || pos >= page->length) return '\0';
+    if (pos < page->gap_start) return page->buffer[pos];
+    return page->buffer[pos + (page->gap_end - page->gap_start)];
+}
+
+/* Overwrite the character at a logical text position */
+void page_set_char(Page* page, int pos, char c) {
+    char old;
+    int line;
+    int old_rows;
+    PageLine* entry;
+    
+    if (pos < 0 || pos >= page->length) return;
+    
+    old = page_char_at(page, pos);
+    if (old == c) return;
+    
+    /* Adding or removing a newline changes the line structure */
+    if (old == '\n' || c == '\n') {
+        page_delete(page, pos, 1);
+        page_insert(page, pos, &c, 1);
+        return;
+    }
+    
+    if (pos < page->gap_start) {
+        page->buffer[pos] = c;
+    } else {
+        page->buffer[pos + (page->gap_end - page->gap_start)] = c;
+    }
+    
+    /* Only the width of this line can change */
+    line = page_line_of(page, pos);
+    entry = &page->lines[line];
+    old_rows = entry->width / VGA_WIDTH;
+    entry->width += page_char_width(c) - page_char_width(old);
+    entry->tabs += (c == '\t') - (old == '\t');
+    if (entry->width / VGA_WIDTH != old_rows) {
+        page_lines_reflow(page, line + 1);
+    }
+}
+
+/* Move the gap so that it starts at logical position pos.
+ * Why: Insertions and deletions only touch the gap, so the cost of an
+ * edit is the distance the cursor travelled since the previous edit.
+ * While the user keeps typing in one place the gap is already there
+ * and nothing is copied at all. */
+void page_move_gap(Page* page, int pos) {
+    int count;
+    
+    if (pos < 0) pos = 0;
+    if (pos > page->length) pos = page->length;
+    
+    /* The text and its destination overlap when the move is longer than
+     * the gap, so these are memmoves */
+    if (pos < page->gap_start) {
+        /* Slide text between pos and the gap to the far side of the gap */
+        count = page->gap_start - pos;
+        memmove(page->buffer + page->gap_end - count, page->buffer + pos, count);
+        page->gap_start -= count;
+        page->gap_end -= count;
+    } else if (pos > page->gap_start) {
+        /* Slide text after the gap back down in front of it */
+        count = pos - page->gap_start;
+        memmove(page->buffer + page->gap_start, page->buffer + page->gap_end, count);
+        page->gap_start += count;
+        page->gap_end += count;
+    }
+}
+
+/* Insert count characters at logical position pos.
+ * Returns the number of characters inserted (0 if the page is full). */
+int page_insert(Page* page, int pos, const char* text, int count) {
+    int i;
+    int line;
+    int newlines = 0;
+    int width = 0;
+    int tabs = 0;
+    int old_rows;
+    PageLine* entry;
+    
+    if (count <= 0 || pos < 0 || pos > page->length) return 0;
+    if (count > page->gap_end - page->gap_start) return 0;
+    
+    /* Measure the new text and make room in the line index first, so a
+     * failed allocation leaves the page untouched */
+    for (i = 0; i < count; i++) {
+        if (text[i] == '\n') newlines++;
+        if (text[i] == '\t') tabs++;
+        width += page_char_width(text[i]);
+    }
+    if (!page_lines_reserve(page, page->line_count + newlines)) return 0;
+    
+    line = page_line_of(page, pos);
+    
+    page_move_gap(page, pos);
+    for (i = 0; i < count; i++) {
+        page->buffer[page->gap_start++] = text[i];
+    }
+    page->length += count;
+    
+    /* Lines after the insertion point start count characters later */
+    for (i = line + 1; i < page->line_count; i++) {
+        page->lines[i].start += count;
+    }
+    
+    entry = &page->lines[line];
+    if (newlines == 0) {
+        /* Common case (typing): the line just gets wider */
+        old_rows = entry->width / VGA_WIDTH;
+        entry->width += width;
+        entry->tabs += tabs;
+        if (entry->width / VGA_WIDTH != old_rows) {
+            page_lines_reflow(page, line + 1);
+        }
+        return count;
+    }
+    
+    /* Split the line: open up one index entry per inserted newline */
+    for (i = page->line_count - 1; i > line; i--) {
+        page->lines[i + newlines] = page->lines[i];
+    }
+    page->line_count += newlines;
+    newlines = 0;
+    for (i = 0; i < count; i++) {
+        if (text[i] == '\n') {
+            newlines++;
+            page->lines[line + newlines].start = pos + i + 1;
+        }
+    }
+    for (i = line; i <= line + newlines; i++) {
+        page_line_measure(page, i);
+    }
+    page_lines_reflow(page, line + 1);
+    return count;
+}
+
+/* Delete count characters starting at logical position pos */
+void page_delete(Page* page, int pos, int count) {
+    int i;
+    int line;
+    int newlines = 0;
+    int width = 0;
+    int tabs = 0;
+    int old_rows;
+    char c;
+    PageLine* entry;
+    
+    if (pos < 0 || count <= 0 || pos >= page->length) return;
+    if (pos + count > page->length) count = page->length - pos;
+    
+    /* Measure the text being removed before it goes */
+    for (i = pos; i < pos + count; i++) {
+        c = page_char_at(page, i);
+        if (c == '\n') newlines++;
+        if (c == '\t') tabs++;
+        width += page_char_width(c);
+    }
+    line = page_line_of(page, pos);
+    
+    if (pos + count == page->gap_start) {
+        /* Backspace case: the deleted text sits right before the gap,
+         * so just grow the gap backwards over it. */
+        page->gap_start = pos;
+    } else {
+        page_move_gap(page, pos);
+        page->gap_end += count;
+    }
+    page->length -= count;
+    
+    /* Each deleted newline merges the following line into this one */
+    if (newlines > 0) {
+        for (i = line + 1; i + newlines < page->line_count; i++) {
+            page->lines[i] = page->lines[i + newlines];
+        }
+        page->line_count -= newlines;
+    }
+    for (i = line + 1; i < page->line_count; i++) {
+        page->lines[i].start -= count;
+    }
+    
+    entry = &page->lines[line];
+    if (newlines == 0) {
+        old_rows = entry->width / VGA_WIDTH;
+        entry->width -= width;
+        entry->tabs -= tabs;
+        if (entry->width / VGA_WIDTH != old_rows) {
+            page_lines_reflow(page, line + 1);
+        }
+    } else {
+        page_line_measure(page, line);
+        page_lines_reflow(page, line + 1);
+    }
+}
+
+/* Remove all text from a page */
+void page_clear(Page* page) {
+    page->gap_start = 0;
+    page->gap_end = PAGE_SIZE;
+    page->length = 0;
+    page->cursor_pos = 0;
+    page->line_count = 1;
+    page->lines[0].start = 0;
+    page->lines[0].width = 0;
+    page->lines[0].row = 0;
+    page->lines[0].tabs = 0;
+}
+
+/* Find the line containing a text position.
+ * Binary search over line starts: O(log lines). A newline belongs to the
+ * line it ends, and position length belongs to the last line. */
+int page_line_of(Page* page, int pos) {
+    int low = 0;
+    int high = page->line_count - 1;
+    int mid;
+    
+    while (low < high) {
+        mid = (low + high + 1) / 2;
+        if (page->lines[mid].start <= pos) {
+            low = mid;
+        } else {
+            high = mid - 1;
+        }
+    }
+    return low;
+}
+
+/* Get the text position where a line starts */
+int page_line_start(Page* page, int line) {
+    return page->lines[line].start;
+}
+
+/* Get the text position of a line's newline (or length for the last line) */
+int page_line_end(Page* page, int line) {
+    if (line + 1 < page->line_count) {
+        return page->lines[line + 1].start - 1;
+    }
+    return page->length;
+}
+
+/* Get the screen cell of a text position, counted from the first text
+ * row, using the same tab expansion and wrapping as refresh_screen.
+ * Lines without tabs need no scan at all; lines with tabs are scanned
+ * from their start, never from the top of the page. */
+int page_screen_offset(Page* page, int pos) {
+    int line = page_line_of(page, pos);
+    PageLine* entry = &page->lines[line];
+    int col;
+    int i;
+    
+    if (entry->tabs == 0) {
+        col = pos - entry->start;
+    } else {
+        col = 0;
+        for (i = entry->start; i < pos; i++) {
+            col += page_char_width(page_char_at(page, i));
+        }
+    }
+    return entry->row * VGA_WIDTH + col;
+}
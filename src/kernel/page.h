@@ -7,10 +7,38 @@
 #define PAGE_SIZE ((VGA_HEIGHT - 1) * VGA_WIDTH)
 #define MAX_PAGES 100
 
-/* Page structure - each page has its own buffer and cursor */
+/* Tabs are displayed as two spaces */
+#define PAGE_TAB_WIDTH 2
+
+/* Initial capacity of a page's line index (doubled as lines are added) */
+#define PAGE_LINES_INITIAL 32
+
+/* Line index entry - one per logical line (text up to and including a
+ * '\n'). The index is updated in place by every page_insert, page_delete
+ * and page_set_char, so finding the line, screen row or column of a
+ * position never rescans the page text. */
+typedef struct {
+    unsigned short start;   /* Text position of the line's first character */
+    unsigned short width;   /* Display columns, tabs expanded, '\n' excluded */
+    unsigned short row;     /* Screen row of the first character (0 = first text row) */
+    unsigned short tabs;    /* Tab count; with no tabs, column == offset in line */
+} PageLine;
+
+/* Page structure - each page has its own buffer and cursor.
+ *
+ * The text is stored in a gap buffer: PAGE_SIZE bytes holding the text
+ * before the gap at [0, gap_start) and the text after the gap at
+ * [gap_end, PAGE_SIZE). Edits happen at the gap, so typing at the cursor
+ * never shifts the rest of the page. Never index buffer directly - use
+ * the page_* accessors below, which work in logical text positions. */
 typedef struct {
-    char* buffer;           /* Dynamically allocated buffer */
+    char* buffer;           /* Dynamically allocated gap buffer */
+    int gap_start;          /* First byte of the gap */
+    int gap_end;            /* One past the last byte of the gap */
     int length;             /* Current length of text in this page */
+    PageLine* lines;        /* Line index, one entry per line */
+    int line_count;         /* Number of lines (always at least 1) */
+    int line_capacity;      /* Allocated entries in lines */
     int cursor_pos;         /* Cursor position in this page */
     int highlight_start;    /* Start of highlighted text in this page */
     int highlight_end;      /* End of highlighted text in this page */
@@ -35,4 +63,18 @@ void navigate_to_page(int new_page);
 void prev_page(void);
 void next_page(void);
 
+/* Gap buffer text access (positions are logical, 0..length) */
+char page_char_at(Page* page, int pos);
+void page_set_char(Page* page, int pos, char c);
+int page_insert(Page* page, int pos, const char* text, int count);
+void page_delete(Page* page, int pos, int count);
+void page_move_gap(Page* page, int pos);
+void page_clear(Page* page);
+
+/* Line index lookups */
+int page_line_of(Page* page, int pos);
+int page_line_start(Page* page, int line);
+int page_line_end(Page* page, int line);
+int page_screen_offset(Page* page, int pos);
+
 #endif /* PAGE_H */
\ No newline at end of file
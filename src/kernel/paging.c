@@ -0,0 +1,213 @@
+/* Paging and Memory Types Implementation */
+
+#include "paging.h"
+#include "serial.h"
+
+/* Page directory entry bits */
+#define PDE_PRESENT     0x001
+#define PDE_WRITABLE    0x002
+#define PDE_PWT         0x008   /* With PCD and PAT clear: PAT entry 1 */
+#define PDE_LARGE       0x080   /* 4MB page (needs CR4.PSE) */
+
+/* Page table entry bits; PWT selects PAT entry 1 the same way */
+#define PTE_PRESENT     0x001
+#define PTE_WRITABLE    0x002
+#define PTE_PWT         0x008
+
+#define PAGE_SIZE       0x1000
+
+#define PAGE_LARGE_SIZE 0x400000
+#define PAGE_LARGE_MASK 0xFFC00000
+
+/* CPUID.1:EDX feature bits */
+#define CPUID_PSE       (1 << 3)
+#define CPUID_MSR       (1 << 5)
+#define CPUID_MTRR      (1 << 12)
+#define CPUID_PAT       (1 << 16)
+
+/* Control register bits */
+#define CR0_PG          0x80000000
+#define CR4_PSE         0x00000010
+
+/* MSRs */
+#define MSR_MTRRCAP             0x0FE
+#define MSR_MTRR_PHYSBASE0      0x200
+#define MSR_MTRR_PHYSMASK0      0x201
+#define MSR_PAT                 0x277
+#define MSR_MTRR_DEF_TYPE       0x2FF
+#define MTRR_VALID              0x800
+#define MTRR_ENABLED            0x800
+
+/* PAT with entry 1 changed from WT (0x04) to WC (0x01):
+ * WB, WC, UC-, UC and the default WB, WT, UC-, UC in entries 4-7 */
+#define PAT_LOW         0x00070106
+#define PAT_HIGH        0x00070406
+
+static unsigned int page_directory[1024] __attribute__((aligned(4096)));
+/* Why: the first 4MB mixes write-back RAM with the uncacheable VGA window
+ * at 0xA0000-0xBFFFF, and a large page spanning more than one MTRR type
+ * has undefined memory type (SDM Vol. 3, 11.11.9). 4KB pages there let
+ * each page take its own MTRR type. */
+static unsigned int page_table_low[1024] __attribute__((aligned(4096)));
+static int paging_enabled = 0;
+static int pat_available = 0;
+static int mtrr_available = 0;
+
+static void cpuid(unsigned int leaf, unsigned int *eax, unsigned int *ebx,
+                  unsigned int *ecx, unsigned int *edx) {
+    __asm__ __volatile__("cpuid"
+                         : "=a"(*eax), "=b"(*ebx), "=c"(*ecx), "=d"(*edx)
+                         : "a"(leaf));
+}
+
+static void read_msr(unsigned int msr, unsigned int *low, unsigned int *high) {
+    __asm__ __volatile__("rdmsr" : "=a"(*low), "=d"(*high) : "c"(msr));
+}
+
+static void write_msr(unsigned int msr, unsigned int low, unsigned int high) {
+    __asm__ __volatile__("wrmsr" : : "c"(msr), "a"(low), "d"(high) : "memory");
+}
+
+/* Write back and invalidate the caches, as the PAT update sequence
+ * requires around the MSR write */
+static void flush_caches(void) {
+    __asm__ __volatile__("wbinvd" : : : "memory");
+}
+
+/* Reload CR3 to drop every cached translation */
+static void flush_tlb(void) {
+    unsigned int cr3;
+    
+    __asm__ __volatile__("movl %%cr3, %0\n\t"
+                         "movl %0, %%cr3"
+                         : "=r"(cr3)
+                         :
+                         : "memory");
+}
+
+/* Identity map 4GB, program the PAT and turn paging on */
+int paging_init(void) {
+    unsigned int eax, ebx, ecx, edx;
+    unsigned int cr0, cr4;
+    int i;
+    
+    cpuid(1, &eax, &ebx, &ecx, &edx);
+    if (!(edx & CPUID_PSE)) {
+        serial_write_string("Paging: no 4MB pages (PSE), staying unpaged\n");
+        return 0;
+    }
+    pat_available = (edx & CPUID_PAT) && (edx & CPUID_MSR);
+    mtrr_available = (edx & CPUID_MTRR) && (edx & CPUID_MSR);
+    
+    for (i = 0; i < 1024; i++) {
+        page_table_low[i] = ((unsigned int)i * PAGE_SIZE) |
+                            PTE_PRESENT | PTE_WRITABLE;
+    }
+    page_directory[0] = (unsigned int)page_table_low | PDE_PRESENT | PDE_WRITABLE;
+    for (i = 1; i < 1024; i++) {
+        page_directory[i] = ((unsigned int)i * PAGE_LARGE_SIZE) |
+                            PDE_PRESENT | PDE_WRITABLE | PDE_LARGE;
+    }
+    
+    if (pat_available) {
+        flush_caches();
+        write_msr(MSR_PAT, PAT_LOW, PAT_HIGH);
+        flush_caches();
+    }
+    
+    __asm__ __volatile__("movl %%cr4, %0" : "=r"(cr4));
+    cr4 |= CR4_PSE;
+    __asm__ __volatile__("movl %0, %%cr4" : : "r"(cr4) : "memory");
+    __asm__ __volatile__("movl %0, %%cr3" : : "r"(page_directory) : "memory");
+    __asm__ __volatile__("movl %%cr0, %0" : "=r"(cr0));
+    cr0 |= CR0_PG;
+    __asm__ __volatile__("movl %0, %%cr0" : : "r"(cr0) : "memory");
+    
+    paging_enabled = 1;
+    serial_write_string("Paging: 4GB identity map, 4KB pages below 4MB");
+    serial_write_string(pat_available ? ", PAT entry 1 write-combining\n" : ", no PAT\n");
+    return 1;
+}
+
+int paging_is_enabled(void) {
+    return paging_enabled;
+}
+
+int paging_has_pat(void) {
+    return paging_enabled && pat_available;
+}
+
+/* Switch whole 4MB pages of a range between PAT entries 0 and 1 */
+unsigned int paging_set_memory_type(unsigned int base, unsigned int size, int type) {
+    unsigned int first, end, last, i, j;
+    
+    if (!paging_has_pat() || size == 0) {
+        return 0;
+    }
+    
+    /* Round inward to whole pages; last is inclusive so a range ending
+     * at 4GB does not wrap */
+    first = (base >> 22) + ((base & ~PAGE_LARGE_MASK) ? 1 : 0);
+    last = base + size - 1;
+    end = (last == 0xFFFFFFFF) ? 1024 : (last + 1) >> 22;
+    
+    if (first >= end) {
+        serial_write_string("Paging: range holds no whole 4MB page, type unchanged\n");
+        return 0;
+    }
+    
+    for (i = first; i < end; i++) {
+        if (i == 0) {
+            /* PWT in PDE 0 would only type the page table itself */
+            for (j = 0; j < 1024; j++) {
+                if (type == PAGING_WRITE_COMBINING) {
+                    page_table_low[j] |= PTE_PWT;
+                } else {
+                    page_table_low[j] &= ~PTE_PWT;
+                }
+            }
+        } else if (type == PAGING_WRITE_COMBINING) {
+            page_directory[i] |= PDE_PWT;
+        } else {
+            page_directory[i] &= ~PDE_PWT;
+        }
+    }
+    
+    flush_tlb();
+    flush_caches();
+    return (end - first) * PAGE_LARGE_SIZE;
+}
+
+/* Log which MTRR type the firmware gave an address */
+void paging_report_mtrr(unsigned int address) {
+    unsigned int cap_low, cap_high, def_low, def_high;
+    unsigned int base_low, base_high, mask_low, mask_high;
+    unsigned int count, i;
+    int type;
+    
+    if (!mtrr_available) {
+        return;
+    }
+    
+    read_msr(MSR_MTRRCAP, &cap_low, &cap_high);
+    read_msr(MSR_MTRR_DEF_TYPE, &def_low, &def_high);
+    type = (def_low & MTRR_ENABLED) ? (int)(def_low & 0xFF) : 0;
+    
+    count = cap_low & 0xFF;
+    for (i = 0; i < count && (def_low & MTRR_ENABLED); i++) {
+        read_msr(MSR_MTRR_PHYSBASE0 + 2 * i, &base_low, &base_high);
+        read_msr(MSR_MTRR_PHYSMASK0 + 2 * i, &mask_low, &mask_high);
+        if ((mask_low & MTRR_VALID) &&
+            (address & mask_low & 0xFFFFF000) == (base_low & mask_low & 0xFFFFF000)) {
+            type = (int)(base_low & 0xFF);
+            break;
+        }
+    }
+    
+    /* 0 UC, 1 WC, 4 WT, 5 WP, 6 WB */
+    serial_write_string("MTRR type at ");
+    serial_write_hex(address);
+    serial_write_string(": ");
+    serial_write_int(type);
+    serial_write_string("\n");
+}
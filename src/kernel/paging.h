@@ -0,0 +1,50 @@
+/* Paging and Memory Types
+ *
+ * DESIGN
+ * ------
+ * The kernel identity-maps the whole 4GB address space with 4MB pages,
+ * so every pointer keeps meaning the same physical address. The first
+ * 4MB uses 4KB pages instead: it holds both write-back RAM and the
+ * uncacheable VGA window, and one large page must not span two MTRR
+ * types. Paging is
+ * there for the memory type, not for protection: with it, a page can
+ * pick one of the eight PAT entries.
+ *
+ * The PAT is the power-on default except entry 1, which becomes
+ * write-combining (WT by default, which nothing used). Pages are mapped
+ * with entry 0 (write-back), and a PAT type of write-back defers to the
+ * MTRRs. RAM therefore stays write-back, and PCI holes stay whatever the
+ * firmware's MTRRs made them. Only ranges passed to paging_set_memory_type()
+ * use entry 1, for the DISPI linear framebuffer. Write-combining lets the
+ * CPU merge framebuffer stores into full bus bursts instead of one
+ * uncached write per store.
+ *
+ * Without PSE the kernel stays unpaged. Without PAT it pages, but every
+ * range stays write-back.
+ */
+
+#ifndef PAGING_H
+#define PAGING_H
+
+#define PAGING_WRITE_BACK       0
+#define PAGING_WRITE_COMBINING  1
+
+/* Build the identity map, program the PAT and turn paging on.
+ * Returns 1 if paging is on. */
+int paging_init(void);
+
+int paging_is_enabled(void);
+
+/* 1 if ranges can be made write-combining */
+int paging_has_pat(void);
+
+/* Map the 4MB pages that lie entirely inside [base, base + size) with a
+ * memory type. Pages only partly inside are left alone, so neighbouring
+ * MMIO never becomes write-combining. Returns the number of bytes
+ * changed. */
+unsigned int paging_set_memory_type(unsigned int base, unsigned int size, int type);
+
+/* Log the MTRR type covering a physical address */
+void paging_report_mtrr(unsigned int address);
+
+#endif /* PAGING_H */
@@ -0,0 +1,218 @@
+/* SIMD Pixel Kernels Implementation */
+
+#include "simd.h"
+#include "memory.h"
+#include "serial.h"
+
+/* Copies and fills shorter than this stay with memcpy/memset: aligning
+ * the destination costs more than the vector loop saves */
+#define SIMD_MIN_BYTES 64
+
+static int sse2_available = 0;
+static int sse2_enabled = 0;
+
+#ifdef AQUINAS_SSE2
+
+/* Set by kernel_entry.asm once SSE is enabled in CR4 */
+extern unsigned int kernel_sse_enabled;
+
+/* Note: no xmm registers in the clobber lists. The compiler can't name
+ * them with SSE turned off, and never holds values in them either. */
+
+/* Copy 64-byte blocks to a 16-byte aligned destination */
+static void sse2_copy_blocks(unsigned char *dst, const unsigned char *src,
+                             unsigned int blocks) {
+    if (!blocks) return;
+    
+    __asm__ __volatile__("1:\n\t"
+                         "movdqu   (%1), %%xmm0\n\t"
+                         "movdqu 16(%1), %%xmm1\n\t"
+                         "movdqu 32(%1), %%xmm2\n\t"
+                         "movdqu 48(%1), %%xmm3\n\t"
+                         "movdqa %%xmm0,   (%0)\n\t"
+                         "movdqa %%xmm1, 16(%0)\n\t"
+                         "movdqa %%xmm2, 32(%0)\n\t"
+                         "movdqa %%xmm3, 48(%0)\n\t"
+                         "addl $64, %0\n\t"
+                         "addl $64, %1\n\t"
+                         "decl %2\n\t"
+                         "jnz 1b"
+                         : "+r"(dst), "+r"(src), "+r"(blocks)
+                         :
+                         : "memory", "cc");
+}
+
+/* Store the 16 bytes at pattern to 64-byte blocks of a 16-byte aligned
+ * destination */
+static void sse2_fill_blocks(unsigned char *dst, const unsigned char *pattern,
+                             unsigned int blocks) {
+    if (!blocks) return;
+    
+    __asm__ __volatile__("movdqu (%2), %%xmm0\n\t"
+                         "1:\n\t"
+                         "movdqa %%xmm0,   (%0)\n\t"
+                         "movdqa %%xmm0, 16(%0)\n\t"
+                         "movdqa %%xmm0, 32(%0)\n\t"
+                         "movdqa %%xmm0, 48(%0)\n\t"
+                         "addl $64, %0\n\t"
+                         "decl %1\n\t"
+                         "jnz 1b"
+                         : "+r"(dst), "+r"(blocks)
+                         : "r"(pattern)
+                         : "memory", "cc");
+}
+
+/* Repeat an 8-byte pattern over n bytes, 64 at a time once the
+ * destination is aligned. The pattern is rotated to the phase the
+ * aligned part starts at. */
+static void sse2_fill_pattern(unsigned char *dst, const unsigned char pattern[8],
+                              unsigned int n) {
+    unsigned char vec[16];
+    unsigned int head = (0 - (unsigned int)dst) & 15;
+    unsigned int i;
+    
+    for (i = 0; i < head; i++) {
+        dst[i] = pattern[i & 7];
+    }
+    for (i = 0; i < 16; i++) {
+        vec[i] = pattern[(head + i) & 7];
+    }
+    
+    sse2_fill_blocks(dst + head, vec, (n - head) >> 6);
+    for (i = head + ((n - head) & ~63U); i < n; i++) {
+        dst[i] = pattern[i & 7];
+    }
+}
+
+#endif /* AQUINAS_SSE2 */
+
+/* Check CPUID and whether the boot code enabled SSE */
+void simd_init(void) {
+#ifdef AQUINAS_SSE2
+    sse2_available = kernel_sse_enabled != 0;
+#endif
+    sse2_enabled = sse2_available;
+    
+    serial_write_string("SIMD: ");
+    serial_write_string(sse2_available ? "SSE2 kernels\n" : "scalar kernels\n");
+}
+
+int simd_sse2_available(void) {
+    return sse2_available;
+}
+
+int simd_set_sse2(int enabled) {
+    int previous = sse2_enabled;
+    
+    sse2_enabled = enabled && sse2_available;
+    return previous;
+}
+
+/* Copy, 64 bytes per iteration with SSE2 */
+void simd_copy(void *dst, const void *src, unsigned int n) {
+#ifdef AQUINAS_SSE2
+    unsigned char *d = (unsigned char *)dst;
+    const unsigned char *s = (const unsigned char *)src;
+    unsigned int head;
+    
+    if (sse2_enabled && n >= SIMD_MIN_BYTES) {
+        head = (0 - (unsigned int)d) & 15;
+        memcpy(d, s, head);
+        d += head;
+        s += head;
+        n -= head;
+        sse2_copy_blocks(d, s, n >> 6);
+        memcpy(d + (n & ~63U), s + (n & ~63U), n & 63);
+        return;
+    }
+#endif
+    memcpy(dst, src, n);
+}
+
+/* Fill, 64 bytes per iteration with SSE2 */
+void simd_fill(void *dst, unsigned char value, unsigned int n) {
+#ifdef AQUINAS_SSE2
+    unsigned char pattern[8];
+    
+    if (sse2_enabled && n >= SIMD_MIN_BYTES) {
+        memset(pattern, value, sizeof(pattern));
+        sse2_fill_pattern((unsigned char *)dst, pattern, n);
+        return;
+    }
+#endif
+    memset(dst, value, n);
+}
+
+/* Fill with a repeating 8-byte pattern */
+void simd_fill_pattern8(unsigned char *dst, const unsigned char pattern[8], unsigned int n) {
+    unsigned int i;
+    
+#ifdef AQUINAS_SSE2
+    if (sse2_enabled && n >= SIMD_MIN_BYTES) {
+        sse2_fill_pattern(dst, pattern, n);
+        return;
+    }
+#endif
+    for (i = 0; i < n; i++) {
+        dst[i] = pattern[i & 7];
+    }
+}
+
+/* Merge a glyph row: one load, a few logic ops and one store with SSE2 */
+void simd_glyph_row16(unsigned char *dst, const unsigned int mask[4],
+                      const unsigned int extent[4], unsigned int fg32,
+                      unsigned int bg32, int transparent) {
+    unsigned int *d = (unsigned int *)dst;
+    unsigned int m;
+    int word;
+    
+#ifdef AQUINAS_SSE2
+    if (sse2_enabled) {
+        if (transparent) {
+            /* dst = (dst & ~mask) | (fg & mask) */
+            __asm__ __volatile__("movd %2, %%xmm2\n\t"
+                                 "pshufd $0, %%xmm2, %%xmm2\n\t"
+                                 "movdqu (%1), %%xmm1\n\t"
+                                 "movdqu (%0), %%xmm0\n\t"
+                                 "pand %%xmm1, %%xmm2\n\t"
+                                 "pandn %%xmm0, %%xmm1\n\t"
+                                 "por %%xmm2, %%xmm1\n\t"
+                                 "movdqu %%xmm1, (%0)"
+                                 :
+                                 : "r"(dst), "r"(mask), "r"(fg32)
+                                 : "memory");
+        } else {
+            /* pixels = (fg & mask) | (bg & ~mask), then
+             * dst = (dst & ~extent) | (pixels & extent) */
+            __asm__ __volatile__("movd %3, %%xmm2\n\t"
+                                 "pshufd $0, %%xmm2, %%xmm2\n\t"
+                                 "movd %4, %%xmm3\n\t"
+                                 "pshufd $0, %%xmm3, %%xmm3\n\t"
+                                 "movdqu (%1), %%xmm1\n\t"
+                                 "pand %%xmm1, %%xmm2\n\t"
+                                 "pandn %%xmm3, %%xmm1\n\t"
+                                 "por %%xmm2, %%xmm1\n\t"
+                                 "movdqu (%2), %%xmm3\n\t"
+                                 "movdqu (%0), %%xmm0\n\t"
+                                 "pand %%xmm3, %%xmm1\n\t"
+                                 "pandn %%xmm0, %%xmm3\n\t"
+                                 "por %%xmm3, %%xmm1\n\t"
+                                 "movdqu %%xmm1, (%0)"
+                                 :
+                                 : "r"(dst), "r"(mask), "r"(extent), "r"(fg32), "r"(bg32)
+                                 : "memory");
+        }
+        return;
+    }
+#endif
+    for (word = 0; word < 4; word++) {
+        if (transparent) {
+            if (mask[word]) {
+                d[word] = (d[word] & ~mask[word]) | (fg32 & mask[word]);
+            }
+        } else {
+            m = (fg32 & mask[word]) | (bg32 & ~mask[word]);
+            d[word] = (d[word] & ~extent[word]) | (m & extent[word]);
+        }
+    }
+}
@@ -0,0 +1,47 @@
+/* SIMD Pixel Kernels
+ *
+ * DESIGN
+ * ------
+ * The big pixel loops (flips, clears, rectangle and pattern fills, glyph
+ * rows) go through these calls. In the default build they are memcpy,
+ * memset and scalar loops. The opt-in SSE2 build (make SSE2=1, which
+ * defines AQUINAS_SSE2) adds 16-byte SSE2 versions:
+ *   - kernel_entry.asm turns on CR4.OSFXSR/OSXMMEXCPT when CPUID reports
+ *     FXSR and SSE2, and sets kernel_sse_enabled
+ *   - the interrupt stubs FXSAVE/FXRSTOR the interrupted code's vector
+ *     state while kernel_sse_enabled is set
+ *   - simd_init() picks the SSE2 kernels only when that happened
+ * The rest of the kernel is still compiled without SSE, so the compiler
+ * never keeps values in vector registers; only these kernels touch them.
+ */
+
+#ifndef SIMD_H
+#define SIMD_H
+
+/* Choose the kernels for this CPU and log the choice */
+void simd_init(void);
+
+/* 1 if this build has the SSE2 kernels and the CPU can run them */
+int simd_sse2_available(void);
+
+/* Use the SSE2 kernels (when available) or the scalar ones; for
+ * benchmarks. Returns the previous setting. */
+int simd_set_sse2(int enabled);
+
+/* Copy n bytes (the regions must not overlap) */
+void simd_copy(void *dst, const void *src, unsigned int n);
+
+/* Set n bytes to value */
+void simd_fill(void *dst, unsigned char value, unsigned int n);
+
+/* Fill n bytes with an 8-byte repeating pattern: dst[i] = pattern[i & 7] */
+void simd_fill_pattern8(unsigned char *dst, const unsigned char pattern[8], unsigned int n);
+
+/* Merge one 16-byte glyph row into dst. mask holds 0xFF for foreground
+ * bytes; fg32 and bg32 are the colors in every byte. Transparent: only foreground bytes change. Otherwise bytes
+ * inside extent become fg or bg and the rest are kept. */
+void simd_glyph_row16(unsigned char *dst, const unsigned int mask[4],
+                      const unsigned int extent[4], unsigned int fg32,
+                      unsigned int bg32, int transparent);
+
+#endif /* SIMD_H */
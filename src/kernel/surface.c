@@ -0,0 +1,143 @@
+/* Offscreen Surface Implementation */
+
+#include "surface.h"
+#include "dispi.h"
+#include "memory.h"
+#include "serial.h"
+
+/* Allocate a surface; the pixels follow the header in one block */
+Surface* surface_create(int width, int height) {
+    Surface *surface;
+    
+    if (width <= 0 || height <= 0) return NULL;
+    
+    surface = (Surface*)malloc(sizeof(Surface) + (size_t)width * height);
+    if (!surface) {
+        serial_write_string("ERROR: Failed to allocate surface\n");
+        return NULL;
+    }
+    
+    surface_init(surface, (unsigned char*)(surface + 1), width, height, width);
+    return surface;
+}
+
+/* Free a surface made by surface_create */
+void surface_destroy(Surface *surface) {
+    if (surface) {
+        free(surface);
+    }
+}
+
+/* Wrap existing pixels */
+void surface_init(Surface *surface, unsigned char *pixels, int width, int height, int stride) {
+    if (!surface) return;
+    
+    surface->pixels = pixels;
+    surface->width = width;
+    surface->height = height;
+    surface->stride = stride;
+}
+
+/* Wrap the DISPI page being drawn */
+int surface_get_screen(Surface *screen) {
+    unsigned char *pixels = dispi_get_backbuffer();
+    
+    if (!screen || !pixels || dispi_get_framebuffer_size() == 0) return 0;
+    
+    surface_init(screen, pixels, DISPI_WIDTH, DISPI_HEIGHT, DISPI_WIDTH);
+    return 1;
+}
+
+/* Fill the whole surface */
+void surface_fill(Surface *surface, unsigned char color) {
+    unsigned char *row;
+    int y;
+    
+    if (!surface || !surface->pixels) return;
+    
+    if (surface->stride == surface->width) {
+        memset(surface->pixels, color, (size_t)surface->width * surface->height);
+        return;
+    }
+    
+    row = surface->pixels;
+    for (y = 0; y < surface->height; y++) {
+        memset(row, color, surface->width);
+        row += surface->stride;
+    }
+}
+
+/* Clip a copy to both surfaces, moving the two origins together.
+ * Returns 0 if nothing is left. */
+static int surface_clip_copy(const Surface *dst, int *dst_x, int *dst_y,
+                             const Surface *src, int *src_x, int *src_y, int *w, int *h) {
+    int shift;
+    
+    /* Left and top edges of either surface */
+    shift = 0;
+    if (*src_x < 0) shift = -*src_x;
+    if (*dst_x + shift < 0) shift = -*dst_x;
+    *src_x += shift;
+    *dst_x += shift;
+    *w -= shift;
+    
+    shift = 0;
+    if (*src_y < 0) shift = -*src_y;
+    if (*dst_y + shift < 0) shift = -*dst_y;
+    *src_y += shift;
+    *dst_y += shift;
+    *h -= shift;
+    
+    /* Right and bottom edges */
+    if (*src_x + *w > src->width) *w = src->width - *src_x;
+    if (*dst_x + *w > dst->width) *w = dst->width - *dst_x;
+    if (*src_y + *h > src->height) *h = src->height - *src_y;
+    if (*dst_y + *h > dst->height) *h = dst->height - *dst_y;
+    
+    return *w > 0 && *h > 0;
+}
+
+/* Copy a block between surfaces, a row at a time.
+ * Why walk bottom-up sometimes: when the destination is below the
+ * source in the same buffer (scrolling down), copying the top row first
+ * would overwrite source rows before they are read. memmove covers the
+ * same problem within a row. */
+void surface_copy_rect(Surface *dst, int dst_x, int dst_y,
+                       const Surface *src, int src_x, int src_y, int w, int h) {
+    unsigned char *d;
+    const unsigned char *s;
+    int row;
+    
+    if (!dst || !src || !dst->pixels || !src->pixels) return;
+    if (!surface_clip_copy(dst, &dst_x, &dst_y, src, &src_x, &src_y, &w, &h)) return;
+    
+    d = dst->pixels + dst_y * dst->stride + dst_x;
+    s = src->pixels + src_y * src->stride + src_x;
+    
+    if (d > s) {
+        d += (h - 1) * dst->stride;
+        s += (h - 1) * src->stride;
+        for (row = 0; row < h; row++) {
+            memmove(d, s, w);
+            d -= dst->stride;
+            s -= src->stride;
+        }
+    } else {
+        for (row = 0; row < h; row++) {
+            memmove(d, s, w);
+            d += dst->stride;
+            s += src->stride;
+        }
+    }
+}
+
+/* Copy a block of a surface onto the screen */
+void surface_blit(const Surface *src, int src_x, int src_y, int w, int h, int x, int y) {
+    Surface screen;
+    
+    if (!src || !surface_get_screen(&screen)) return;
+    if (!surface_clip_copy(&screen, &x, &y, src, &src_x, &src_y, &w, &h)) return;
+    
+    surface_copy_rect(&screen, x, y, src, src_x, src_y, w, h);
+    dispi_mark_dirty(x, y, w, h);
+}
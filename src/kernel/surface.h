@@ -0,0 +1,52 @@
+/* Offscreen Surfaces
+ *
+ * DESIGN
+ * ------
+ * A Surface is an 8bpp pixel buffer with its own size and row stride.
+ * The DISPI page being drawn is one too (surface_get_screen), so the
+ * same row-at-a-time code moves pixels between an offscreen buffer and
+ * the screen in either direction.
+ *
+ * A GraphicsContext set up with gc_init_surface() draws into a surface
+ * with the same calls it uses for the screen. This is what view caches,
+ * thumbnails and tiled rendering build on: draw once offscreen, then
+ * surface_blit() the result wherever it is needed.
+ */
+
+#ifndef SURFACE_H
+#define SURFACE_H
+
+typedef struct Surface {
+    unsigned char *pixels;      /* First pixel of the top row */
+    int width, height;
+    int stride;                 /* Bytes from one row to the next */
+} Surface;
+
+/* Allocate a width x height surface (contents undefined).
+ * Returns NULL if out of memory. */
+Surface* surface_create(int width, int height);
+
+/* Free a surface and its pixels (only for surface_create surfaces) */
+void surface_destroy(Surface *surface);
+
+/* Describe pixels owned by someone else as a surface */
+void surface_init(Surface *surface, unsigned char *pixels, int width, int height, int stride);
+
+/* Describe the DISPI page being drawn (the backbuffer when double
+ * buffered). It moves with every flip, so fetch it again each frame.
+ * Returns 0 if DISPI has not been initialized. */
+int surface_get_screen(Surface *screen);
+
+/* Set every pixel to color */
+void surface_fill(Surface *surface, unsigned char color);
+
+/* Copy a w x h block from (src_x, src_y) in src to (dst_x, dst_y) in
+ * dst, clipped to both. dst and src may be the same surface and the
+ * blocks may overlap (scrolling). */
+void surface_copy_rect(Surface *dst, int dst_x, int dst_y,
+                       const Surface *src, int src_x, int src_y, int w, int h);
+
+/* Copy a block of a surface to (x, y) on the screen and mark it dirty */
+void surface_blit(const Surface *src, int src_x, int src_y, int w, int h, int x, int y);
+
+#endif /* SURFACE_H */
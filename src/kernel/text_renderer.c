@@ -201,30 +201,15 @@ void text_renderer_set_colors(unsigned char fg, unsigned char bg) {
     text_renderer.bg_color = bg;
 }
 
-/* Scroll the screen up one line */
+/* Scroll the screen up one line: move everything below the first text
+ * row up in one block copy and clear the row left at the bottom */
 void text_renderer_scroll(void) {
-    int row, col;
-    unsigned char *scanline = (unsigned char *)0x20000; /* Temporary buffer */
     DisplayDriver *driver = display_get_driver();
-    int y;
     
-    /* Copy each row up by one */
-    for (row = 0; row < TEXT_ROWS - 1; row++) {
-        int src_y = (row + 1) * FONT_hp100lx_HEIGHT;
-        int dst_y = row * FONT_hp100lx_HEIGHT;
+    if (!driver) return;
         
-        /* Copy scanlines for this text row */
-        for (y = 0; y < FONT_hp100lx_HEIGHT; y++) {
-            /* Read source scanline */
-            for (col = 0; col < driver->width; col++) {
-                scanline[col] = driver->get_pixel(col, src_y + y);
-            }
-            /* Write to destination */
-            for (col = 0; col < driver->width; col++) {
-                driver->set_pixel(col, dst_y + y, scanline[col]);
-            }
-        }
-    }
+    display_copy_rect(0, 0, 0, FONT_hp100lx_HEIGHT,
+                      driver->width, (TEXT_ROWS - 1) * FONT_hp100lx_HEIGHT);
     
     /* Clear the bottom row */
     display_fill_rect(0, (TEXT_ROWS - 1) * FONT_hp100lx_HEIGHT, 
@@ -22,6 +22,7 @@
 #define PIT_CHANNEL0_SELECT 0x00  /* Select channel 0 */
 #define PIT_ACCESS_LOHI    0x30   /* Access mode: lobyte/hibyte */
 #define PIT_MODE_RATE_GEN  0x04   /* Mode 2: rate generator */
+#define PIT_LATCH          0x00   /* Access mode: latch count */
 
 /* PIT frequency constants */
 #define PIT_FREQUENCY 1193182  /* Base frequency of PIT in Hz */
@@ -50,6 +51,8 @@ static volatile unsigned int system_ticks = 0;
 
 /* Assembly functions for interrupt handling */
 extern void timer_interrupt_stub(void);
+extern void keyboard_interrupt_stub(void);
+extern void mouse_interrupt_stub(void);
 extern void default_interrupt_stub(void);
 extern void load_idt(unsigned int);
 
@@ -117,6 +120,11 @@ static void init_idt(void) {
     /* Timer interrupt handler at IRQ0 (interrupt 32) */
     idt_set_gate(32, (unsigned int)timer_interrupt_stub, 0x08, 0x8E);
     
+    /* Keyboard at IRQ1 and the COM1 mouse at IRQ4 queue raw bytes for
+     * the main loop (input_irq.c) */
+    idt_set_gate(33, (unsigned int)keyboard_interrupt_stub, 0x08, 0x8E);
+    idt_set_gate(36, (unsigned int)mouse_interrupt_stub, 0x08, 0x8E);
+    
     /* Set up IDT pointer */
     idtp.limit = (sizeof(struct idt_entry) * 256) - 1;
     idtp.base = (unsigned int)idt;  /* No & needed now, idt is already a pointer */
@@ -143,7 +151,8 @@ static void init_pic(void) {
     outb(0x21, 0x01);  /* 8086 mode */
     outb(0xA1, 0x01);
     
-    /* Mask all interrupts except timer (IRQ0) and keyboard (IRQ1) */
+    /* Mask all interrupts except timer (IRQ0) and keyboard (IRQ1).
+     * The mouse (IRQ4) is unmasked by input_irq_init once COM1 is set up. */
     outb(0x21, 0xFC);  /* Master PIC: unmask IRQ0 and IRQ1 (0xFC = 11111100) */
     outb(0xA1, 0xFF);  /* Slave PIC: mask all */
 }
@@ -193,4 +202,44 @@ unsigned int get_ticks(void) {
 /* Get elapsed milliseconds since a previous tick count */
 unsigned int get_elapsed_ms(unsigned int start_ticks) {
     return system_ticks - start_ticks;
-}
\ No newline at end of file
+}
+
+/* Get the low 32 bits of the CPU timestamp counter.
+ * Why only 32 bits: C89 has no 64-bit integer type, and benchmarks only
+ * time spans of a few milliseconds, far below the ~1s wraparound at
+ * typical clock rates. Unsigned subtraction handles a single wrap. */
+unsigned int get_cycles(void) {
+    unsigned int low, high;
+    __asm__ __volatile__("rdtsc" : "=a"(low), "=d"(high));
+    (void)high;
+    return low;
+}
+
+/* Get microseconds since boot from the tick count plus how far the PIT
+ * has counted down into the current millisecond.
+ * Why check the PIC: with interrupts off, a tick that has just expired
+ * is still pending in the IRR and not yet in system_ticks. A count
+ * near the top of its range then belongs to the next millisecond. */
+unsigned int get_time_us(void) {
+    unsigned int flags, ticks, count;
+    unsigned int divisor = PIT_FREQUENCY / TIMER_HZ;
+    
+    __asm__ __volatile__("pushfl; popl %0; cli" : "=r"(flags) : : "memory");
+    
+    outb(PIT_COMMAND, PIT_CHANNEL0_SELECT | PIT_LATCH);
+    count = inb(PIT_CHANNEL0);
+    count |= (unsigned int)inb(PIT_CHANNEL0) << 8;
+    ticks = system_ticks;
+    
+    outb(0x20, 0x0A);  /* OCW3: next read of 0x20 returns the IRR */
+    if ((inb(0x20) & 0x01) && count > divisor / 2) {
+        ticks++;
+    }
+    
+    if (flags & 0x200) {
+        __asm__ __volatile__("sti");
+    }
+    
+    if (count > divisor) count = divisor;
+    return ticks * 1000 + (divisor - count) * 1000 / divisor;
+}
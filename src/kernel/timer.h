@@ -17,4 +17,11 @@ unsigned int get_ticks(void);
 /* Get elapsed milliseconds since a previous tick count */
 unsigned int get_elapsed_ms(unsigned int start_ticks);
 
+/* Get the low 32 bits of the CPU timestamp counter (for benchmarks) */
+unsigned int get_cycles(void);
+
+/* Get microseconds since boot (wraps after about 71 minutes; subtract
+ * two readings to time a span) */
+unsigned int get_time_us(void);
+
 #endif
\ No newline at end of file
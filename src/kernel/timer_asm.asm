@@ -5,14 +5,51 @@
 section .text
 
 global timer_interrupt_stub
+global keyboard_interrupt_stub
+global mouse_interrupt_stub
 global default_interrupt_stub
 extern timer_handler
+extern keyboard_irq_handler
+extern mouse_irq_handler
 extern default_handler
+extern kernel_sse_enabled
+
+; In the SSE2 build (make SSE2=1), the code an interrupt lands in may be
+; in the middle of an SSE kernel, so the stubs keep its x87/SSE state
+; with FXSAVE. That needs a 512-byte area aligned to 16 bytes; EBX (saved
+; by pushad, preserved by the C handler) remembers the unaligned ESP.
+; Use after the kernel data segment is loaded.
+%macro SAVE_VECTOR_STATE 0
+%ifdef AQUINAS_SSE2
+    mov ebx, esp
+    cmp dword [kernel_sse_enabled], 0
+    je %%done
+    sub esp, 512
+    and esp, 0xFFFFFFF0
+    fxsave [esp]
+%%done:
+%endif
+%endmacro
+
+%macro RESTORE_VECTOR_STATE 0
+%ifdef AQUINAS_SSE2
+    cmp dword [kernel_sse_enabled], 0
+    je %%done
+    fxrstor [esp]
+%%done:
+    mov esp, ebx
+%endif
+%endmacro
 
 timer_interrupt_stub:
     ; Save all registers
     pushad
     
+    ; The C handler may assume DF=0 (the ABI says so), but the code we
+    ; interrupted may be a backward memmove running with DF set. iret
+    ; restores the caller's EFLAGS.
+    cld
+    
     ; Save segment registers
     push ds
     push es
@@ -26,9 +63,13 @@ timer_interrupt_stub:
     mov fs, ax
     mov gs, ax
     
+    SAVE_VECTOR_STATE
+    
     ; Call C handler
     call timer_handler
     
+    RESTORE_VECTOR_STATE
+    
     ; Restore segment registers
     pop gs
     pop fs
@@ -41,11 +82,47 @@ timer_interrupt_stub:
     ; Return from interrupt
     iret
 
+; Device IRQ stubs: the same frame as the timer stub around a C handler
+; that takes no arguments and sends its own EOI
+%macro IRQ_STUB 2
+%1:
+    pushad
+    cld                 ; C code expects DF=0 (see timer_interrupt_stub)
+    push ds
+    push es
+    push fs
+    push gs
+    
+    mov ax, 0x10
+    mov ds, ax
+    mov es, ax
+    mov fs, ax
+    mov gs, ax
+    
+    SAVE_VECTOR_STATE
+    call %2
+    RESTORE_VECTOR_STATE
+    
+    pop gs
+    pop fs
+    pop es
+    pop ds
+    popad
+    iret
+%endmacro
+
+; Keyboard (IRQ1, interrupt 33)
+IRQ_STUB keyboard_interrupt_stub, keyboard_irq_handler
+
+; Serial mouse on COM1 (IRQ4, interrupt 36)
+IRQ_STUB mouse_interrupt_stub, mouse_irq_handler
+
 ; We need individual stubs for each interrupt to know which one fired
 ; For now, use a simple version that doesn't track interrupt number
 default_interrupt_stub:
     ; Save all registers
     pushad
+    cld                 ; C code expects DF=0 (see timer_interrupt_stub)
     
     ; Save segment registers
     push ds
@@ -60,11 +137,15 @@ default_interrupt_stub:
     mov fs, ax
     mov gs, ax
     
+    SAVE_VECTOR_STATE
+    
     ; Pass interrupt number (0xFF = unknown for now)
     push dword 0xFF
     call default_handler
     add esp, 4
     
+    RESTORE_VECTOR_STATE
+    
     ; Restore segment registers
     pop gs
     pop fs
@@ -173,11 +173,8 @@ void button_draw(View *self, GraphicsContext *gc) {
     text_y = y + (h - char_height) / 2;
     
     /* Draw label */
-    if (button->font == FONT_9X16) {
-        dispi_draw_string_bios(text_x, text_y, button->label, fg_color, bg_color);
-    } else {
-        dispi_draw_string(text_x, text_y, button->label, fg_color, bg_color);
-    }
+    gc_draw_text(gc, text_x, text_y, button->label, label_len, button->font,
+                 fg_color, bg_color);
 }
 
 /* Check if pixel coordinates are within button's actual bounds */
@@ -425,6 +422,8 @@ Button* button_create(int x, int y, const char *label, FontSize font) {
     button->base.destroy = NULL;
     button->base.type_name = "Button";
     button->base.interface = &button_interface;  /* Set ViewInterface */
+    button->base.cache = NULL;
+    button->base.arena = NULL;
     
     /* Initialize the view through its interface */
     if (button->base.interface) {
@@ -449,7 +448,7 @@ Button* button_create(int x, int y, const char *label, FontSize font) {
 void button_destroy(Button *button) {
     if (button) {
         /* Note: We don't free the label as it's assumed to be static or managed elsewhere */
-        free(button);
+        view_destroy((View*)button);
     }
 }
 
@@ -20,6 +20,7 @@
 #include "dispi_cursor.h"
 #include "serial.h"
 #include "timer.h"
+#include "frame_pacer.h"
 #include "input.h"
 #include "mouse.h"
 #include "memory.h"
@@ -87,25 +88,25 @@ static int ui_demo_global_key_handler(View *view, InputEvent *event, void *conte
 static void ui_demo_mouse_handler(InputEvent *event) {
     if (!event || !g_ui_demo_layout) return;
     
-    /* Update cursor position on any mouse event */
+    /* Update cursor position on any mouse event. The cursor is an
+     * overlay, so moving it needs no redraw. */
     if (event->type == EVENT_MOUSE_MOVE || 
         event->type == EVENT_MOUSE_DOWN || 
         event->type == EVENT_MOUSE_UP) {
         dispi_cursor_move(event->data.mouse.x, event->data.mouse.y);
-        g_ui_demo_needs_redraw = 1;
     }
     
-    /* Pass event to layout for handling */
-    if (layout_handle_event(g_ui_demo_layout, event)) {
-        g_ui_demo_needs_redraw = 1;
-    }
+    /* Pass event to layout for handling. Why not redraw when it is
+     * handled: buttons handle every move over them, but only a change
+     * (hover, press, focus) invalidates a view or the layout, and the
+     * main loop already redraws on those flags. */
+    layout_handle_event(g_ui_demo_layout, event);
 }
 
-/* Main UI demo function */
-void test_ui_demo(void) {
+/* Build the demo's layout and component tree.
+ * Everything hangs off the layout, so layout_destroy() frees it all. */
+static Layout* ui_demo_build(int *running) {
     Layout *layout;
-    GraphicsContext *gc;
-    DisplayDriver *driver;
     Panel *main_panel, *button_panel, *label_panel, *input_panel, *textarea_panel;
     Button *btn_normal, *btn_primary, *btn_danger, *btn_disabled;
     Button *btn_6x8, *btn_9x16, *btn_exit;
@@ -113,41 +114,14 @@ void test_ui_demo(void) {
     Label *lbl_colors, *lbl_name, *lbl_email, *lbl_textarea;
     TextInput *txt_name, *txt_email;
     TextArea *textarea;
-    int running = 1;
-    int key;
-    unsigned int last_update = 0;
-    
-    serial_write_string("Starting UI Component Library Demo\n");
-    
-    /* Initialize DISPI graphics mode using common init */
-    driver = dispi_graphics_init();
-    if (!driver) {
-        serial_write_string("ERROR: Failed to initialize DISPI graphics\n");
-        return;
-    }
-    
-    /* Set mouse callback for UI demo */
-    mouse_set_callback(ui_demo_mouse_handler);
-    
-    /* Create graphics context */
-    gc = gc_create(driver);
-    if (!gc) {
-        serial_write_string("ERROR: Failed to create graphics context\n");
-        return;
-    }
     
     /* Create layout */
     layout = layout_create();
     if (!layout) {
         serial_write_string("ERROR: Failed to create layout\n");
-        gc_destroy(gc);
-        return;
+        return NULL;
     }
     
-    /* Store layout for mouse handler */
-    g_ui_demo_layout = layout;
-    g_ui_demo_needs_redraw = 0;
-    
     /* Demonstrate event bus by subscribing a global keyboard handler */
     if (layout->event_bus) {
         serial_write_string("Subscribing global F1/F2 handler to event bus (SYSTEM priority)\n");
@@ -241,7 +215,7 @@ void test_ui_demo(void) {
     /* Create exit button */
     btn_exit = button_create(5, 5, "Exit Demo", FONT_9X16);
     button_set_style(btn_exit, BUTTON_STYLE_DANGER);
-    button_set_callback(btn_exit, on_button_exit, &running);
+    button_set_callback(btn_exit, on_button_exit, running);
     
     /* Add all components to layout */
     layout_set_region_content(layout, 0, 0, 7, 6, (View*)main_panel);
@@ -268,7 +242,80 @@ void test_ui_demo(void) {
     view_add_child((View*)main_panel, (View*)lbl_colors);
     view_add_child((View*)main_panel, (View*)btn_exit);
     
+    /* Labels and buttons keep their rendering between frames; the panels
+     * are mostly flat fills, cheaper to redraw than to hold in memory.
+     * Text inputs and the text area blink, so they are drawn each time. */
+    view_set_cached((View*)lbl_title, 1);
+    view_set_cached((View*)lbl_left, 1);
+    view_set_cached((View*)lbl_center, 1);
+    view_set_cached((View*)lbl_right, 1);
+    view_set_cached((View*)lbl_name, 1);
+    view_set_cached((View*)lbl_email, 1);
+    view_set_cached((View*)lbl_textarea, 1);
+    view_set_cached((View*)lbl_colors, 1);
+    view_set_cached((View*)btn_normal, 1);
+    view_set_cached((View*)btn_primary, 1);
+    view_set_cached((View*)btn_danger, 1);
+    view_set_cached((View*)btn_disabled, 1);
+    view_set_cached((View*)btn_6x8, 1);
+    view_set_cached((View*)btn_9x16, 1);
+    view_set_cached((View*)btn_exit, 1);
+    
+    return layout;
+}
+
+/* Build and destroy the demo's component tree without entering graphics
+ * mode, for allocator stress tests */
+void ui_demo_alloc_cycle(void) {
+    int running = 1;
+    Layout *layout = ui_demo_build(&running);
+    
+    if (layout) {
+        layout_destroy(layout);
+    }
+}
+
+/* Main UI demo function */
+void test_ui_demo(void) {
+    Layout *layout;
+    GraphicsContext *gc;
+    DisplayDriver *driver;
+    int running = 1;
+    int key;
+    unsigned int last_update = 0;
+    
+    serial_write_string("Starting UI Component Library Demo\n");
+    
+    /* Initialize DISPI graphics mode using common init */
+    driver = dispi_graphics_init();
+    if (!driver) {
+        serial_write_string("ERROR: Failed to initialize DISPI graphics\n");
+        return;
+    }
+    
+    /* Set mouse callback for UI demo */
+    mouse_set_callback(ui_demo_mouse_handler);
+    
+    /* Create graphics context */
+    gc = gc_create(driver);
+    if (!gc) {
+        serial_write_string("ERROR: Failed to create graphics context\n");
+        return;
+    }
+    
+    /* Create layout and components */
+    layout = ui_demo_build(&running);
+    if (!layout) {
+        gc_destroy(gc);
+        return;
+    }
+    
+    /* Store layout for mouse handler */
+    g_ui_demo_layout = layout;
+    g_ui_demo_needs_redraw = 0;
+    
     /* Initial draw */
+    frame_pacer_reset();
     layout_draw(layout, gc);
     if (dispi_is_double_buffered()) {
         dispi_flip_buffers();
@@ -325,20 +372,11 @@ void test_ui_demo(void) {
         if (g_ui_demo_needs_redraw || (layout && layout->needs_redraw) || 
             (layout->root_view && layout->root_view->needs_redraw)) {
             /* Draw to backbuffer */
+            frame_begin();
             layout_draw(layout, gc);
             
-            /* Flip buffers to show new content */
-            dispi_flip_buffers();
-            
-            /* Redraw cursor on new front buffer 
-             * The cursor needs to be redrawn after every flip because
-             * it draws directly to the framebuffer */
-            if (dispi_cursor_is_visible()) {
-                int mx, my;
-                dispi_cursor_get_pos(&mx, &my);
-                dispi_cursor_hide();
-                dispi_cursor_show();
-            }
+            /* Flip buffers to show new content, at the next retrace */
+            frame_present();
             
             g_ui_demo_needs_redraw = 0;
         }
@@ -347,28 +385,11 @@ void test_ui_demo(void) {
     /* Cleanup */
     serial_write_string("Cleaning up UI demo\n");
     
-    /* Destroy components */
-    button_destroy(btn_exit);
-    label_destroy(lbl_colors);
-    textinput_destroy(txt_email);
-    textinput_destroy(txt_name);
-    label_destroy(lbl_email);
-    label_destroy(lbl_name);
-    label_destroy(lbl_right);
-    label_destroy(lbl_center);
-    label_destroy(lbl_left);
-    button_destroy(btn_9x16);
-    button_destroy(btn_6x8);
-    button_destroy(btn_disabled);
-    button_destroy(btn_danger);
-    button_destroy(btn_primary);
-    button_destroy(btn_normal);
-    label_destroy(lbl_title);
-    panel_destroy(input_panel);
-    panel_destroy(label_panel);
-    panel_destroy(button_panel);
-    panel_destroy(main_panel);
-    
+    /* Destroy the layout and every component attached to it */
+    g_ui_demo_layout = NULL;
+    layout_report_draw_stats(layout);
+    view_report_cache_stats();
+    frame_pacer_report();
     layout_destroy(layout);
     
     /* Cleanup DISPI graphics mode using common cleanup */
@@ -5,4 +5,8 @@
 
 void test_ui_demo(void);
 
+/* Build and destroy the demo's component tree without entering graphics
+ * mode, for allocator stress tests */
+void ui_demo_alloc_cycle(void);
+
 #endif /* UI_DEMO_H */
\ No newline at end of file
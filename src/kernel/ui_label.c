@@ -87,39 +87,12 @@ void label_draw(View *self, GraphicsContext *gc) {
             break;
     }
     
-    /* Ensure text stays within bounds */
+    /* Keep the start inside the label; text running past the right edge
+     * is clipped by the graphics context */
     if (text_x < x) text_x = x;
-    if (text_x + text_len * char_width > x + w) {
-        /* Text too long, truncate display */
-        int max_chars = (x + w - text_x) / char_width;
-        if (max_chars > 0) {
-            /* Draw as much as fits */
-            char temp[256];
-            int i;
-            for (i = 0; i < max_chars && i < 255 && label->text[i]; i++) {
-                temp[i] = label->text[i];
-            }
-            temp[i] = '\0';
             
-            /* Draw text with appropriate font */
-            if (label->font == FONT_9X16) {
-                dispi_draw_string_bios(text_x, text_y, temp, label->fg_color, 
-                                      label->bg_color != COLOR_TRANSPARENT ? label->bg_color : THEME_BG);
-            } else {
-                dispi_draw_string(text_x, text_y, temp, label->fg_color,
-                                 label->bg_color != COLOR_TRANSPARENT ? label->bg_color : THEME_BG);
-            }
-        }
-    } else {
-        /* Draw full text */
-        if (label->font == FONT_9X16) {
-            dispi_draw_string_bios(text_x, text_y, label->text, label->fg_color,
-                                  label->bg_color != COLOR_TRANSPARENT ? label->bg_color : THEME_BG);
-        } else {
-            dispi_draw_string(text_x, text_y, label->text, label->fg_color,
-                             label->bg_color != COLOR_TRANSPARENT ? label->bg_color : THEME_BG);
-        }
-    }
+    gc_draw_text(gc, text_x, text_y, label->text, text_len, label->font, label->fg_color,
+                 label->bg_color != COLOR_TRANSPARENT ? label->bg_color : THEME_BG);
 }
 
 /* ViewInterface callback implementations */
@@ -188,6 +161,8 @@ Label* label_create(int x, int y, int width, const char *text, FontSize font) {
     label->base.destroy = NULL;
     label->base.type_name = "Label";
     label->base.interface = &label_interface;  /* Set ViewInterface */
+    label->base.cache = NULL;
+    label->base.arena = NULL;
     
     /* Initialize the view through its interface */
     if (label->base.interface) {
@@ -209,7 +184,7 @@ Label* label_create(int x, int y, int width, const char *text, FontSize font) {
 /* Destroy a label */
 void label_destroy(Label *label) {
     if (label) {
-        free(label);
+        view_destroy((View*)label);
     }
 }
 
@@ -117,11 +117,8 @@ void panel_draw(View *self, GraphicsContext *gc) {
         title_x = x + (w - title_len * char_width) / 2;
         title_y = y + 2;
         
-        if (panel->title_font == FONT_9X16) {
-            dispi_draw_string_bios(title_x, title_y, panel->title, COLOR_BLACK, COLOR_MED_GRAY);
-        } else {
-            dispi_draw_string(title_x, title_y, panel->title, COLOR_BLACK, COLOR_MED_GRAY);
-        }
+        gc_draw_text(gc, title_x, title_y, panel->title, title_len, panel->title_font,
+                     COLOR_BLACK, COLOR_MED_GRAY);
         
         /* Draw separator line under title */
         gc_draw_line(gc, x + 2, y + title_bg_height + 2, x + w - 3, y + title_bg_height + 2, COLOR_MED_DARK_GRAY);
@@ -200,6 +197,8 @@ Panel* panel_create(int x, int y, int width, int height) {
     panel->base.destroy = NULL;
     panel->base.type_name = "Panel";
     panel->base.interface = &panel_interface;  /* Set ViewInterface */
+    panel->base.cache = NULL;
+    panel->base.arena = NULL;
     
     /* Initialize the view through its interface */
     if (panel->base.interface) {
@@ -221,16 +220,8 @@ Panel* panel_create(int x, int y, int width, int height) {
 /* Destroy a panel */
 void panel_destroy(Panel *panel) {
     if (panel) {
-        /* Destroy all children first */
-        View *child = panel->base.children;
-        while (child) {
-            View *next = child->next_sibling;
-            if (child->destroy) {
-                child->destroy(child);
-            }
-            child = next;
-        }
-        free(panel);
+        /* Destroys and frees the children too */
+        view_destroy((View*)panel);
     }
 }
 
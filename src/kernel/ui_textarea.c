@@ -22,6 +22,8 @@ static void textarea_draw(View *view, GraphicsContext *gc);
 static int textarea_handle_event(View *view, InputEvent *event);
 static void textarea_destroy(View *view);
 static void ensure_cursor_visible(TextArea *textarea);
+static void textarea_refresh_after_key(TextArea *textarea, unsigned char key,
+                                       int old_top, int old_left, int old_line);
 static int get_line_at_y(TextArea *textarea, int y);
 static int get_col_at_x(TextArea *textarea, int line_idx, int x);
 static int textarea_keyboard_handler(View *view, InputEvent *event, void *context);
@@ -112,7 +114,7 @@ static void textarea_interface_on_focus_gained(View *view) {
     text_edit_base_set_focus(&textarea->edit_base, view, 1);
     
     /* Mark for redraw */
-    view->needs_redraw = 1;
+    view_invalidate(view);
 }
 
 static void textarea_interface_on_focus_lost(View *view) {
@@ -131,7 +133,7 @@ static void textarea_interface_on_focus_lost(View *view) {
     text_edit_base_set_focus(&textarea->edit_base, view, 0);
     
     /* Mark for redraw */
-    view->needs_redraw = 1;
+    view_invalidate(view);
 }
 
 static int textarea_interface_can_focus(View *view) {
@@ -175,6 +177,8 @@ TextArea* textarea_create(int x, int y, int width, int height) {
     view->destroy = textarea_destroy;
     view->type_name = "TextArea";
     view->interface = &textarea_interface;  /* Set ViewInterface */
+    view->cache = NULL;
+    view->arena = NULL;
     
     /* Calculate pixel dimensions (not position - View handles that) */
     /* These are the actual pixel dimensions of the textarea content area */
@@ -228,7 +232,7 @@ static void textarea_draw(View *view, GraphicsContext *gc) {
     int line_height = (textarea->edit_base.font == FONT_9X16) ? LINE_HEIGHT_9X16 : LINE_HEIGHT_6X8;
     int char_width = (textarea->edit_base.font == FONT_9X16) ? 9 : 6;
     int char_height = (textarea->edit_base.font == FONT_9X16) ? 16 : 8;
-    int i, j, line_y, char_x;
+    int i, run_len, line_y;
     unsigned char bg_color, text_color, border_color;
     TextAreaLine *line;
     
@@ -254,15 +258,12 @@ static void textarea_draw(View *view, GraphicsContext *gc) {
         line = &textarea->lines[i + textarea->scroll_top];
         line_y = y + TEXTAREA_PADDING + i * line_height;
         
-        /* Draw visible characters in this line */
-        for (j = textarea->scroll_left; j < line->length && j < (textarea->scroll_left + textarea->visible_cols); j++) {
-            char_x = x + TEXTAREA_PADDING + (j - textarea->scroll_left) * char_width;
-            if (textarea->edit_base.font == FONT_9X16) {
-                /* Use BIOS font for 9x16 */
-                dispi_draw_char_bios(char_x, line_y, line->text[j], text_color, bg_color);
-            } else {
-                dispi_draw_char(char_x, line_y, line->text[j], text_color, bg_color);
-            }
+        /* Draw the visible part of this line as one run */
+        run_len = line->length - textarea->scroll_left;
+        if (run_len > textarea->visible_cols) run_len = textarea->visible_cols;
+        if (run_len > 0) {
+            gc_draw_text(gc, x + TEXTAREA_PADDING, line_y, line->text + textarea->scroll_left,
+                         run_len, textarea->edit_base.font, text_color, bg_color);
         }
     }
     
@@ -289,11 +290,8 @@ static void textarea_draw(View *view, GraphicsContext *gc) {
             if (textarea->cursor_col < textarea->lines[textarea->cursor_line].length) {
                 char c = textarea->lines[textarea->cursor_line].text[textarea->cursor_col];
                 /* Draw black character on gold cursor background */
-                if (textarea->edit_base.font == FONT_9X16) {
-                    dispi_draw_char_bios(cursor_x, cursor_y, c, COLOR_BLACK, textarea->edit_base.cursor_color);
-                } else {
-                    dispi_draw_char(cursor_x, cursor_y, c, COLOR_BLACK, textarea->edit_base.cursor_color);
-                }
+                gc_draw_text(gc, cursor_x, cursor_y, &c, 1, textarea->edit_base.font,
+                             COLOR_BLACK, textarea->edit_base.cursor_color);
             }
         }
     }
@@ -302,6 +300,7 @@ static void textarea_draw(View *view, GraphicsContext *gc) {
 /* Event bus handler for keyboard events */
 static int textarea_keyboard_handler(View *view, InputEvent *event, void *context) {
     TextArea *textarea = (TextArea*)context;
+    int old_top, old_left, old_line;
     
     if (!textarea || !event || event->type != EVENT_KEY_DOWN) {
         return 0;
@@ -315,12 +314,15 @@ static int textarea_keyboard_handler(View *view, InputEvent *event, void *contex
     serial_write_string("TextArea: Handling keyboard event via event bus\n");
     
     /* Handle the key */
+    old_top = textarea->scroll_top;
+    old_left = textarea->scroll_left;
+    old_line = textarea->cursor_line;
     textarea_handle_key(textarea, event->data.keyboard.ascii);
     
     /* Reset typing timer to keep cursor solid */
     text_edit_base_reset_typing_timer(&textarea->edit_base);
     
-    view_invalidate((View*)textarea);
+    textarea_refresh_after_key(textarea, event->data.keyboard.ascii, old_top, old_left, old_line);
     
     return 1;  /* Event handled */
 }
@@ -389,6 +391,7 @@ static int textarea_handle_event(View *view, InputEvent *event) {
     RegionRect abs_bounds;
     int abs_x, abs_y;
     int handled;
+    int old_top, old_left, old_line;
     
     switch (event->type) {
         case EVENT_MOUSE_DOWN:
@@ -420,15 +423,19 @@ static int textarea_handle_event(View *view, InputEvent *event) {
             /* Reset cursor blink using shared base */
             text_edit_base_reset_typing_timer(&textarea->edit_base);
             
-            view->needs_redraw = 1;
+            view_invalidate(view);
             return 1;
             
         case EVENT_KEY_DOWN:
             if (textarea->edit_base.has_focus) {
+                old_top = textarea->scroll_top;
+                old_left = textarea->scroll_left;
+                old_line = textarea->cursor_line;
                 textarea_handle_key(textarea, event->data.keyboard.ascii);
                 /* Reset typing timer to keep cursor solid */
                 text_edit_base_reset_typing_timer(&textarea->edit_base);
-                view->needs_redraw = 1;
+                textarea_refresh_after_key(textarea, event->data.keyboard.ascii,
+                                           old_top, old_left, old_line);
                 return 1;
             }
             break;
@@ -803,6 +810,61 @@ static void ensure_cursor_visible(TextArea *textarea) {
     }
 }
 
+/* Keys that move the cursor (and maybe scroll) but never change text */
+static int textarea_is_motion_key(unsigned char key) {
+    switch (key) {
+        case 0x11: case 0x12: case 0x13: case 0x14:  /* Arrows */
+        case 0x15: case 0x16: case 0x17: case 0x18:  /* Home, End, PgUp, PgDn */
+        case 0x01: case 0x05: case 0x02: case 0x06:  /* Ctrl-A, E, B, F */
+        case 0x0E: case 0x10:                        /* Ctrl-N, P */
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+/* Invalidate the row a line occupies, if it is visible */
+static void textarea_invalidate_line(TextArea *textarea, int line) {
+    int line_height = (textarea->edit_base.font == FONT_9X16) ? LINE_HEIGHT_9X16 : LINE_HEIGHT_6X8;
+    int row = line - textarea->scroll_top;
+    
+    if (row < 0 || row >= textarea->visible_lines) return;
+    
+    view_invalidate_rect((View*)textarea, 1, TEXTAREA_PADDING + row * line_height,
+                         textarea->pixel_width - 2, line_height);
+}
+
+/* Invalidate what a key changed.
+ * Why scroll the pixels: paging or arrowing past the edge used to
+ * repaint every visible line, though all but the newly exposed ones
+ * were already on screen, just one scroll step away. For keys that
+ * only move the cursor, the lines are moved with a block copy, and only
+ * the exposed lines and the cursor's old and new rows are repainted. */
+static void textarea_refresh_after_key(TextArea *textarea, unsigned char key,
+                                       int old_top, int old_left, int old_line) {
+    int line_height = (textarea->edit_base.font == FONT_9X16) ? LINE_HEIGHT_9X16 : LINE_HEIGHT_6X8;
+    int shift = textarea->scroll_top - old_top;
+    int height;
+    
+    if (!textarea_is_motion_key(key) || textarea->scroll_left != old_left) {
+        view_invalidate((View*)textarea);
+        return;
+    }
+    
+    if (shift != 0) {
+        /* The line rows, stopping short of the bottom border */
+        height = textarea->visible_lines * line_height;
+        if (height > textarea->pixel_height - 1 - TEXTAREA_PADDING) {
+            height = textarea->pixel_height - 1 - TEXTAREA_PADDING;
+        }
+        view_scroll_rect((View*)textarea, 1, TEXTAREA_PADDING, textarea->pixel_width - 2,
+                         height, 0, -shift * line_height);
+    }
+    
+    textarea_invalidate_line(textarea, old_line);
+    textarea_invalidate_line(textarea, textarea->cursor_line);
+}
+
 /* Handle keyboard input */
 void textarea_handle_key(TextArea *textarea, unsigned char key) {
     /* Special keys */
@@ -1017,5 +1079,5 @@ void textarea_set_focus(TextArea *textarea, int focus) {
 
 /* Destroy textarea */
 static void textarea_destroy(View *view) {
-    /* TextArea will be freed by caller */
+    /* TextArea is freed by view_destroy */
 }
\ No newline at end of file
@@ -80,8 +80,9 @@ static void draw_cursor(TextInput *input, GraphicsContext *gc, int x, int y) {
         /* Redraw the character at cursor position in inverted color if there is one */
         if (input->cursor_pos < input->text_length) {
             cursor_char = input->buffer[input->cursor_pos];
-            /* Use dispi_draw_char with inverted colors */
-            dispi_draw_char(cursor_x, cursor_y, cursor_char, COLOR_BLACK, input->edit_base.cursor_color);
+            /* Draw it with inverted colors */
+            gc_draw_text(gc, cursor_x, cursor_y, &cursor_char, 1, input->edit_base.font,
+                         COLOR_BLACK, input->edit_base.cursor_color);
         }
         
         /* Option 2: Underscore cursor (uncomment to use this instead) */
@@ -103,10 +104,8 @@ void textinput_draw(View *self, GraphicsContext *gc) {
     int char_width, char_height;
     int text_x, text_y;
     const char *display_text;
-    char visible_buffer[80];  /* Temporary buffer for visible portion */
     int max_visible_chars;
     int visible_start, visible_len;
-    int i;
     
     /* Get absolute position from parent hierarchy */
     view_get_absolute_bounds(self, &abs_bounds);
@@ -159,23 +158,16 @@ void textinput_draw(View *self, GraphicsContext *gc) {
             visible_len = max_visible_chars;
         }
         
-        /* Copy visible portion to temporary buffer */
-        for (i = 0; i < visible_len; i++) {
-            visible_buffer[i] = input->buffer[visible_start + i];
-        }
-        visible_buffer[visible_len] = '\0';
-        display_text = visible_buffer;
+        display_text = input->buffer + visible_start;
+        if (visible_len < 0) visible_len = 0;
     }
     
     /* Draw text */
     text_x = x + PADDING_SMALL;
     text_y = y + (h - char_height) / 2;
     
-    if (input->edit_base.font == FONT_9X16) {
-        dispi_draw_string_bios(text_x, text_y, display_text, fg_color, bg_color);
-    } else {
-        dispi_draw_string(text_x, text_y, display_text, fg_color, bg_color);
-    }
+    gc_draw_text(gc, text_x, text_y, display_text, visible_len, input->edit_base.font,
+                 fg_color, bg_color);
     
     /* Draw cursor if focused */
     if (input->edit_base.has_focus && input->text_length > 0) {
@@ -573,7 +565,7 @@ static void textinput_interface_destroy(View *view) {
     
     /* Free text buffer */
     if (input->buffer) {
-        /* Note: Our allocator doesn't support free yet */
+        free(input->buffer);
         input->buffer = NULL;
     }
 }
@@ -600,7 +592,7 @@ static void textinput_interface_on_focus_gained(View *view) {
     text_edit_base_set_focus(&input->edit_base, view, 1);
     
     /* Mark for redraw */
-    view->needs_redraw = 1;
+    view_invalidate(view);
 }
 
 static void textinput_interface_on_focus_lost(View *view) {
@@ -619,7 +611,7 @@ static void textinput_interface_on_focus_lost(View *view) {
     text_edit_base_set_focus(&input->edit_base, view, 0);
     
     /* Mark for redraw */
-    view->needs_redraw = 1;
+    view_invalidate(view);
 }
 
 static int textinput_interface_can_focus(View *view) {
@@ -687,6 +679,8 @@ TextInput* textinput_create(int x, int y, int width, const char *placeholder, Fo
     input->base.destroy = NULL;
     input->base.type_name = "TextInput";
     input->base.interface = &textinput_interface;  /* Set ViewInterface */
+    input->base.cache = NULL;
+    input->base.arena = NULL;
     
     /* Initialize shared text editing base */
     text_edit_base_init(&input->edit_base);
@@ -723,10 +717,8 @@ TextInput* textinput_create(int x, int y, int width, const char *placeholder, Fo
 /* Destroy text input */
 void textinput_destroy(TextInput *input) {
     if (input) {
-        if (input->buffer) {
-            free(input->buffer);
-        }
-        free(input);
+        /* The interface destroy frees the text buffer */
+        view_destroy((View*)input);
     }
 }
 
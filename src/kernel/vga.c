@@ -2,6 +2,31 @@
 
 #include "vga.h"
 #include "io.h"
+#include "serial.h"
+
+/* Shadow cell buffer that all drawing composes into */
+static unsigned short vga_shadow[VGA_WIDTH * VGA_HEIGHT];
+
+/* Copy of what was last written to each hardware text page, and whether
+ * it can be trusted. It is not trusted at boot or after a mode switch,
+ * since the BIOS or mode set leaves unknown contents in text memory. */
+static unsigned short vga_front[VGA_TEXT_PAGES][VGA_WIDTH * VGA_HEIGHT];
+static int vga_front_valid[VGA_TEXT_PAGES];
+
+/* Hardware page the CRTC is currently scanning out */
+static int vga_visible_page = 0;
+
+/* Mouse cursor overlay. The shadow buffer never contains the mouse; it
+ * is painted over the visible page as a single recoloured cell, with the
+ * cell it covers saved so it can be put back when the mouse moves. */
+static int vga_mouse_pos = -1;              /* Cell index, or -1 if hidden */
+static unsigned short vga_mouse_under = 0;  /* Cell the overlay covers */
+
+/* Statistics since the last vga_report_stats() */
+static unsigned int vga_present_count = 0;
+static unsigned int vga_cells_written = 0;
+static unsigned int vga_cells_last = 0;
+static unsigned int vga_flip_count = 0;
 
 /* Initialize VGA display to a clean state */
 void vga_init(void) {
@@ -14,7 +39,7 @@ void vga_clear_screen(void) {
     int i;
     /* Fill entire buffer with spaces and default color */
     for (i = 0; i < VGA_WIDTH * VGA_HEIGHT; i++) {
-        VGA_BUFFER[i] = VGA_COLOR | ' ';
+        vga_shadow[i] = VGA_COLOR | ' ';
     }
 }
 
@@ -23,7 +48,7 @@ void vga_clear_screen(void) {
  * corrupt other memory or cause crashes. */
 void vga_write_char(int pos, char c, unsigned short color) {
     if (!SAFE_VGA_POS(pos)) return;
-    VGA_BUFFER[pos] = color | c;
+    vga_shadow[pos] = color | (unsigned char)c;
 }
 
 /* Write a string starting at position */
@@ -31,7 +56,7 @@ void vga_write_string(int pos, const char *str, unsigned short color) {
     if (!str) return;
     
     while (*str && SAFE_VGA_POS(pos)) {
-        VGA_BUFFER[pos] = color | *str;
+        vga_shadow[pos] = color | (unsigned char)*str;
         str++;
         pos++;
     }
@@ -41,18 +66,21 @@ void vga_write_string(int pos, const char *str, unsigned short color) {
 void vga_fill_region(int start, int length, char c, unsigned short color) {
     int i;
     for (i = 0; i < length && SAFE_VGA_POS(start + i); i++) {
-        VGA_BUFFER[start + i] = color | c;
+        vga_shadow[start + i] = color | (unsigned char)c;
     }
 }
 
 /* Update hardware cursor position.
  * The VGA hardware cursor is controlled through I/O ports.
- * We write the position as two bytes (high and low) to the VGA registers. */
+ * We write the position as two bytes (high and low) to the VGA registers.
+ * The cursor address is absolute in text memory, so it is offset to the
+ * hardware page being shown. */
 void vga_set_cursor(int pos) {
     if (!SAFE_VGA_POS(pos)) {
         vga_hide_cursor();
         return;
     }
+    pos += vga_visible_page * VGA_PAGE_STRIDE;
     
     /* Tell VGA we're setting cursor high byte */
     outb(VGA_CTRL_REGISTER, VGA_CURSOR_HIGH);
@@ -65,21 +93,178 @@ void vga_set_cursor(int pos) {
 
 /* Disable hardware cursor by moving it off-screen */
 void vga_hide_cursor(void) {
-    /* Position 0x2000 is well beyond the visible screen */
+    /* The cells between the end of a 2000-cell screen and the start of
+     * the next page are never scanned out */
+    int pos = vga_visible_page * VGA_PAGE_STRIDE + VGA_WIDTH * VGA_HEIGHT;
+    
     outb(VGA_CTRL_REGISTER, VGA_CURSOR_HIGH);
-    outb(VGA_DATA_REGISTER, 0x20);
+    outb(VGA_DATA_REGISTER, (pos >> 8) & 0xFF);
     outb(VGA_CTRL_REGISTER, VGA_CURSOR_LOW);
-    outb(VGA_DATA_REGISTER, 0x00);
+    outb(VGA_DATA_REGISTER, pos & 0xFF);
 }
 
 /* Get character at position (without color) */
 char vga_get_char(int pos) {
     if (!SAFE_VGA_POS(pos)) return '\0';
-    return VGA_BUFFER[pos] & 0xFF;
+    return vga_shadow[pos] & 0xFF;
 }
 
 /* Get full 16-bit value (char + color) at position */
 unsigned short vga_get_entry(int pos) {
     if (!SAFE_VGA_POS(pos)) return 0;
-    return VGA_BUFFER[pos];
-}
\ No newline at end of file
+    return vga_shadow[pos];
+}
+
+/* Push changed cells from the shadow buffer to VGA memory.
+ * Why compare against a RAM copy instead of reading VGA memory back:
+ * reads from video memory are slow on real hardware and trap to the
+ * emulator under QEMU, while comparing two RAM arrays is nearly free. */
+int vga_present(void) {
+    return vga_present_page(vga_visible_page);
+}
+
+/* Write cell pos of a hardware page if it differs from what is there */
+static int vga_put_cell(int page, int pos, unsigned short entry) {
+    if (vga_front_valid[page] && vga_front[page][pos] == entry) {
+        return 0;
+    }
+    VGA_BUFFER[page * VGA_PAGE_STRIDE + pos] = entry;
+    vga_front[page][pos] = entry;
+    return 1;
+}
+
+/* A cell as it looks with the mouse cursor over it */
+static unsigned short vga_mouse_cell(unsigned short entry) {
+    return VGA_COLOR_MOUSE | (entry & 0xFF);
+}
+
+/* Copy changed shadow cells in [from, to) to a hardware page */
+static int vga_sync_range(int page, int from, int to) {
+    int i;
+    int written = 0;
+    unsigned short *vram = VGA_BUFFER + page * VGA_PAGE_STRIDE;
+    unsigned short *front = vga_front[page];
+    int valid = vga_front_valid[page];
+    
+    for (i = from; i < to; i++) {
+        if (!valid || front[i] != vga_shadow[i]) {
+            vram[i] = vga_shadow[i];
+            front[i] = vga_shadow[i];
+            written++;
+        }
+    }
+    return written;
+}
+
+/* Push changed cells from the shadow buffer to a hardware text page,
+ * which need not be the one on screen */
+int vga_present_page(int page) {
+    int written = 0;
+    int mouse;
+    
+    if (page < 0 || page >= VGA_TEXT_PAGES) return 0;
+    
+    /* The mouse cell is the one place the visible page differs from the
+     * shadow, so it is skipped by the copy and overlaid on its own */
+    mouse = (page == vga_visible_page) ? vga_mouse_pos : -1;
+    if (mouse >= 0) {
+        written += vga_sync_range(page, 0, mouse);
+        vga_mouse_under = vga_shadow[mouse];
+        written += vga_put_cell(page, mouse, vga_mouse_cell(vga_mouse_under));
+        written += vga_sync_range(page, mouse + 1, VGA_WIDTH * VGA_HEIGHT);
+    } else {
+        written += vga_sync_range(page, 0, VGA_WIDTH * VGA_HEIGHT);
+    }
+    vga_front_valid[page] = 1;
+    
+    vga_present_count++;
+    vga_cells_written += written;
+    vga_cells_last = written;
+    return written;
+}
+
+/* Point the CRTC at a hardware text page.
+ * Why this is instant: the start address registers only tell the CRTC
+ * where to begin scanning, so switching pages is four port writes no
+ * matter what the page holds. */
+void vga_show_page(int page) {
+    unsigned int start;
+    
+    if (page < 0 || page >= VGA_TEXT_PAGES) return;
+    
+    start = page * VGA_PAGE_STRIDE;
+    outb(VGA_CTRL_REGISTER, VGA_START_HIGH);
+    outb(VGA_DATA_REGISTER, (start >> 8) & 0xFF);
+    outb(VGA_CTRL_REGISTER, VGA_START_LOW);
+    outb(VGA_DATA_REGISTER, start & 0xFF);
+    
+    vga_visible_page = page;
+    vga_flip_count++;
+    
+    /* Carry the mouse overlay over to the newly shown page */
+    if (vga_mouse_pos >= 0 && vga_front_valid[page]) {
+        vga_mouse_under = vga_front[page][vga_mouse_pos];
+        vga_put_cell(page, vga_mouse_pos, vga_mouse_cell(vga_mouse_under));
+    }
+}
+
+/* Move the mouse cursor overlay to cell pos, or hide it with -1.
+ * Why an overlay: a mouse move then costs two cell writes (restore the
+ * old cell, recolour the new one) instead of recomposing the screen,
+ * and drawing code never has to know where the mouse is. */
+void vga_set_mouse(int pos) {
+    int page = vga_visible_page;
+    
+    if (!SAFE_VGA_POS(pos)) pos = -1;
+    if (pos == vga_mouse_pos) return;
+    
+    if (vga_mouse_pos >= 0 && vga_front_valid[page]) {
+        vga_put_cell(page, vga_mouse_pos, vga_mouse_under);
+    }
+    
+    vga_mouse_pos = pos;
+    
+    if (pos >= 0 && vga_front_valid[page]) {
+        vga_mouse_under = vga_front[page][pos];
+        vga_put_cell(page, pos, vga_mouse_cell(vga_mouse_under));
+    }
+}
+
+/* Hardware text page currently on screen */
+int vga_get_visible_page(void) {
+    return vga_visible_page;
+}
+
+/* Forget what VGA memory holds. A mode set also resets the CRTC start
+ * address, so page 0 is on screen again. */
+void vga_invalidate(void) {
+    int i;
+    
+    for (i = 0; i < VGA_TEXT_PAGES; i++) {
+        vga_front_valid[i] = 0;
+    }
+    vga_visible_page = 0;
+}
+
+/* Log present/cell-write counters to the debug port and reset them */
+void vga_report_stats(void) {
+    if (vga_present_count == 0) return;
+    
+    serial_write_string("VGA: ");
+    serial_write_int(vga_present_count);
+    serial_write_string(" refreshes, ");
+    serial_write_int(vga_cells_written);
+    serial_write_string(" cells written (avg ");
+    serial_write_int(vga_cells_written / vga_present_count);
+    serial_write_string(", last ");
+    serial_write_int(vga_cells_last);
+    serial_write_string(" of ");
+    serial_write_int(VGA_WIDTH * VGA_HEIGHT);
+    serial_write_string("), ");
+    serial_write_int(vga_flip_count);
+    serial_write_string(" page flips\n");
+    
+    vga_present_count = 0;
+    vga_cells_written = 0;
+    vga_flip_count = 0;
+}
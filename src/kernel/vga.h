@@ -11,6 +11,22 @@
  * The VGA buffer is a linear array of 16-bit values where:
  * - Low byte: ASCII character
  * - High byte: Color attributes (background | foreground)
+ *
+ * Drawing functions never touch 0xB8000 directly. They compose into a
+ * shadow cell buffer in RAM, and vga_present() copies only the cells
+ * that differ from what was last written to VGA memory. A keystroke
+ * that changes one character therefore costs one VGA write, not 2000.
+ *
+ * Text memory at 0xB8000 is 32KB, room for eight 80x25 screens. Each
+ * hardware page has its own record of what it holds, so a screen can be
+ * presented to a page that is not being shown and then made visible by
+ * moving the CRTC start address (vga_show_page). The display module uses
+ * this to keep neighbouring editor pages ready off-screen.
+ *
+ * The mouse cursor is not drawn into the shadow buffer. vga_set_mouse()
+ * overlays it on the visible page by recolouring one cell and restoring
+ * the saved cell when it moves, and vga_present() keeps the overlay on
+ * top of whatever is presented underneath it.
  */
 
 #ifndef VGA_H
@@ -21,6 +37,11 @@
 #define VGA_WIDTH 80
 #define VGA_HEIGHT 25
 
+/* Hardware text pages. Pages sit 4KB (2048 cells) apart, the layout the
+ * BIOS uses, so each 2000-cell screen starts on its own boundary. */
+#define VGA_TEXT_PAGES 8
+#define VGA_PAGE_STRIDE 2048
+
 /* Color codes (high byte of VGA buffer entries) */
 #define VGA_COLOR 0x1F00  /* Blue background, white text (default) */
 #define VGA_COLOR_NAV_BAR 0x7000  /* Gray background, black text */
@@ -32,6 +53,8 @@
 #define VGA_DATA_REGISTER 0x3D5
 #define VGA_CURSOR_HIGH 0x0E
 #define VGA_CURSOR_LOW 0x0F
+#define VGA_START_HIGH 0x0C
+#define VGA_START_LOW 0x0D
 
 /* Bounds checking macro for safe buffer access */
 #define SAFE_VGA_POS(pos) ((pos) >= 0 && (pos) < (VGA_WIDTH * VGA_HEIGHT))
@@ -64,4 +87,27 @@ char vga_get_char(int pos);
 /* Get full 16-bit value (char + color) at position */
 unsigned short vga_get_entry(int pos);
 
+/* Push changed cells from the shadow buffer to the visible page.
+ * Returns the number of cells written. */
+int vga_present(void);
+
+/* Push changed cells from the shadow buffer to hardware page 0-7 */
+int vga_present_page(int page);
+
+/* Make hardware page 0-7 visible by moving the CRTC start address */
+void vga_show_page(int page);
+
+/* Hardware page currently on screen */
+int vga_get_visible_page(void);
+
+/* Move the mouse cursor overlay to a cell, or hide it with -1 */
+void vga_set_mouse(int pos);
+
+/* Forget what VGA memory holds so the next present rewrites every cell.
+ * Call after anything else has written to text memory (mode switches). */
+void vga_invalidate(void);
+
+/* Log present/cell-write counters to the debug port and reset them */
+void vga_report_stats(void);
+
 #endif /* VGA_H */
\ No newline at end of file
@@ -49,10 +49,14 @@ View* view_create(int x, int y, int width, int height) {
     /* Initialize interface to NULL - will be set by subclasses */
     view->interface = NULL;
     
+    /* Drawn directly until view_set_cached() */
+    view->cache = NULL;
+    view->arena = NULL;
+    
     return view;
 }
 
-/* Destroy a view and all its children */
+/* Destroy a view and all its children, and free them */
 void view_destroy(View *view) {
     View *child, *next_child;
     
@@ -79,8 +83,14 @@ void view_destroy(View *view) {
         view_remove_child(view->parent, view);
     }
     
-    /* Note: In a real system we'd free the memory here */
-    /* Our allocator doesn't support free yet */
+    view_set_cached(view, 0);
+    
+    /* A view owns its subtree, so this frees subclass views (Button,
+     * Label, ...) too; they all start with View. Arena views are
+     * released with their arena. */
+    if (!view->arena) {
+        free(view);
+    }
 }
 
 /* Add a child view to a parent */
@@ -272,67 +282,395 @@ void view_send_to_back(View *view) {
     view_invalidate(parent);
 }
 
-/* Mark view for redraw */
+/* Damage accumulated since the last frame, disjoint, in screen pixels */
+static DamageRect damage[VIEW_MAX_DAMAGE];
+static int damage_count = 0;
+
+/* Memory held by view caches, and what they have saved */
+static unsigned int cache_bytes = 0;
+static unsigned int cache_limit = VIEW_CACHE_DEFAULT_LIMIT;
+static unsigned int cache_renders = 0;
+static unsigned int cache_composites = 0;
+static unsigned int cache_refusals = 0;
+
+/* Get a view's absolute bounds in pixels */
+static void view_get_pixel_bounds(View *view, DamageRect *rect) {
+    RegionRect abs_bounds;
+    
+    view_get_absolute_bounds(view, &abs_bounds);
+    grid_region_to_pixel(abs_bounds.x, abs_bounds.y, &rect->x, &rect->y);
+    rect->width = abs_bounds.width * REGION_WIDTH;
+    rect->height = abs_bounds.height * REGION_HEIGHT;
+}
+
+/* Clip rect to clip; returns 0 if nothing is left */
+static int damage_intersect(DamageRect *rect, const DamageRect *clip) {
+    int x1 = rect->x, y1 = rect->y;
+    int x2 = rect->x + rect->width, y2 = rect->y + rect->height;
+    
+    if (x1 < clip->x) x1 = clip->x;
+    if (y1 < clip->y) y1 = clip->y;
+    if (x2 > clip->x + clip->width) x2 = clip->x + clip->width;
+    if (y2 > clip->y + clip->height) y2 = clip->y + clip->height;
+    
+    if (x2 <= x1 || y2 <= y1) return 0;
+    
+    rect->x = x1;
+    rect->y = y1;
+    rect->width = x2 - x1;
+    rect->height = y2 - y1;
+    return 1;
+}
+
+static int damage_overlaps(const DamageRect *a, const DamageRect *b) {
+    return a->x < b->x + b->width && b->x < a->x + a->width &&
+           a->y < b->y + b->height && b->y < a->y + a->height;
+}
+
+/* Grow rect to cover other as well */
+static void damage_union(DamageRect *rect, const DamageRect *other) {
+    int x2 = rect->x + rect->width, y2 = rect->y + rect->height;
+    
+    if (other->x + other->width > x2) x2 = other->x + other->width;
+    if (other->y + other->height > y2) y2 = other->y + other->height;
+    if (other->x < rect->x) rect->x = other->x;
+    if (other->y < rect->y) rect->y = other->y;
+    rect->width = x2 - rect->x;
+    rect->height = y2 - rect->y;
+}
+
+/* Add a screen rectangle to the damage.
+ * Why keep the list disjoint: every rectangle is repainted on its own,
+ * so an overlap would be drawn twice. When the list is full, the new
+ * rectangle is merged with whichever one grows least, trading a little
+ * overdraw for a bounded list. */
+void view_add_damage(int x, int y, int width, int height) {
+    static const DamageRect screen = { 0, 0, SCREEN_WIDTH, SCREEN_HEIGHT };
+    DamageRect rect, merged;
+    unsigned int growth, best_growth;
+    int i, best;
+    
+    rect.x = x;
+    rect.y = y;
+    rect.width = width;
+    rect.height = height;
+    if (width <= 0 || height <= 0 || !damage_intersect(&rect, &screen)) return;
+    
+    for (;;) {
+        /* Absorb everything the rectangle overlaps */
+        i = 0;
+        while (i < damage_count) {
+            if (damage_overlaps(&damage[i], &rect)) {
+                damage_union(&rect, &damage[i]);
+                damage[i] = damage[--damage_count];
+                i = 0;
+            } else {
+                i++;
+            }
+        }
+        
+        if (damage_count < VIEW_MAX_DAMAGE) break;
+        
+        best = 0;
+        best_growth = 0xFFFFFFFF;
+        for (i = 0; i < damage_count; i++) {
+            merged = rect;
+            damage_union(&merged, &damage[i]);
+            growth = (unsigned int)(merged.width * merged.height) -
+                     (unsigned int)(damage[i].width * damage[i].height);
+            if (growth < best_growth) {
+                best_growth = growth;
+                best = i;
+            }
+        }
+        damage_union(&rect, &damage[best]);
+        damage[best] = damage[--damage_count];
+    }
+    
+    damage[damage_count++] = rect;
+}
+
+/* Copy out the accumulated damage */
+int view_get_damage(DamageRect *rects, int max) {
+    int i;
+    
+    for (i = 0; i < damage_count && i < max; i++) {
+        rects[i] = damage[i];
+    }
+    return damage_count;
+}
+
+/* Forget the accumulated damage */
+void view_clear_damage(void) {
+    damage_count = 0;
+}
+
+/* Mark view for redraw and damage its screen area */
 void view_invalidate(View *view) {
+    DamageRect rect;
+    
     if (!view) return;
     
-    view->needs_redraw = 1;
+    view_get_pixel_bounds(view, &rect);
+    view_add_damage(rect.x, rect.y, rect.width, rect.height);
     
-    /* Propagate up to parent */
-    if (view->parent) {
-        view_invalidate(view->parent);
+    /* Only this view's own pixels changed; ancestors keep their caches */
+    if (view->cache) {
+        view->cache->valid = 0;
+    }
+    
+    /* Propagate the flag up to the root */
+    while (view) {
+        view->needs_redraw = 1;
+        view = view->parent;
     }
 }
 
-/* Mark specific rectangle for redraw */
-void view_invalidate_rect(View *view, RegionRect *rect) {
-    /* For now, just invalidate the whole view */
-    /* TODO: Implement dirty rectangle tracking */
-    view_invalidate(view);
+/* Mark specific rectangle for redraw, in pixels relative to the view */
+void view_invalidate_rect(View *view, int x, int y, int width, int height) {
+    DamageRect rect, area;
+    
+    if (!view) return;
+    
+    view_get_pixel_bounds(view, &rect);
+    area.x = rect.x + x;
+    area.y = rect.y + y;
+    area.width = width;
+    area.height = height;
+    if (damage_intersect(&area, &rect)) {
+        view_add_damage(area.x, area.y, area.width, area.height);
+    }
+    
+    if (view->cache) {
+        view->cache->valid = 0;
+    }
+    
+    while (view) {
+        view->needs_redraw = 1;
+        view = view->parent;
+    }
+}
+
+/* Move the pixels of part of a view on screen and repaint only the
+ * strips the move uncovers.
+ * Why check needs_redraw first: the copy takes whatever is on screen,
+ * and a view waiting for a redraw may be showing stale pixels there.
+ * Copying them would move the staleness outside the damage. */
+int view_scroll_rect(View *view, int x, int y, int width, int height, int dx, int dy) {
+    DamageRect rect, area;
+    View *v;
+    int adx = dx < 0 ? -dx : dx;
+    int ady = dy < 0 ? -dy : dy;
+    int shown;
+    
+    if (!view) return 0;
+    
+    shown = !view->needs_redraw;
+    for (v = view; v; v = v->parent) {
+        if (!v->visible) shown = 0;
+    }
+    
+    view_get_pixel_bounds(view, &rect);
+    area.x = rect.x + x;
+    area.y = rect.y + y;
+    area.width = width;
+    area.height = height;
+    if (!damage_intersect(&area, &rect)) return 0;
+    if (!dx && !dy) return 1;
+    
+    if (!shown || adx >= area.width || ady >= area.height || (dx && dy)) {
+        view_invalidate_rect(view, x, y, width, height);
+        return 0;
+    }
+    
+    /* Copy the part that stays inside the area */
+    display_copy_rect(area.x + (dx > 0 ? dx : 0), area.y + (dy > 0 ? dy : 0),
+                      area.x + (dx < 0 ? adx : 0), area.y + (dy < 0 ? ady : 0),
+                      area.width - adx, area.height - ady);
+    
+    /* Repaint the strip the content moved away from */
+    x = area.x - rect.x;
+    y = area.y - rect.y;
+    if (dy > 0) {
+        view_invalidate_rect(view, x, y, area.width, ady);
+    } else if (dy < 0) {
+        view_invalidate_rect(view, x, y + area.height - ady, area.width, ady);
+    } else if (dx > 0) {
+        view_invalidate_rect(view, x, y, adx, area.height);
+    } else if (dx < 0) {
+        view_invalidate_rect(view, x + area.width - adx, y, adx, area.height);
+    }
+    return 1;
+}
+
+/* Turn caching on or off for a view */
+void view_set_cached(View *view, int cached) {
+    if (!view) return;
+    
+    if (cached && !view->cache) {
+        view->cache = (ViewCache*)malloc(sizeof(ViewCache));
+        if (!view->cache) return;
+        view->cache->surface = NULL;
+        view->cache->valid = 0;
+        view->cache->opaque = 0;
+    } else if (!cached && view->cache) {
+        if (view->cache->surface) {
+            cache_bytes -= view->cache->surface->width * view->cache->surface->height;
+            surface_destroy(view->cache->surface);
+        }
+        free(view->cache);
+        view->cache = NULL;
+    }
+}
+
+/* Cap the memory all view caches may hold together */
+void view_set_cache_limit(unsigned int bytes) {
+    cache_limit = bytes;
+}
+
+/* Make sure a cached view's pixels are current, rendering them if the
+ * view was invalidated. Returns 0 if the view has to be drawn directly
+ * because its cache would go over the limit. */
+static int view_cache_render(View *view, GraphicsContext *gc, const DamageRect *bounds) {
+    ViewCache *cache = view->cache;
+    unsigned int size = (unsigned int)(bounds->width * bounds->height);
+    int clip_x, clip_y, clip_w, clip_h;
+    int translate_x, translate_y;
+    unsigned int i;
+    
+    /* Reallocate when the view changes size */
+    if (cache->surface && (cache->surface->width != bounds->width ||
+                           cache->surface->height != bounds->height)) {
+        cache_bytes -= cache->surface->width * cache->surface->height;
+        surface_destroy(cache->surface);
+        cache->surface = NULL;
+        cache->valid = 0;
+    }
+    
+    if (!cache->surface) {
+        if (size == 0 || cache_bytes + size > cache_limit) {
+            cache_refusals++;
+            return 0;
+        }
+        cache->surface = surface_create(bounds->width, bounds->height);
+        if (!cache->surface) {
+            cache_refusals++;
+            return 0;
+        }
+        cache_bytes += size;
+        cache->valid = 0;
+    }
+    
+    if (cache->valid) return 1;
+    
+    /* The view draws in screen coordinates, so translate them to the
+     * cache's origin and let it paint the whole view */
+    surface_fill(cache->surface, VIEW_CACHE_KEY);
+    gc_get_clip(gc, &clip_x, &clip_y, &clip_w, &clip_h);
+    gc_get_translation(gc, &translate_x, &translate_y);
+    
+    gc_set_surface(gc, cache->surface);
+    gc_set_translation(gc, translate_x - bounds->x, translate_y - bounds->y);
+    view->draw(view, gc);
+    
+    gc_set_surface(gc, NULL);
+    gc_set_translation(gc, translate_x, translate_y);
+    gc_set_clip(gc, clip_x, clip_y, clip_w, clip_h);
+    
+    /* Views that cover themselves completely composite with row copies */
+    cache->opaque = 1;
+    for (i = 0; i < size; i++) {
+        if (cache->surface->pixels[i] == VIEW_CACHE_KEY) {
+            cache->opaque = 0;
+            break;
+        }
+    }
+    
+    cache->valid = 1;
+    cache_renders++;
+    return 1;
+}
+
+/* Log how much the view caches hold and how often they were reused */
+void view_report_cache_stats(void) {
+    serial_write_string("View caches: ");
+    serial_write_int(cache_bytes);
+    serial_write_string(" of ");
+    serial_write_int(cache_limit);
+    serial_write_string(" bytes, ");
+    serial_write_int(cache_renders);
+    serial_write_string(" renders, ");
+    serial_write_int(cache_composites);
+    serial_write_string(" composites, ");
+    serial_write_int(cache_refusals);
+    serial_write_string(" over the limit\n");
 }
 
 /* Draw a view and all its children */
 void view_draw_tree(View *root, GraphicsContext *gc) {
+    DamageRect screen;
+    
+    screen.x = 0;
+    screen.y = 0;
+    screen.width = SCREEN_WIDTH;
+    screen.height = SCREEN_HEIGHT;
+    view_draw_tree_damaged(root, gc, &screen, NULL);
+}
+
+/* Draw the parts of a tree that fall inside area.
+ * Every visible view is still visited: children are positioned relative
+ * to their parent but not confined to it (the UI demo's text area hangs
+ * below its panel), so a parent missing the damage says nothing about
+ * its subtree. Visiting is a bounds test; only drawing costs pixels. */
+void view_draw_tree_damaged(View *root, GraphicsContext *gc, const DamageRect *area,
+                            ViewDrawStats *stats) {
     View *child;
-    RegionRect abs_bounds;
-    int pixel_x, pixel_y;
+    DamageRect bounds, clip;
     
-    if (!root || !gc) return;
+    if (!root || !gc || !area) return;
     
     /* Skip invisible views */
     if (!root->visible) return;
     
-    /* Get absolute bounds */
-    view_get_absolute_bounds(root, &abs_bounds);
-    
-    /* Convert to pixel coordinates */
-    grid_region_to_pixel(abs_bounds.x, abs_bounds.y, &pixel_x, &pixel_y);
-    
-    /* Save graphics context state */
-    /* TODO: Save/restore clip and translation */
-    
-    /* Set up clipping for this view */
-    gc_set_clip(gc, pixel_x, pixel_y, 
-                abs_bounds.width * REGION_WIDTH, 
-                abs_bounds.height * REGION_HEIGHT);
-    
-    /* Draw the view itself */
-    if (root->draw) {
-        root->draw(root, gc);
+    if (stats) stats->views_visited++;
+    
+    /* Clip the view to the damage */
+    view_get_pixel_bounds(root, &bounds);
+    clip = bounds;
+    if (damage_intersect(&clip, area) && root->draw) {
+        if (root->cache && view_cache_render(root, gc, &bounds)) {
+            /* Composite the cached pixels */
+            gc_set_clip(gc, clip.x, clip.y, clip.width, clip.height);
+            if (root->cache->opaque) {
+                gc_blit(gc, bounds.x, bounds.y, bounds.width, bounds.height,
+                        root->cache->surface->pixels, root->cache->surface->stride);
+            } else {
+                gc_blit_keyed(gc, bounds.x, bounds.y, bounds.width, bounds.height,
+                              root->cache->surface->pixels, root->cache->surface->stride,
+                              VIEW_CACHE_KEY);
+            }
+            cache_composites++;
+        } else {
+            /* Draw the view itself */
+            gc_set_clip(gc, clip.x, clip.y, clip.width, clip.height);
+            root->draw(root, gc);
+        }
+        
+        if (stats) {
+            stats->views_drawn++;
+            stats->pixels_painted += (unsigned int)(clip.width * clip.height);
+        }
     }
     
     /* Draw children in order */
     child = root->children;
     while (child) {
-        view_draw_tree(child, gc);
+        view_draw_tree_damaged(child, gc, area, stats);
         child = child->next_sibling;
     }
     
     /* Clear needs_redraw flag */
     root->needs_redraw = 0;
-    
-    /* Restore graphics context state */
-    /* TODO: Restore clip and translation */
 }
 
 /* Draw a single view (without children) */
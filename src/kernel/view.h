@@ -37,8 +37,41 @@ typedef struct InputEvent {
     } data;
 } InputEvent;
 
+/* A screen-space rectangle in pixels, used for damage */
+typedef struct {
+    int x, y;
+    int width, height;
+} DamageRect;
+
+/* Most damage rectangles kept before the closest ones are merged */
+#define VIEW_MAX_DAMAGE 8
+
+/* What one frame of damage-driven drawing cost */
+typedef struct {
+    int damage_rects;             /* Rectangles repainted */
+    unsigned int damage_pixels;   /* Screen area they cover */
+    int views_visited;            /* Views tested against the damage */
+    int views_drawn;              /* Views whose draw method ran */
+    unsigned int pixels_painted;  /* Clipped area drawn, counting overdraw */
+} ViewDrawStats;
+
+/* Offscreen copy of what a view's own draw method paints (not its
+ * children), reused until the view is invalidated. Pixels the view
+ * leaves untouched hold VIEW_CACHE_KEY and let the parent show through. */
+typedef struct ViewCache {
+    Surface *surface;           /* View-sized, NULL until first drawn */
+    int valid;                  /* Cleared by view_invalidate */
+    int opaque;                 /* No key pixels: composite whole rows */
+} ViewCache;
+
+#define VIEW_CACHE_KEY 255
+
+/* Default cap on memory held by view caches */
+#define VIEW_CACHE_DEFAULT_LIMIT (256 * 1024)
+
 /* Forward declaration for ViewInterface */
 struct ViewInterface;
+struct Arena;
 
 /* View structure - represents a drawable, interactive UI element */
 typedef struct View {
@@ -69,9 +102,18 @@ typedef struct View {
     
     /* View interface for lifecycle management */
     struct ViewInterface *interface;
+    
+    /* Cached rendering, or NULL to draw every time (view_set_cached) */
+    ViewCache *cache;
+    
+    /* Arena the view was allocated from, or NULL if from malloc */
+    struct Arena *arena;
 } View;
 
-/* View lifecycle functions */
+/* View lifecycle functions.
+ * view_destroy detaches the view, destroys its children and frees them
+ * all. Views from an arena are not freed one by one; their memory goes
+ * back when the arena is destroyed. */
 View* view_create(int x, int y, int width, int height);
 void view_destroy(View *view);
 
@@ -86,12 +128,46 @@ void view_set_bounds(View *view, int x, int y, int width, int height);
 void view_bring_to_front(View *view);
 void view_send_to_back(View *view);
 
-/* View rendering */
+/* View rendering.
+ * view_invalidate marks the view (and its ancestors) for redraw and adds
+ * its screen area to the damage; view_invalidate_rect damages only the
+ * given rectangle, in pixels relative to the view's top-left corner. */
 void view_invalidate(View *view);
-void view_invalidate_rect(View *view, RegionRect *rect);
+void view_invalidate_rect(View *view, int x, int y, int width, int height);
+
+/* Scroll part of a view on screen: move the pixels of the rectangle
+ * (view-relative, as above) by dx or dy, without redrawing them, and
+ * invalidate the strip uncovered at the other edge. The view must be
+ * the only thing drawn there. Falls back to invalidating the whole
+ * rectangle (and returns 0) when the view is hidden, has a redraw
+ * pending, or the move is diagonal or as large as the rectangle. */
+int view_scroll_rect(View *view, int x, int y, int width, int height, int dx, int dy);
 void view_draw_tree(View *root, GraphicsContext *gc);
 void view_draw(View *view, GraphicsContext *gc);
 
+/* Damage accumulated since the last view_clear_damage(). Rectangles are
+ * clipped to the screen and kept disjoint; view_get_damage copies up to
+ * max of them and returns how many there are. */
+void view_add_damage(int x, int y, int width, int height);
+int view_get_damage(DamageRect *rects, int max);
+void view_clear_damage(void);
+
+/* Draw the views of a tree that intersect area, each clipped to it, in
+ * tree order, and clear their needs_redraw flags. Adds to stats if it is
+ * not NULL. */
+void view_draw_tree_damaged(View *root, GraphicsContext *gc, const DamageRect *area,
+                            ViewDrawStats *stats);
+
+/* Cached views.
+ * A cached view is drawn into its own 8bpp surface when it is
+ * invalidated and composited into the backbuffer from there otherwise.
+ * Only views whose draw method depends on nothing but their own state
+ * should be cached. Memory for all caches together is capped; a view
+ * whose cache would exceed the cap is drawn directly instead. */
+void view_set_cached(View *view, int cached);
+void view_set_cache_limit(unsigned int bytes);
+void view_report_cache_stats(void);
+
 /* View updates */
 void view_update_tree(View *root, int delta_ms);
 
@@ -170,7 +170,7 @@ void view_interface_default_on_child_removed(View *view, View *child) {
 void view_interface_default_on_focus_gained(View *view) {
     /* Default: mark for redraw */
     if (view) {
-        view->needs_redraw = 1;
+        view_invalidate(view);
         serial_write_string("ViewInterface: Default focus gained - marking for redraw\n");
     }
 }
@@ -178,7 +178,7 @@ void view_interface_default_on_focus_gained(View *view) {
 void view_interface_default_on_focus_lost(View *view) {
     /* Default: mark for redraw */
     if (view) {
-        view->needs_redraw = 1;
+        view_invalidate(view);
         serial_write_string("ViewInterface: Default focus lost - marking for redraw\n");
     }
 }
@@ -186,7 +186,7 @@ void view_interface_default_on_focus_lost(View *view) {
 void view_interface_default_on_visibility_changed(View *view, int visible) {
     /* Default: mark for redraw */
     if (view) {
-        view->needs_redraw = 1;
+        view_invalidate(view);
         if (visible) {
             serial_write_string("ViewInterface: Default visibility changed - now visible\n");
         } else {
@@ -198,7 +198,7 @@ void view_interface_default_on_visibility_changed(View *view, int visible) {
 void view_interface_default_on_enabled_changed(View *view, int enabled) {
     /* Default: mark for redraw */
     if (view) {
-        view->needs_redraw = 1;
+        view_invalidate(view);
         if (enabled) {
             serial_write_string("ViewInterface: Default enabled changed - now enabled\n");
         } else {